@@ -0,0 +1,23 @@
+/*********************************************************************
+ * board.h
+ *
+ * Stub KK2.1 board for the host build. Owns the fake register file,
+ * the EEPROM image and a register-level MPU6050 model that the
+ * unmodified I2C callers in gyros.c/acc.c read from.
+ ********************************************************************/
+
+#ifndef HOST_BOARD_H
+#define HOST_BOARD_H
+
+#include <stdint.h>
+
+//***********************************************************
+//* Externals
+//***********************************************************
+
+extern void board_init(void);
+extern void board_set_mpu6050(const int16_t acc[3], const int16_t gyro[3], int16_t temp);
+extern void board_advance(uint32_t t1_ticks);
+extern uint8_t *board_mpu6050_regs(void);
+
+#endif // HOST_BOARD_H
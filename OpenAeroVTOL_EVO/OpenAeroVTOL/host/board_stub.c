@@ -0,0 +1,248 @@
+//***********************************************************
+//* board_stub.c
+//*
+//* Stub KK2.1 board for the host build.
+//* Provides everything the flight core expects to find in
+//* init.c, isr.c, servos.c, i2c.c, twi_isr.c and the AVR runtime.
+//* With HOST_ISR defined the real isr.c is linked instead of
+//* the isr.c parts, so its interrupts can be called directly.
+//***********************************************************
+
+//***********************************************************
+//* Includes
+//***********************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/eeprom.h>
+#include "io_cfg.h"
+#include "MPU6050.h"
+#include "board.h"
+
+//************************************************************
+// Defines
+//************************************************************
+
+#define MPU6050_REGS	128				// Register file size
+#define T1_PER_T2		128				// 2.5MHz / 19.531kHz
+
+//************************************************************
+// AVR register file
+//************************************************************
+
+#define HOST_DEF8(name)		volatile uint8_t name;
+#define HOST_DEF16(name)	volatile uint16_t name;
+
+HOST_DEF8(SREG) HOST_DEF8(MCUSR)
+HOST_DEF8(PINA)	HOST_DEF8(DDRA)	HOST_DEF8(PORTA)
+HOST_DEF8(PINB)	HOST_DEF8(DDRB)	HOST_DEF8(PORTB)
+HOST_DEF8(PINC)	HOST_DEF8(DDRC)	HOST_DEF8(PORTC)
+HOST_DEF8(PIND)	HOST_DEF8(DDRD)	HOST_DEF8(PORTD)
+HOST_DEF8(TCCR0A) HOST_DEF8(TCCR0B) HOST_DEF8(TCNT0) HOST_DEF8(TIMSK0) HOST_DEF8(TIFR0)
+HOST_DEF8(TCCR1A) HOST_DEF8(TCCR1B) HOST_DEF16(TCNT1) HOST_DEF16(OCR1A) HOST_DEF16(OCR1B)
+HOST_DEF16(ICR1) HOST_DEF8(TIMSK1) HOST_DEF8(TIFR1)
+HOST_DEF8(TCCR2A) HOST_DEF8(TCCR2B) HOST_DEF8(TCNT2) HOST_DEF8(TIMSK2) HOST_DEF8(TIFR2)
+HOST_DEF8(GPIOR0) HOST_DEF8(GPIOR1) HOST_DEF8(GPIOR2)
+HOST_DEF8(EICRA) HOST_DEF8(EIMSK) HOST_DEF8(EIFR)
+HOST_DEF8(PCICR) HOST_DEF8(PCIFR) HOST_DEF8(PCMSK0) HOST_DEF8(PCMSK1)
+HOST_DEF8(PCMSK2) HOST_DEF8(PCMSK3)
+HOST_DEF8(UCSR0A) HOST_DEF8(UCSR0B) HOST_DEF8(UCSR0C) HOST_DEF8(UDR0)
+HOST_DEF16(UBRR0) HOST_DEF8(UBRR0H) HOST_DEF8(UBRR0L)
+HOST_DEF8(TWBR) HOST_DEF8(TWSR) HOST_DEF8(TWAR) HOST_DEF8(TWDR) HOST_DEF8(TWCR)
+HOST_DEF8(ADMUX) HOST_DEF8(ADCSRA) HOST_DEF8(ADCSRB) HOST_DEF16(ADCW) HOST_DEF8(DIDR0)
+HOST_DEF8(ACSR)
+
+extern void TIMER2_OVF_vect(void);			// ticks.c
+
+//************************************************************
+// Firmware globals normally owned by modules not in the host build
+//************************************************************
+
+CONFIG_STRUCT Config;							// init.c
+uint16_t SystemVoltage = 1200;					// init.c
+
+#ifndef HOST_ISR
+volatile uint16_t RxChannel[MAX_RC_CHANNELS];	// isr.c
+volatile uint16_t TMR0_counter = 0;				// isr.c
+volatile bool Interrupted = false;				// isr.c
+volatile uint16_t CPPM_capture;					// isr.c
+volatile bool CPPM_captured = false;
+volatile uint8_t CPPM_frames = 0;
+volatile bool JitterFlag = false;
+volatile bool JitterGate = false;
+#endif
+
+volatile uint16_t ServoOut[MAX_OUTPUTS];		// servos.c
+
+int16_t	transition_counter = 0;					// FC_main.c
+int16_t	transition = 0;
+volatile uint8_t Flight_flags = 0;
+volatile uint16_t LoopStartTCNT1 = 0;
+volatile bool Overdue = false;
+
+//************************************************************
+// Stub peripherals
+//************************************************************
+
+static uint8_t eeprom_image[E2END + 1];
+static uint8_t mpu6050[MPU6050_REGS];
+static uint8_t t2_fraction = 0;
+
+void board_init(void)
+{
+	memset(eeprom_image, 0xff, sizeof(eeprom_image));
+	memset(mpu6050, 0, sizeof(mpu6050));
+
+	PINB = 0xf0;								// All buttons released
+	PIND = 0x00;
+}
+
+// Load one sample into the MPU6050 data registers (big-endian, as the chip does)
+void board_set_mpu6050(const int16_t acc[3], const int16_t gyro[3], int16_t temp)
+{
+	uint8_t i;
+
+	for (i = 0; i < 3; i++)
+	{
+		mpu6050[MPU60X0_RA_ACCEL_XOUT_H + (i << 1)] = (uint8_t)((uint16_t)acc[i] >> 8);
+		mpu6050[MPU60X0_RA_ACCEL_XOUT_H + (i << 1) + 1] = (uint8_t)acc[i];
+		mpu6050[MPU60X0_RA_GYRO_XOUT_H + (i << 1)] = (uint8_t)((uint16_t)gyro[i] >> 8);
+		mpu6050[MPU60X0_RA_GYRO_XOUT_H + (i << 1) + 1] = (uint8_t)gyro[i];
+	}
+
+	mpu6050[MPU60X0_RA_TEMP_OUT_H] = (uint8_t)((uint16_t)temp >> 8);
+	mpu6050[MPU60X0_RA_TEMP_OUT_H + 1] = (uint8_t)temp;
+}
+
+uint8_t *board_mpu6050_regs(void)
+{
+	return mpu6050;
+}
+
+// Move the free-running timers on by a number of Timer1 ticks (400ns)
+void board_advance(uint32_t t1_ticks)
+{
+	uint32_t t2 = t1_ticks + t2_fraction;
+	uint32_t count = TCNT2 + (t2 / T1_PER_T2);
+	uint32_t overflows;
+
+	TCNT1 = (uint16_t)(TCNT1 + t1_ticks);
+	TCNT2 = (uint8_t)count;
+	t2_fraction = (uint8_t)(t2 % T1_PER_T2);
+
+	// Run the Timer2 overflow interrupt once for each wrap
+	for (overflows = (count >> 8); overflows > 0; overflows--)
+	{
+		TIMER2_OVF_vect();
+	}
+}
+
+//************************************************************
+// isr.c replacements
+//************************************************************
+
+#ifndef HOST_ISR
+uint16_t TIM16_ReadTCNT1(void)
+{
+	return TCNT1;
+}
+#endif
+
+//************************************************************
+// i2c.c replacements - register-level MPU6050 model
+//************************************************************
+
+bool writeI2Cbyte(uint8_t address, uint8_t location, uint8_t value)
+{
+	(void)address;
+	mpu6050[location & (MPU6050_REGS - 1)] = value;
+	return true;
+}
+
+void readI2CbyteArray(uint8_t address, uint8_t location, uint8_t *array, uint8_t size)
+{
+	uint8_t i;
+
+	(void)address;
+	for (i = 0; i < size; i++)
+	{
+		array[i] = mpu6050[(location + i) & (MPU6050_REGS - 1)];
+	}
+}
+
+//************************************************************
+// twi_isr.c replacements - transfers complete immediately
+//************************************************************
+
+bool twi_read(uint8_t address, uint8_t location, uint8_t *data, uint8_t size, volatile uint8_t *status)
+{
+	readI2CbyteArray(address, location, data, size);
+	*status = TWI_DONE;
+	return true;
+}
+
+bool twi_write(uint8_t address, uint8_t location, uint8_t *data, uint8_t size, volatile uint8_t *status)
+{
+	uint8_t i;
+
+	for (i = 0; i < size; i++)
+	{
+		writeI2Cbyte(address, location + i, data[i]);
+	}
+	*status = TWI_DONE;
+	return true;
+}
+
+bool twi_wait(volatile uint8_t *status)
+{
+	return (status == NULL) || (*status == TWI_DONE);
+}
+
+void twi_flush(void)
+{
+}
+
+//************************************************************
+// avr-libc EEPROM replacements
+//************************************************************
+
+uint8_t eeprom_read_byte(const uint8_t *addr)
+{
+	return eeprom_image[(uintptr_t)addr & E2END];
+}
+
+void eeprom_write_byte(uint8_t *addr, uint8_t value)
+{
+	eeprom_image[(uintptr_t)addr & E2END] = value;
+}
+
+void eeprom_read_block(void *dest, const void *src, size_t size)
+{
+	size_t i;
+
+	for (i = 0; i < size; i++)
+	{
+		((uint8_t*)dest)[i] = eeprom_image[((uintptr_t)src + i) & E2END];
+	}
+}
+
+void eeprom_write_block(const void *src, void *dest, size_t size)
+{
+	size_t i;
+
+	for (i = 0; i < size; i++)
+	{
+		eeprom_image[((uintptr_t)dest + i) & E2END] = ((const uint8_t*)src)[i];
+	}
+}
+
+//************************************************************
+// Misc
+//************************************************************
+
+void menu_beep(uint8_t beeps)
+{
+	(void)beeps;
+}
@@ -0,0 +1,21 @@
+/*********************************************************************
+ * avr/eeprom.h - host build
+ *
+ * EEPROM accesses land in a RAM image owned by the stub board.
+ * Addresses are byte offsets into that image, exactly as on target.
+ ********************************************************************/
+
+#ifndef HOST_AVR_EEPROM_H
+#define HOST_AVR_EEPROM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define E2END 0x7FF
+
+extern uint8_t	eeprom_read_byte(const uint8_t *addr);
+extern void		eeprom_write_byte(uint8_t *addr, uint8_t value);
+extern void		eeprom_read_block(void *dest, const void *src, size_t size);
+extern void		eeprom_write_block(const void *src, void *dest, size_t size);
+
+#endif // HOST_AVR_EEPROM_H
@@ -0,0 +1,18 @@
+/*********************************************************************
+ * avr/interrupt.h - host build
+ *
+ * There is no interrupt controller on the host. cli()/sei() are
+ * no-ops and ISR() bodies become ordinary functions the stub board
+ * can call to inject events.
+ ********************************************************************/
+
+#ifndef HOST_AVR_INTERRUPT_H
+#define HOST_AVR_INTERRUPT_H
+
+#include <avr/io.h>
+
+#define cli()
+#define sei()
+#define ISR(vector, ...)	void vector(void); void vector(void)
+
+#endif // HOST_AVR_INTERRUPT_H
@@ -0,0 +1,127 @@
+/*********************************************************************
+ * avr/io.h - host build
+ *
+ * Stand-in for the AVR register file when the flight core is built
+ * off-target. Each I/O register the firmware touches becomes a plain
+ * volatile variable owned by the stub board (host/board_stub.c),
+ * so code like "TCNT1 = 0" or REGISTER_BIT(PINB,4) compiles and can
+ * be driven or inspected from the host side.
+ ********************************************************************/
+
+#ifndef HOST_AVR_IO_H
+#define HOST_AVR_IO_H
+
+#include <stdint.h>
+
+#define _BV(bit) (1 << (bit))
+
+#define HOST_REG8(name)	extern volatile uint8_t name;
+#define HOST_REG16(name) extern volatile uint16_t name;
+
+// Core
+HOST_REG8(SREG) HOST_REG8(MCUSR)
+
+// GPIO
+HOST_REG8(PINA)	HOST_REG8(DDRA)	HOST_REG8(PORTA)
+HOST_REG8(PINB)	HOST_REG8(DDRB)	HOST_REG8(PORTB)
+HOST_REG8(PINC)	HOST_REG8(DDRC)	HOST_REG8(PORTC)
+HOST_REG8(PIND)	HOST_REG8(DDRD)	HOST_REG8(PORTD)
+
+// Timers
+HOST_REG8(TCCR0A) HOST_REG8(TCCR0B) HOST_REG8(TCNT0) HOST_REG8(TIMSK0) HOST_REG8(TIFR0)
+HOST_REG8(TCCR1A) HOST_REG8(TCCR1B) HOST_REG16(TCNT1) HOST_REG16(OCR1A) HOST_REG16(OCR1B)
+HOST_REG16(ICR1) HOST_REG8(TIMSK1) HOST_REG8(TIFR1)
+HOST_REG8(TCCR2A) HOST_REG8(TCCR2B) HOST_REG8(TCNT2) HOST_REG8(TIMSK2) HOST_REG8(TIFR2)
+HOST_REG8(GPIOR0) HOST_REG8(GPIOR1) HOST_REG8(GPIOR2)
+
+// External interrupts
+HOST_REG8(EICRA) HOST_REG8(EIMSK) HOST_REG8(EIFR)
+HOST_REG8(PCICR) HOST_REG8(PCIFR) HOST_REG8(PCMSK0) HOST_REG8(PCMSK1)
+HOST_REG8(PCMSK2) HOST_REG8(PCMSK3)
+
+// USART0
+HOST_REG8(UCSR0A) HOST_REG8(UCSR0B) HOST_REG8(UCSR0C) HOST_REG8(UDR0)
+HOST_REG16(UBRR0) HOST_REG8(UBRR0H) HOST_REG8(UBRR0L)
+
+// TWI
+HOST_REG8(TWBR) HOST_REG8(TWSR) HOST_REG8(TWAR) HOST_REG8(TWDR) HOST_REG8(TWCR)
+
+// ADC
+HOST_REG8(ADMUX) HOST_REG8(ADCSRA) HOST_REG8(ADCSRB) HOST_REG16(ADCW) HOST_REG8(DIDR0)
+
+// Analog comparator
+HOST_REG8(ACSR)
+
+// Bit positions used by the firmware sources
+#define	SREG_I	7
+#define	TOIE0	0
+#define	TOIE1	0
+#define	OCIE1A	1
+#define	OCIE1B	2
+#define	ICIE1	5
+#define	OCF1A	1
+#define	ICF1	5
+#define	TOIE2	0
+#define	TOV2	0
+#define	INT0	0
+#define	INT1	1
+#define	INT2	2
+#define	INTF2	2
+#define	PCIE0	0
+#define	PCIE1	1
+#define	PCIE2	2
+#define	PCIE3	3
+#define	RXC0	7
+#define	TXC0	6
+#define	UDRE0	5
+#define	FE0		4
+#define	DOR0	3
+#define	UPE0	2
+#define	U2X0	1
+#define	RXCIE0	7
+#define	RXEN0	4
+#define	TXEN0	3
+#define	UCSZ01	2
+#define	UCSZ00	1
+#define	UPM01	5
+#define	UPM00	4
+#define	USBS0	3
+#define	TWINT	7
+#define	TWEA	6
+#define	TWSTA	5
+#define	TWSTO	4
+#define	TWEN	2
+#define	TWIE	0
+#define	ADEN	7
+#define	ADSC	6
+#define	ADIF	4
+#define	ACIC	2
+#define	ACME	6
+#define	ADPS1	1
+#define	ADPS2	2
+#define	ADTS2	2
+#define	ADC0D	0
+#define	ADC1D	1
+#define	ADC2D	2
+#define	ADC3D	3
+#define	ADC4D	4
+#define	ADC5D	5
+#define	ADC6D	6
+#define	ADC7D	7
+#define	CS10	0
+#define	CS11	1
+#define	CS12	2
+#define	ICES1	6
+#define	ICNC1	7
+#define	PCIF0	0
+#define	PCIF1	1
+#define	PCIF2	2
+#define	PCIF3	3
+#define	PCINT8	0
+#define	PCINT15	7
+#define	PCINT24	0
+#define	PCINT31	7
+#define	PB0		0
+#define	PD0		0
+
+#endif // HOST_AVR_IO_H
@@ -0,0 +1,27 @@
+/*********************************************************************
+ * avr/pgmspace.h - host build
+ *
+ * The host has a single address space, so program-memory tables are
+ * ordinary const data and the pgm_read helpers are plain loads.
+ ********************************************************************/
+
+#ifndef HOST_AVR_PGMSPACE_H
+#define HOST_AVR_PGMSPACE_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P						const char *
+#define PSTR(s)						(s)
+
+#define pgm_read_byte(addr)			(*(const uint8_t *)(addr))
+#define pgm_read_word(addr)			(*(const uint16_t *)(addr))
+#define pgm_read_dword(addr)		(*(const uint32_t *)(addr))
+#define pgm_read_float(addr)		(*(const float *)(addr))
+
+#define memcpy_P(dest, src, n)		memcpy((dest), (src), (n))
+#define strcpy_P(dest, src)			strcpy((dest), (src))
+#define strlen_P(src)				strlen(src)
+
+#endif // HOST_AVR_PGMSPACE_H
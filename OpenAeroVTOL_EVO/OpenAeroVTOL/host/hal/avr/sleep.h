@@ -0,0 +1,17 @@
+/*********************************************************************
+ * avr/sleep.h - host build
+ ********************************************************************/
+
+#ifndef HOST_AVR_SLEEP_H
+#define HOST_AVR_SLEEP_H
+
+#define SLEEP_MODE_IDLE			0
+#define SLEEP_MODE_PWR_DOWN		2
+
+#define set_sleep_mode(mode)	((void)(mode))
+#define sleep_enable()
+#define sleep_disable()
+#define sleep_cpu()
+#define sleep_mode()
+
+#endif // HOST_AVR_SLEEP_H
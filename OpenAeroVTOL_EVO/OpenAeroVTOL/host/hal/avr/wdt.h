@@ -0,0 +1,15 @@
+/*********************************************************************
+ * avr/wdt.h - host build
+ ********************************************************************/
+
+#ifndef HOST_AVR_WDT_H
+#define HOST_AVR_WDT_H
+
+#define WDTO_15MS			0
+#define WDTO_2S				7
+
+#define wdt_enable(timeout)	((void)(timeout))
+#define wdt_disable()
+#define wdt_reset()
+
+#endif // HOST_AVR_WDT_H
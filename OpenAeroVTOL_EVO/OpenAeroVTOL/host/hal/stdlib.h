@@ -0,0 +1,17 @@
+/*********************************************************************
+ * stdlib.h - host build
+ *
+ * The system header plus the avr-libc conversion extensions the
+ * LCD code relies on.
+ ********************************************************************/
+
+#ifndef HOST_STDLIB_H
+#define HOST_STDLIB_H
+
+#include_next <stdlib.h>
+
+extern char *itoa(int value, char *string, int radix);
+extern char *ltoa(long value, char *string, int radix);
+extern char *utoa(unsigned int value, char *string, int radix);
+
+#endif // HOST_STDLIB_H
@@ -0,0 +1,14 @@
+/*********************************************************************
+ * util/delay.h - host build
+ *
+ * Busy-wait delays are meaningless off-target and would only distort
+ * the replay timings, so they compile away.
+ ********************************************************************/
+
+#ifndef HOST_UTIL_DELAY_H
+#define HOST_UTIL_DELAY_H
+
+#define _delay_ms(ms)	((void)(ms))
+#define _delay_us(us)	((void)(us))
+
+#endif // HOST_UTIL_DELAY_H
@@ -0,0 +1,698 @@
+//***********************************************************
+//* legacy_mixer.c
+//*
+//* Reference copy of ProcessMixer() as it was before the mixer
+//* terms, offset curves and transition gains were precalculated
+//* (percentages scaled with scale32() and a divide by 100).
+//* Used by mixer_compat.c only; not part of the firmware.
+//*
+//* Built with LEGACY_EXACT it becomes exact_ProcessMixer(),
+//* which does the same sums in double with no rounding after
+//* each percentage, leaving the results in legacy_exact[].
+//***********************************************************
+
+//***********************************************************
+//* Includes
+//***********************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <avr/pgmspace.h>
+#include "io_cfg.h"
+#include "main.h"
+#include "rc.h"
+#include "pid.h"
+#include "imu.h"
+#include "mixer.h"
+
+//************************************************************
+// Defines
+//************************************************************
+
+#define MIX_OUTPUTS 8
+#define EXT_SOURCE 8	// Offset for indexing sensor sources
+
+#ifdef LEGACY_EXACT
+typedef double mix_t;
+#define scale32(value, pct) ((double)(value) * (pct) / 100.0)
+#define legacy_ProcessMixer exact_ProcessMixer
+#define P1_VALUE(i) legacy_exact[P1][i]
+#define P2_VALUE(i) legacy_exact[P2][i]
+#else
+typedef int16_t mix_t;
+#define P1_VALUE(i) Config.Channel[i].P1_value
+#define P2_VALUE(i) Config.Channel[i].P2_value
+#endif
+
+extern const int8_t SIN[101] PROGMEM;
+extern const int8_t SQRTSIN[101] PROGMEM;
+
+//************************************************************
+// Code
+//************************************************************
+
+#ifdef LEGACY_EXACT
+double legacy_exact[FLIGHT_MODES][MIX_OUTPUTS];
+#endif
+
+void legacy_ProcessMixer(void)
+{
+	uint8_t i = 0;
+	uint8_t j = 0;
+	mix_t P1_solution = 0;
+	mix_t P2_solution = 0;
+	mix_t term = 0;
+
+	int16_t temp1 = 0;
+	int16_t temp2 = 0;
+	int16_t	temp3 = 0;
+	int16_t	Step1 = 0;
+	int16_t	Step2 = 0;
+	int8_t	itemp8 = 0;
+
+	// Copy the sensor data to an array for easy indexing - acc data is from accSmooth, increased to reasonable rates
+	temp1 = (int16_t)accSmooth[ROLL] << 3;
+	temp2 = (int16_t)accSmooth[PITCH] << 3;
+	int16_t	SensorDataP1[7] = {PID_Gyros[P1][ROLL], PID_Gyros[P1][PITCH], PID_Gyros[P1][YAW], temp1, temp2, PID_ACCs[P1][ROLL], PID_ACCs[P1][PITCH]};
+	int16_t	SensorDataP2[7] = {PID_Gyros[P2][ROLL], PID_Gyros[P2][PITCH], PID_Gyros[P2][YAW], temp1, temp2, PID_ACCs[P2][ROLL], PID_ACCs[P2][PITCH]}; 
+
+	//************************************************************
+	// Main mix loop - sensors, RC inputs and other channels
+	//************************************************************
+
+	for (i = 0; i < MIX_OUTPUTS; i++)
+	{
+		//************************************************************
+		// Zero each channel value to start
+		//************************************************************
+
+		P1_solution = 0;
+		P2_solution = 0;
+
+		//************************************************************
+		// Mix in gyros
+		//************************************************************ 
+
+		// P1 gyros
+		if (transition < 100)
+		{
+			switch (Config.Channel[i].P1_Roll_gyro) 
+			{
+				case OFF:
+					break;
+				case ON:
+					if (Config.Channel[i].P1_aileron_volume < 0 )
+					{
+						P1_solution = P1_solution + PID_Gyros[P1][ROLL];		// Reverse if volume negative
+					}
+					else
+					{
+						P1_solution = P1_solution - PID_Gyros[P1][ROLL];
+					}
+					break;
+				case SCALE:
+					P1_solution = P1_solution - scale32(PID_Gyros[P1][ROLL], Config.Channel[i].P1_aileron_volume * 5); 
+					break;
+				default:
+					break;	
+			}
+
+			switch (Config.Channel[i].P1_Pitch_gyro)
+			{
+				case OFF:
+					break;
+				case ON:
+					if (Config.Channel[i].P1_elevator_volume < 0 )
+					{
+						P1_solution = P1_solution - PID_Gyros[P1][PITCH];		// Reverse if volume negative
+					}
+					else
+					{
+						P1_solution = P1_solution + PID_Gyros[P1][PITCH];
+					}
+					break;
+				case SCALE:
+					P1_solution = P1_solution + scale32(PID_Gyros[P1][PITCH], Config.Channel[i].P1_elevator_volume * 5);
+					break;
+				default:
+					break;
+			}
+
+			switch (Config.Channel[i].P1_Yaw_gyro)
+			{
+				case OFF:
+					break;
+				case ON:
+					if (Config.Channel[i].P1_rudder_volume < 0 )
+					{
+						P1_solution = P1_solution - PID_Gyros[P1][YAW];			// Reverse if volume negative
+					}
+					else
+					{
+						P1_solution = P1_solution + PID_Gyros[P1][YAW];
+					}
+					break;
+				case SCALE:
+					P1_solution = P1_solution + scale32(PID_Gyros[P1][YAW], Config.Channel[i].P1_rudder_volume * 5);
+					break;
+				default:
+					break;
+			}
+		}
+
+		// P2 gyros
+		if (transition > 0)
+		{
+			switch (Config.Channel[i].P2_Roll_gyro)
+			{
+				case OFF:
+					break;
+				case ON:
+					if (Config.Channel[i].P2_aileron_volume < 0 )
+					{
+						P2_solution = P2_solution + PID_Gyros[P2][ROLL];		// Reverse if volume negative
+					}
+					else
+					{
+						P2_solution = P2_solution - PID_Gyros[P2][ROLL];
+					}
+					break;
+				case SCALE:
+					P2_solution = P2_solution - scale32(PID_Gyros[P2][ROLL], Config.Channel[i].P2_aileron_volume * 5);
+					break;
+				default:
+					break;
+			}
+
+			switch (Config.Channel[i].P2_Pitch_gyro)
+			{
+				case OFF:
+					break;
+				case ON:
+					if (Config.Channel[i].P2_elevator_volume < 0 )
+					{
+						P2_solution = P2_solution - PID_Gyros[P2][PITCH];		// Reverse if volume negative
+					}
+					else
+					{
+						P2_solution = P2_solution + PID_Gyros[P2][PITCH];
+					}
+					break;
+				case SCALE:
+					P2_solution = P2_solution + scale32(PID_Gyros[P2][PITCH], Config.Channel[i].P2_elevator_volume * 5);
+					break;
+				default:
+					break;
+			}
+
+			switch (Config.Channel[i].P2_Yaw_gyro)
+			{
+				case OFF:
+					break;
+				case ON:
+					if (Config.Channel[i].P2_rudder_volume < 0 )
+					{
+						P2_solution = P2_solution - PID_Gyros[P2][YAW];			// Reverse if volume negative
+					}
+					else
+					{
+						P2_solution = P2_solution + PID_Gyros[P2][YAW];
+					}
+					break;
+				case SCALE:
+					P2_solution = P2_solution + scale32(PID_Gyros[P2][YAW], Config.Channel[i].P2_rudder_volume * 5);
+					break;
+				default:
+					break;
+			}
+		}
+
+		//************************************************************
+		// Mix in accelerometers
+		//************************************************************ 
+		// P1
+		if (transition < 100)
+		{
+			switch (Config.Channel[i].P1_Roll_acc)
+			{
+				case OFF:
+					break;
+				case ON:
+					if (Config.Channel[i].P1_aileron_volume < 0 )
+					{
+						P1_solution = P1_solution + PID_ACCs[P1][ROLL];			// Reverse if volume negative
+					}
+					else
+					{
+						P1_solution = P1_solution - PID_ACCs[P1][ROLL];			// or simply add
+					}
+					break;
+				case SCALE:
+					P1_solution = P1_solution - scale32(PID_ACCs[P1][ROLL], Config.Channel[i].P1_aileron_volume * 5);
+					break;
+				default:
+					break;
+			}			
+
+			switch (Config.Channel[i].P1_Pitch_acc)
+			{
+				case OFF:
+					break;
+				case ON:
+					if (Config.Channel[i].P1_elevator_volume < 0 )
+					{
+						P1_solution = P1_solution - PID_ACCs[P1][PITCH];		// Reverse if volume negative
+					}
+					else
+					{
+						P1_solution = P1_solution + PID_ACCs[P1][PITCH];
+					}
+					break;
+				case SCALE:
+					P1_solution = P1_solution + scale32(PID_ACCs[P1][PITCH], Config.Channel[i].P1_elevator_volume * 5);
+					break;
+				default:
+					break;
+			}
+
+			switch (Config.Channel[i].P1_Z_delta_acc)
+			{
+				case OFF:
+					break;
+				case ON:
+					if (Config.Channel[i].P1_throttle_volume < 0 )
+					{
+						P1_solution = P1_solution + PID_ACCs[P1][YAW];			// Reverse if volume negative
+					}
+					else
+					{
+						P1_solution = P1_solution - PID_ACCs[P1][YAW];
+					}
+					break;
+				case SCALE:
+					P1_solution = P1_solution - scale32(PID_ACCs[P1][YAW], Config.Channel[i].P1_throttle_volume * 5);
+					break;
+				default:
+					break;
+			}
+		}
+
+		// P2
+		if (transition > 0)
+		{
+			switch (Config.Channel[i].P2_Roll_acc)
+			{
+				case OFF:
+					break;
+				case ON:
+					if (Config.Channel[i].P2_aileron_volume < 0 )
+					{
+						P2_solution = P2_solution + PID_ACCs[P2][ROLL];			// Reverse if volume negative
+					}
+					else
+					{
+						P2_solution = P2_solution - PID_ACCs[P2][ROLL];			// or simply add
+					}
+					break;
+				case SCALE:
+					P2_solution = P2_solution - scale32(PID_ACCs[P2][ROLL], Config.Channel[i].P2_aileron_volume * 5);
+					break;
+				default:
+					break;
+			}
+
+			switch (Config.Channel[i].P2_Pitch_acc)
+			{
+				case OFF:
+					break;
+				case ON:
+					if (Config.Channel[i].P2_elevator_volume < 0 )
+					{
+
+						P2_solution = P2_solution - PID_ACCs[P2][PITCH];		// Reverse if volume negative
+					}
+					else
+					{
+						P2_solution = P2_solution + PID_ACCs[P2][PITCH];
+					}
+					break;
+				case SCALE:
+					P2_solution = P2_solution + scale32(PID_ACCs[P2][PITCH], Config.Channel[i].P2_elevator_volume * 5);
+					break;
+				default:
+					break;
+			}
+
+			switch (Config.Channel[i].P2_Z_delta_acc)
+			{
+				case OFF:
+					break;
+				case ON:
+					if (Config.Channel[i].P2_throttle_volume < 0 )
+					{
+						P2_solution = P2_solution + PID_ACCs[P2][YAW];			// Reverse if volume negative
+					}
+					else
+					{
+						P2_solution = P2_solution - PID_ACCs[P2][YAW];
+					}
+					break;
+				case SCALE:
+					P2_solution = P2_solution - scale32(PID_ACCs[P2][YAW], Config.Channel[i].P2_throttle_volume * 5);
+					break;
+				default:
+					break;
+			}
+		}
+
+		//************************************************************
+		// Process mixers
+		//************************************************************ 
+
+		// Mix in other outputs here (P1)
+		if (transition < 100)
+		{
+			// Mix in dedicated RC sources - aileron, elevator and rudder
+			if (Config.Channel[i].P1_aileron_volume != 0) 					// Mix in dedicated aileron
+			{
+				term = scale32(RCinputs[AILERON], Config.Channel[i].P1_aileron_volume);
+				P1_solution = P1_solution + term;
+			}
+			if (Config.Channel[i].P1_elevator_volume != 0) 					// Mix in dedicated elevator
+			{
+				term = scale32(RCinputs[ELEVATOR], Config.Channel[i].P1_elevator_volume);
+				P1_solution = P1_solution + term;
+			}
+			if (Config.Channel[i].P1_rudder_volume != 0) 					// Mix in dedicated rudder
+			{
+				term = scale32(RCinputs[RUDDER], Config.Channel[i].P1_rudder_volume);
+				P1_solution = P1_solution + term;
+			}
+
+			// Other sources
+			if ((Config.Channel[i].P1_source_a_volume != 0) && (Config.Channel[i].P1_source_a != NOMIX)) // Mix in first extra source
+			{
+				// Is the source a sensor?
+				if (Config.Channel[i].P1_source_a > (MAX_RC_CHANNELS - 1))
+				{
+					temp2 = SensorDataP1[Config.Channel[i].P1_source_a - EXT_SOURCE];
+				}
+				// Is the source an RC input?
+				else
+				{
+					// Yes, calculate RC channel number from source number and return RC value
+					temp2 = RCinputs[Config.Channel[i].P1_source_a];
+				}
+
+				term = scale32(temp2, Config.Channel[i].P1_source_a_volume);
+				P1_solution = P1_solution + term;
+			}
+			if ((Config.Channel[i].P1_source_b_volume != 0) && (Config.Channel[i].P1_source_b != NOMIX)) // Mix in second extra source
+			{
+				// Is the source a sensor?
+				if (Config.Channel[i].P1_source_b > (MAX_RC_CHANNELS - 1))
+				{
+					temp2 = SensorDataP1[Config.Channel[i].P1_source_b - EXT_SOURCE];
+				}
+				// Is the source an RC input?
+				else
+				{
+					temp2 = RCinputs[Config.Channel[i].P1_source_b];
+				}
+
+				term = scale32(temp2, Config.Channel[i].P1_source_b_volume);
+				P1_solution = P1_solution + term;
+			}
+		}
+
+		// Mix in other outputs here (P2)
+		if (transition > 0)	
+		{
+			// Mix in dedicated RC sources - aileron, elevator and rudder
+			if (Config.Channel[i].P2_aileron_volume != 0) 					// Mix in dedicated aileron
+			{
+				term = scale32(RCinputs[AILERON], Config.Channel[i].P2_aileron_volume);
+				P2_solution = P2_solution + term;
+			}
+			if (Config.Channel[i].P2_elevator_volume != 0) 					// Mix in dedicated elevator
+			{
+				term = scale32(RCinputs[ELEVATOR], Config.Channel[i].P2_elevator_volume);
+				P2_solution = P2_solution + term;
+			}
+			if (Config.Channel[i].P2_rudder_volume != 0) 					// Mix in dedicated rudder
+			{
+				term = scale32(RCinputs[RUDDER], Config.Channel[i].P2_rudder_volume);
+				P2_solution = P2_solution + term;
+			}
+
+			// Other sources
+			if ((Config.Channel[i].P2_source_a_volume != 0) && (Config.Channel[i].P2_source_a != NOMIX)) // Mix in first extra source
+			{
+				// Is the source a sensor?
+				if (Config.Channel[i].P2_source_a > (MAX_RC_CHANNELS - 1))
+				{
+					temp2 = SensorDataP2[Config.Channel[i].P2_source_a - EXT_SOURCE];
+				}
+				// Is the source an RC input?
+				else 
+				{
+					temp2 = RCinputs[Config.Channel[i].P2_source_a];
+				}
+
+				term = scale32(temp2, Config.Channel[i].P2_source_a_volume);
+				P2_solution = P2_solution + term;
+			}
+			if ((Config.Channel[i].P2_source_b_volume != 0) && (Config.Channel[i].P2_source_b != NOMIX)) // Mix in second extra source
+			{
+				// Is the source a sensor?
+				if (Config.Channel[i].P2_source_b > (MAX_RC_CHANNELS - 1))
+				{
+					temp2 = SensorDataP2[Config.Channel[i].P2_source_b - EXT_SOURCE];
+				}
+				// Is the source an RC input?
+				else
+				{
+					temp2 = RCinputs[Config.Channel[i].P2_source_b];
+				}
+
+				term = scale32(temp2, Config.Channel[i].P2_source_b_volume);
+				P2_solution = P2_solution + term;
+			}
+		}
+			
+		// Save solution for this channel. Note that this contains cross-mixed data from the *last* cycle
+		P1_VALUE(i) = P1_solution;
+		P2_VALUE(i) = P2_solution;
+
+	} // Mixer loop: for (i = 0; i < MIX_OUTPUTS; i++)
+
+	//************************************************************
+	// Mixer transition code
+	//************************************************************ 
+
+	// Convert number to percentage (0 to 100%)
+	if (Config.TransitionSpeed != 0) 
+	{
+		// transition_counter counts from 0 to 100 (101 steps)
+		transition = transition_counter;
+	}
+
+	// Recalculate P1 values based on transition stage
+	for (i = 0; i < MIX_OUTPUTS; i++)
+	{
+		// Speed up the easy ones :)
+		if (transition == 0)
+		{
+			P1_solution = P1_VALUE(i);
+		}
+		else if (transition >= 100)
+		{
+			P1_solution = P2_VALUE(i);
+		}
+		else
+		{
+			// Get source channel value
+			P1_solution = P1_VALUE(i);
+			P1_solution = scale32(P1_solution, (100 - transition));
+
+			// Get destination channel value
+			P2_solution = P2_VALUE(i);
+			P2_solution = scale32(P2_solution, transition);
+
+			// Sum the mixers
+			P1_solution = P1_solution + P2_solution;
+		}
+		// Save transitioned solution into P1
+		P1_VALUE(i) = P1_solution;
+	}  
+
+	//************************************************************
+	// Groovy throttle curve handling. Must be after the transition.
+	// Uses the transition value, but is not part of the transition
+	// mixer. Linear or Sine curve. Reverse Sine done automatically
+	//************************************************************ 
+
+	for (i = 0; i < MIX_OUTPUTS; i++)
+	{
+		// Ignore if both throttle volumes are 0% (no throttle)
+		if 	(!((Config.Channel[i].P1_throttle_volume == 0) && 
+			(Config.Channel[i].P2_throttle_volume == 0)))
+		{
+			// Only process if there is a curve
+			if (Config.Channel[i].P1_throttle_volume != Config.Channel[i].P2_throttle_volume)
+			{
+				// Calculate step difference in 1/100ths and round
+				temp1 = (Config.Channel[i].P2_throttle_volume - Config.Channel[i].P1_throttle_volume);
+				temp1 = temp1 << 7; 						// Multiply by 128 so divide gives reasonable step values
+				Step1 = temp1 / 100;	
+
+				// Set start (P1) point
+				temp2 = Config.Channel[i].P1_throttle_volume; // Promote to 16 bits
+				temp2 = temp2 << 7;
+
+				// Linear vs. Sinusoidal calculation
+				if (Config.Channel[i].Throttle_curve == LINEAR)
+				{
+					// Multiply [transition] steps (0 to 100)
+					temp3 = temp2 + (Step1 * transition);
+				}
+
+				// SINE
+				else if (Config.Channel[i].Throttle_curve == SINE)
+				{
+					// Choose between SINE and COSINE
+					// If P2 less than P1, COSINE (reverse SINE) is the one we want
+					if (Step1 < 0)
+					{ 
+						// Multiply SIN[100 - transition] steps (0 to 100)
+						temp3 = 100 - (int8_t)pgm_read_byte(&SIN[100 - (int8_t)transition]);
+					}
+					// If P2 greater than P1, SINE is the one we want
+					else
+					{
+						// Multiply SIN[transition] steps (0 to 100)
+						temp3 = (int8_t)pgm_read_byte(&SIN[(int8_t)transition]);
+					}
+
+					// Get SINE% (temp2) of difference in volumes (Step1)
+					// Step1 is already in 100ths of the difference * 128
+					// temp1 is the start volume * 128
+					temp3 = temp2 + (Step1 * temp3);
+				}
+				// SQRT SINE
+				else
+				{
+					// Choose between SQRT SINE and SQRT COSINE
+					// If P2 less than P1, COSINE (reverse SINE) is the one we want
+					if (Step1 < 0)
+					{ 
+						// Multiply SQRTSIN[100 - transition] steps (0 to 100)
+						temp3 = 100 - (int8_t)pgm_read_byte(&SQRTSIN[100 - (int8_t)transition]);
+					}
+					// If P2 greater than P1, SINE is the one we want
+					else
+					{
+						// Multiply SQRTSIN[transition] steps (0 to 100)
+						temp3 = (int8_t)pgm_read_byte(&SQRTSIN[(int8_t)transition]);
+					}
+
+					// Get SINE% (temp2) of difference in volumes (Step1)
+					// Step1 is already in 100ths of the difference * 128
+					// temp1 is the start volume * 128
+					temp3 = temp2 + (Step1 * temp3);
+				}
+
+				// Round, then rescale to normal value
+				temp3 = temp3 + 64;
+				temp3 = temp3 >> 7;
+			}
+			
+			// No curve
+			else
+			{
+				// Just use the value of P1 volume as there is no curve
+				temp3 = Config.Channel[i].P1_throttle_volume; // Promote to 16 bits
+			}
+
+			// Calculate actual throttle value to the curve
+			term = scale32(MonopolarThrottle, temp3);
+
+			// At this point, the throttle values are 0 to 2500 (+/-150%)
+			// Re-scale throttle values back to neutral-centered system values (+/-1250) 
+			// and set the minimum throttle point to 1.1ms.
+			// A THROTTLEMIN value of 1000 will result in 2750, or 1.1ms
+			term = term - THROTTLEMIN;
+
+			// Add offset to channel value
+			P1_VALUE(i) += term;
+
+		} // No throttle
+		
+		// No throttles, so clamp to THROTTLEMIN if flagged as a motor
+		else if (Config.Channel[i].Motor_marker == MOTOR)
+		{
+			P1_VALUE(i) = -THROTTLEOFFSET; // 3750-1250 = 2500 = 1.0ms
+		}
+	}
+
+	//************************************************************
+	// Per-channel 3-point offset needs to be after the transition  
+	// loop as it is non-linear, unlike the transition.
+	//************************************************************ 
+
+	for (i = 0; i < MIX_OUTPUTS; i++)
+	{
+		// Simplify if all are the same
+		if (!((Config.Channel[i].P1_offset == Config.Channel[i].P1n_offset) &&
+		 	 (Config.Channel[i].P2_offset == Config.Channel[i].P1n_offset)))
+		{
+			// Work out distance to cover over stage 1 (P1 to P1.n)
+			temp1 = Config.Channel[i].P1n_offset - Config.Channel[i].P1_offset;
+			temp1 = temp1 << 7; // Multiply by 128 so divide gives reasonable step values
+
+			// Divide distance into steps
+			temp2 = Config.Channel[i].P1n_position; 
+			Step1 = ((temp1 + (temp2 >> 1)) / temp2) ; // Divide and round result
+		
+			// Work out distance to cover over stage 2 (P1.n to P2)
+			temp2 = Config.Channel[i].P2_offset - Config.Channel[i].P1n_offset;
+			temp2 = temp2 << 7;
+
+			// Divide distance into steps
+			temp1 = (100 - Config.Channel[i].P1n_position); 
+			Step2 = ((temp2 + (temp1 >> 1)) / temp1) ; // Divide and round result	
+
+			// Set start (P1) point
+			temp3 = Config.Channel[i].P1_offset; // Promote to 16bits
+			temp3 = temp3 << 7;
+
+			// Count up transition steps of the appropriate step size
+			for (j = 0; j < transition; j++)
+			{
+				// If in stage 1 use Step1 size
+				if (j < Config.Channel[i].P1n_position)
+				{
+					temp3 += Step1;
+				}
+				// If in stage 2 use Step2 size
+				else
+				{
+					temp3 += Step2;
+				}
+			}
+
+			// Reformat into a system-compatible value
+			itemp8 = (int8_t)((temp3 + 64) >> 7);							// Round then divide by 128
+			P1_solution = scale_percent_nooffset(itemp8);	
+
+		} // No curve, so just use one point for offset
+		else
+		{
+			P1_solution = scale_percent_nooffset(Config.Channel[i].P1_offset);
+		}
+
+		// Add offset to channel value
+		P1_VALUE(i) += P1_solution;
+	}
+
+} // legacy_ProcessMixer()
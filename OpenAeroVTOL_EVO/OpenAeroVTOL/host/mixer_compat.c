@@ -0,0 +1,236 @@
+//***********************************************************
+//* mixer_compat.c
+//*
+//* Compatibility check between ProcessMixer() and the reference
+//* copy in legacy_mixer.c.
+//*
+//* Each case starts from a mixer preset, randomises the volumes,
+//* sensor settings, offsets and throttle curves of every channel
+//* within the menu ranges, then runs both mixers on the same
+//* random RC/sensor inputs and transition value. Reports the
+//* largest difference in ServoOut[] and in the unclamped channel
+//* values. Exits non-zero if any ServoOut[] differs by more than
+//* the tolerance.
+//*
+//* The reference is the legacy mixer built with LEGACY_EXACT,
+//* rounded to whole counts only at the end. The integer legacy
+//* mixer rounds each scale32() term on its own, truncating the
+//* negative ones towards zero, so it drifts several counts from
+//* the exact sum on busy mixes. Its difference is reported too,
+//* but not checked.
+//*
+//* With -p the preset mixes are kept as loaded and only the
+//* throttle curves, offsets and inputs are randomised.
+//***********************************************************
+
+//***********************************************************
+//* Includes
+//***********************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <avr/pgmspace.h>
+#include "io_cfg.h"
+#include "main.h"
+#include "rc.h"
+#include "pid.h"
+#include "imu.h"
+#include "mixer.h"
+#include "servos.h"
+#include "eeprom.h"
+#include "board.h"
+
+//************************************************************
+// Defines
+//************************************************************
+
+#define DEFAULT_CASES	100000
+#define TOLERANCE		1				// Servo counts
+
+extern void legacy_ProcessMixer(void);
+extern void exact_ProcessMixer(void);
+extern double legacy_exact[FLIGHT_MODES][MAX_OUTPUTS];
+
+//************************************************************
+// Code
+//************************************************************
+
+static int16_t rnd(int16_t lo, int16_t hi)
+{
+	return lo + (int16_t)(rand() % (hi - lo + 1));
+}
+
+// Random mixer settings within the ranges allowed by menu_mixer.c
+static void random_channels(bool preset_only)
+{
+	channel_t *ch;
+	int8_t *sensor;
+	uint8_t i, j;
+
+	Load_eeprom_preset((uint8_t)rnd(QUADX, BLANK));
+
+	for (i = 0; i < MAX_OUTPUTS; i++)
+	{
+		ch = &Config.Channel[i];
+
+		ch->P1_throttle_volume = rnd(0, 125);
+		ch->P2_throttle_volume = (rand() & 1) ? ch->P1_throttle_volume : rnd(0, 125);
+		ch->Throttle_curve = rnd(LINEAR, SQRTSINE);
+
+		if (preset_only) continue;
+
+		ch->P1_offset = rnd(-125, 125);
+		ch->P1n_position = rnd(1, 99);
+		ch->P1n_offset = rnd(-125, 125);
+		ch->P2_offset = (rand() & 1) ? ch->P1_offset : rnd(-125, 125);
+
+		ch->P1_aileron_volume = rnd(-125, 125);
+		ch->P2_aileron_volume = rnd(-125, 125);
+		ch->P1_elevator_volume = rnd(-125, 125);
+		ch->P2_elevator_volume = rnd(-125, 125);
+		ch->P1_rudder_volume = rnd(-125, 125);
+		ch->P2_rudder_volume = rnd(-125, 125);
+
+		// Twelve gyro/acc settings, OFF/ON/SCALE
+		sensor = &ch->P1_Roll_gyro;
+		for (j = 0; j < 12; j++)
+		{
+			sensor[j] = rnd(OFF, SCALE);
+		}
+
+		ch->P1_source_a = rnd(SRC1, NOMIX);
+		ch->P1_source_a_volume = rnd(-125, 125);
+		ch->P2_source_a = rnd(SRC1, NOMIX);
+		ch->P2_source_a_volume = rnd(-125, 125);
+		ch->P1_source_b = rnd(SRC1, NOMIX);
+		ch->P1_source_b_volume = rnd(-125, 125);
+		ch->P2_source_b = rnd(SRC1, NOMIX);
+		ch->P2_source_b_volume = rnd(-125, 125);
+	}
+}
+
+// Random RC and sensor inputs of flight-like size
+static void random_inputs(void)
+{
+	uint8_t i, j;
+
+	for (i = 0; i < MAX_RC_CHANNELS; i++)
+	{
+		RCinputs[i] = rnd(-1250, 1250);
+	}
+
+	MonopolarThrottle = rnd(0, 2500);
+
+	for (j = P1; j <= P2; j++)
+	{
+		for (i = 0; i < NUMBEROFAXIS; i++)
+		{
+			PID_Gyros[j][i] = rnd(-1250, 1250);
+			PID_ACCs[j][i] = rnd(-1250, 1250);
+		}
+	}
+
+	for (i = 0; i < NUMBEROFAXIS; i++)
+	{
+		accSmooth[i] = rnd(-150, 150);
+	}
+
+	transition = rnd(0, 100);
+	transition_counter = transition;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-n cases] [-s seed] [-p]\n"
+		"  -n  number of random configurations (default %u)\n"
+		"  -s  random seed (default 1)\n"
+		"  -p  keep the preset mixes, only vary curves and inputs\n",
+		prog, DEFAULT_CASES);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t cases = DEFAULT_CASES, n, over = 0;
+	uint32_t hist[TOLERANCE + 2] = {0};
+	int16_t exact_servo[MAX_OUTPUTS], legacy_servo[MAX_OUTPUTS];
+	int16_t max_servo = 0, max_legacy = 0, d;
+	double exact_value[MAX_OUTPUTS], max_value = 0, e;
+	unsigned int seed = 1;
+	bool preset_only = false;
+	uint8_t i;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:s:ph")) != -1)
+	{
+		switch(opt)
+		{
+			case 'n': cases = (uint32_t)atol(optarg); break;
+			case 's': seed = (unsigned int)atoi(optarg); break;
+			case 'p': preset_only = true; break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+
+	srand(seed);
+	board_init();
+	Set_EEPROM_Default_Config();
+
+	for (n = 0; n < cases; n++)
+	{
+		random_channels(preset_only);
+		Config.TransitionSpeed = rnd(0, 1);
+		UpdateLimits();
+		random_inputs();
+
+		legacy_ProcessMixer();
+		UpdateServos();
+		memcpy(legacy_servo, (const void *)ServoOut, sizeof(legacy_servo));
+
+		exact_ProcessMixer();
+		for (i = 0; i < MAX_OUTPUTS; i++)
+		{
+			exact_value[i] = legacy_exact[P1][i];
+			Config.Channel[i].P1_value = (int16_t)lround(exact_value[i]);
+		}
+		UpdateServos();
+		memcpy(exact_servo, (const void *)ServoOut, sizeof(exact_servo));
+
+		ProcessMixer();
+		for (i = 0; i < MAX_OUTPUTS; i++)
+		{
+			e = fabs(Config.Channel[i].P1_value - exact_value[i]);
+			if (e > max_value) max_value = e;
+		}
+		UpdateServos();
+
+		for (i = 0; i < MAX_OUTPUTS; i++)
+		{
+			d = abs((int16_t)ServoOut[i] - exact_servo[i]);
+			if (d > max_servo) max_servo = d;
+			hist[(d > TOLERANCE) ? (TOLERANCE + 1) : d]++;
+			if (d > TOLERANCE) over++;
+
+			d = abs((int16_t)ServoOut[i] - legacy_servo[i]);
+			if (d > max_legacy) max_legacy = d;
+		}
+	}
+
+	printf("%u cases x %u outputs\n", cases, MAX_OUTPUTS);
+	for (i = 0; i <= TOLERANCE; i++)
+	{
+		printf("  |d ServoOut| = %u: %u\n", i, hist[i]);
+	}
+	printf("  |d ServoOut| > %u: %u\n", TOLERANCE, hist[TOLERANCE + 1]);
+	printf("max |d ServoOut| %d, max |d channel value| %.2f\n", max_servo, max_value);
+	printf("max |d ServoOut| from the integer legacy mixer %d\n", max_legacy);
+
+	return (over != 0);
+}
@@ -0,0 +1,225 @@
+//***********************************************************
+//* rc_test.c
+//*
+//* RC_SMOOTHING tests for rc.c.
+//*
+//* Runs the main loop's RC calls in FAST mode. RxGetChannels()
+//* is called on every loop, as it is while Interrupted_Clone
+//* is set, but Interrupted is only set on the loops where a
+//* frame arrives. The sticks and throttle are stepped and the
+//* smoothed RCinputs[] and MonopolarThrottle are checked to
+//* ramp over the loops of the next frame, ending within two
+//* loops' steps of the new value, and to settle on it exactly
+//* while it is held.
+//* Exits non-zero if any test fails.
+//***********************************************************
+
+//***********************************************************
+//* Includes
+//***********************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <avr/io.h>
+#include "io_cfg.h"
+#include "typedefs.h"
+#include "main.h"
+#include "isr.h"
+#include "rc.h"
+#include "board.h"
+
+//************************************************************
+// Defines
+//************************************************************
+
+#define LOOP_TICKS		1000			// Loop period in T1 ticks (400us)
+#define FRAME_LOOPS		18				// Loops per RC frame (7.2ms)
+#define SETTLE_FRAMES	4				// Frames to run before each step
+#define MIN_STEPS		(FRAME_LOOPS / 2)	// Distinct ramp values expected per frame
+
+#define RX_CENTER		3750
+#define RX_MIN			2500
+
+//************************************************************
+// Data
+//************************************************************
+
+static uint32_t failures = 0;
+
+//************************************************************
+// Code
+//************************************************************
+
+static void check(bool ok, const char *test, uint32_t n, const char *what)
+{
+	if (!ok)
+	{
+		if (failures < 20)
+		{
+			printf("  %s case %u: %s\n", test, n, what);
+		}
+
+		failures++;
+	}
+}
+
+// One pass of the main loop RC handling. Interrupted is cleared afterwards
+// as the FC_main.c handoff to Interrupted_Clone does.
+static void rc_loop(bool frame)
+{
+	board_advance(LOOP_TICKS);
+	Interrupted = frame;
+	RxGetChannels();
+	RC_Smooth();
+	Interrupted = false;
+}
+
+// One frame's worth of loops, the frame arriving on the first
+static void rc_frame(int16_t aileron[FRAME_LOOPS], int16_t throttle[FRAME_LOOPS])
+{
+	uint8_t i;
+
+	for (i = 0; i < FRAME_LOOPS; i++)
+	{
+		rc_loop(i == 0);
+		aileron[i] = RCinputs[AILERON];
+		throttle[i] = MonopolarThrottle;
+	}
+}
+
+static void rx_set(uint16_t aileron, uint16_t throttle)
+{
+	RxChannel[AILERON] = aileron;
+	RxChannel[THROTTLE] = throttle;
+}
+
+// Check one frame's outputs ramp monotonically from "from" towards "to"
+static void check_ramp(const char *test, uint32_t n, const int16_t out[FRAME_LOOPS], int16_t from, int16_t to)
+{
+	uint8_t i, steps = 0;
+	int16_t short_by = abs(to - out[FRAME_LOOPS - 1]);
+	bool monotonic = true;
+	bool bounded = true;
+	int16_t lo = (from < to) ? from : to;
+	int16_t hi = (from < to) ? to : from;
+
+	for (i = 0; i < FRAME_LOOPS; i++)
+	{
+		if ((out[i] < lo) || (out[i] > hi))
+		{
+			bounded = false;
+		}
+
+		if (i > 0)
+		{
+			if (((to > from) && (out[i] < out[i - 1])) || ((to < from) && (out[i] > out[i - 1])))
+			{
+				monotonic = false;
+			}
+
+			if (out[i] != out[i - 1])
+			{
+				steps++;
+			}
+		}
+	}
+
+	check(bounded, test, n, "output outside the step");
+	check(monotonic, test, n, "output not monotonic");
+	check(steps >= MIN_STEPS, test, n, "output did not ramp over several loops");
+	check(short_by <= ((abs(to - from) * 2) / FRAME_LOOPS), test, n, "output ramp too slow");
+}
+
+// Step the sticks and throttle, then hold them and check they settle
+static void test_step(void)
+{
+	static const int16_t steps[][2] =
+	{
+		// Aileron, throttle as offsets from the zero points
+		{  500,  800},
+		{ -500,    0},
+		{ 1000, 1250},
+		{ 1008, 1256},
+	};
+	int16_t aileron[FRAME_LOOPS], throttle[FRAME_LOOPS];
+	int16_t ail = 0, thr = 0;
+	uint8_t n, f;
+
+	for (n = 0; n < (sizeof(steps) / sizeof(steps[0])); n++)
+	{
+		rx_set(RX_CENTER + ail, RX_MIN + thr);
+
+		for (f = 0; f < SETTLE_FRAMES; f++)
+		{
+			rc_frame(aileron, throttle);
+		}
+
+		check((aileron[FRAME_LOOPS - 1] == ail) && (throttle[FRAME_LOOPS - 1] == thr),
+			  "settle", n, "output not at the held value");
+
+		rx_set(RX_CENTER + steps[n][0], RX_MIN + steps[n][1]);
+		rc_frame(aileron, throttle);
+
+		// Only ramps of at least one count per loop can show every step
+		if (abs(steps[n][0] - ail) > FRAME_LOOPS)
+		{
+			check_ramp("aileron", n, aileron, ail, steps[n][0]);
+			check_ramp("throttle", n, throttle, thr, steps[n][1]);
+		}
+
+		ail = steps[n][0];
+		thr = steps[n][1];
+	}
+
+	for (f = 0; f < SETTLE_FRAMES; f++)
+	{
+		rc_frame(aileron, throttle);
+	}
+
+	check((aileron[FRAME_LOOPS - 1] == ail) && (throttle[FRAME_LOOPS - 1] == thr),
+		  "settle", n, "output not at the held value");
+}
+
+// Outside FAST mode the frame values pass straight through
+static void test_not_fast(void)
+{
+	int16_t aileron[FRAME_LOOPS], throttle[FRAME_LOOPS];
+
+	Config.Servo_rate = SYNC;
+	rx_set(RX_CENTER + 300, RX_MIN + 400);
+	rc_frame(aileron, throttle);
+
+	check((aileron[0] == 300) && (throttle[0] == 400), "not fast", 0, "frame value not used at once");
+
+	Config.Servo_rate = FAST;
+}
+
+int main(void)
+{
+	uint8_t i;
+
+	board_init();
+	memset(&Config, 0, sizeof(Config));
+
+	Config.RxMode = PWM;
+	Config.Servo_rate = FAST;
+
+	for (i = 0; i < MAX_RC_CHANNELS; i++)
+	{
+		Config.ChannelOrder[i] = i;
+		Config.RxChannelZeroOffset[i] = RX_CENTER;
+		RxChannel[i] = RX_CENTER;
+	}
+
+	Config.RxChannelZeroOffset[THROTTLE] = RX_MIN;
+
+	test_step();
+	test_not_fast();
+
+	printf("%u failures\n", failures);
+
+	return (failures != 0);
+}
@@ -0,0 +1,376 @@
+//***********************************************************
+//* replay_bench.c
+//*
+//* Host-side replay benchmark for the OpenAeroVTOL flight core.
+//*
+//* Feeds recorded (or synthetic) gyro/acc/RC samples through the
+//* same per-loop sequence as FC_main.c:
+//*
+//*   RxGetChannels -> ReadSensors -> imu_update -> Sensor_PID
+//*   -> Calculate_PID -> ProcessMixer -> UpdateServos
+//*
+//* and reports nanoseconds per stage and per loop.
+//*
+//* Replay file format, one loop per line, '#' starts a comment:
+//*   period ax ay az gx gy gz thr ail ele rud gear aux1 aux2 aux3
+//* period is the loop interval in Timer1 ticks (400ns), ax..gz are
+//* raw MPU6050 register words and the RC fields are RxChannel[]
+//* values (2500 to 5000, 3750 = center).
+//***********************************************************
+
+//***********************************************************
+//* Includes
+//***********************************************************
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <avr/pgmspace.h>
+#include "io_cfg.h"
+#include "main.h"
+#include "isr.h"
+#include "rc.h"
+#include "gyros.h"
+#include "acc.h"
+#include "sensors.h"
+#include "imu.h"
+#include "pid.h"
+#include "mixer.h"
+#include "servos.h"
+#include "eeprom.h"
+#include "filters.h"
+#include "board.h"
+
+//************************************************************
+// Defines
+//************************************************************
+
+#define SYNTH_SAMPLES	7000			// 10 seconds at 700Hz
+#define SYNTH_PERIOD	3571			// STANDARDLOOP
+#define RC_FIELDS		8
+
+enum Stages	{ST_RC = 0, ST_SENSORS, ST_IMU, ST_SENSOR_PID, ST_CALC_PID, ST_MIXER, ST_SERVOS, ST_LOOP, NUM_STAGES};
+
+typedef struct
+{
+	uint32_t	period;
+	int16_t		acc[3];
+	int16_t		gyro[3];
+	uint16_t	rc[RC_FIELDS];
+} sample_t;
+
+typedef struct
+{
+	uint64_t	min;
+	uint64_t	max;
+	uint64_t	sum;
+	uint32_t	count;
+} stage_stats_t;
+
+//************************************************************
+// Data
+//************************************************************
+
+static const char *stage_names[NUM_STAGES] =
+{
+	"RxGetChannels", "ReadSensors", "imu_update", "Sensor_PID",
+	"Calculate_PID", "ProcessMixer", "UpdateServos", "Loop total"
+};
+
+static stage_stats_t stats[NUM_STAGES];
+
+//************************************************************
+// Code
+//************************************************************
+
+static inline uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+}
+
+static void record(uint8_t stage, uint64_t ns)
+{
+	stage_stats_t *s = &stats[stage];
+
+	if ((s->count == 0) || (ns < s->min)) s->min = ns;
+	if (ns > s->max) s->max = ns;
+	s->sum += ns;
+	s->count++;
+}
+
+// Gentle pseudo-random noise so the synthetic stream is repeatable
+static int16_t noise(uint32_t *seed, int16_t amplitude)
+{
+	*seed = (*seed * 1103515245u) + 12345u;
+	return (int16_t)((int32_t)((*seed >> 16) % (2 * amplitude + 1)) - amplitude);
+}
+
+// Synthetic hover with slow roll/pitch stirring and RC stick movement
+static sample_t *make_synthetic(uint32_t count)
+{
+	sample_t *s = calloc(count, sizeof(sample_t));
+	uint32_t seed = 1;
+	uint32_t i;
+	uint8_t j;
+	double t;
+
+	if (s == NULL) return NULL;
+
+	for (i = 0; i < count; i++)
+	{
+		t = (double)i * SYNTH_PERIOD * 0.0000004;
+
+		s[i].period = SYNTH_PERIOD + noise(&seed, 40);
+
+		// Acc at +/-4g: 8192 LSB/g. Gyro at 2000 deg/s: 16.4 LSB/deg/s
+		s[i].acc[0] = (int16_t)(1400.0 * sin(t * 1.3)) + noise(&seed, 60);
+		s[i].acc[1] = (int16_t)(1100.0 * sin(t * 0.9)) + noise(&seed, 60);
+		s[i].acc[2] = 8192 + noise(&seed, 80);
+		s[i].gyro[0] = (int16_t)(900.0 * cos(t * 0.9)) + noise(&seed, 30);
+		s[i].gyro[1] = (int16_t)(1200.0 * cos(t * 1.3)) + noise(&seed, 30);
+		s[i].gyro[2] = (int16_t)(300.0 * sin(t * 0.4)) + noise(&seed, 30);
+
+		for (j = 0; j < RC_FIELDS; j++)
+		{
+			s[i].rc[j] = 3750;
+		}
+
+		s[i].rc[THROTTLE] = 3600;
+		s[i].rc[AILERON] = 3750 + (int16_t)(400.0 * sin(t * 0.7));
+		s[i].rc[ELEVATOR] = 3750 + (int16_t)(400.0 * sin(t * 0.5));
+		s[i].rc[RUDDER] = 3750 + (int16_t)(200.0 * sin(t * 0.3));
+	}
+
+	return s;
+}
+
+static sample_t *load_replay(const char *name, uint32_t *count)
+{
+	FILE *f = fopen(name, "r");
+	sample_t *s = NULL;
+	uint32_t size = 0, n = 0;
+	char line[256];
+	int v[6 + RC_FIELDS];
+	unsigned long period;
+	uint8_t j;
+
+	if (f == NULL)
+	{
+		perror(name);
+		return NULL;
+	}
+
+	while (fgets(line, sizeof(line), f) != NULL)
+	{
+		if ((line[0] == '#') || (line[0] == '\n')) continue;
+
+		if (sscanf(line, "%lu %d %d %d %d %d %d %d %d %d %d %d %d %d %d", &period,
+				&v[0], &v[1], &v[2], &v[3], &v[4], &v[5],
+				&v[6], &v[7], &v[8], &v[9], &v[10], &v[11], &v[12], &v[13]) != 15)
+		{
+			fprintf(stderr, "%s: skipping malformed line %u\n", name, n + 1);
+			continue;
+		}
+
+		if (n == size)
+		{
+			size = size ? (size * 2) : 1024;
+			s = realloc(s, size * sizeof(sample_t));
+			if (s == NULL) break;
+		}
+
+		s[n].period = (uint32_t)period;
+		for (j = 0; j < 3; j++)
+		{
+			s[n].acc[j] = (int16_t)v[j];
+			s[n].gyro[j] = (int16_t)v[3 + j];
+		}
+		for (j = 0; j < RC_FIELDS; j++)
+		{
+			s[n].rc[j] = (uint16_t)v[6 + j];
+		}
+		n++;
+	}
+
+	fclose(f);
+	*count = n;
+	return s;
+}
+
+// One pass of FC_main's per-loop work for a single sample
+static void run_loop(const sample_t *s, FILE *dump)
+{
+	uint64_t t0, t1, start;
+	int16_t acc[3], gyro[3];
+	uint8_t i;
+
+	for (i = 0; i < RC_FIELDS; i++)
+	{
+		RxChannel[i] = s->rc[i];
+	}
+	for (i = 0; i < 3; i++)
+	{
+		acc[i] = s->acc[i];
+		gyro[i] = s->gyro[i];
+	}
+	board_set_mpu6050(acc, gyro, 0);
+	board_advance(s->period);
+
+	start = t0 = now_ns();
+	RxGetChannels();
+	t1 = now_ns(); record(ST_RC, t1 - t0); t0 = t1;
+
+	ReadSensors();
+	t1 = now_ns(); record(ST_SENSORS, t1 - t0); t0 = t1;
+
+	imu_update(s->period);
+	t1 = now_ns(); record(ST_IMU, t1 - t0); t0 = t1;
+
+	Sensor_PID(s->period);
+	t1 = now_ns(); record(ST_SENSOR_PID, t1 - t0); t0 = t1;
+
+	Calculate_PID();
+	t1 = now_ns(); record(ST_CALC_PID, t1 - t0); t0 = t1;
+
+	ProcessMixer();
+	t1 = now_ns(); record(ST_MIXER, t1 - t0); t0 = t1;
+
+	UpdateServos();
+	t1 = now_ns(); record(ST_SERVOS, t1 - t0);
+	record(ST_LOOP, t1 - start);
+
+	if (dump != NULL)
+	{
+		fprintf(dump, "%d %d", angle[ROLL], angle[PITCH]);
+		for (i = 0; i < MAX_OUTPUTS; i++)
+		{
+			fprintf(dump, " %u", ServoOut[i]);
+		}
+		fprintf(dump, "\n");
+	}
+}
+
+static void report(uint32_t samples, uint32_t passes)
+{
+	uint8_t i;
+
+	printf("%u samples x %u passes\n", samples, passes);
+	printf("%-16s %10s %10s %10s\n", "stage", "min ns", "mean ns", "max ns");
+
+	for (i = 0; i < NUM_STAGES; i++)
+	{
+		if (stats[i].count == 0) continue;
+
+		printf("%-16s %10llu %10.1f %10llu\n", stage_names[i],
+				(unsigned long long)stats[i].min,
+				(double)stats[i].sum / stats[i].count,
+				(unsigned long long)stats[i].max);
+	}
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-f replay.txt] [-p passes] [-t transition] [-i imu] [-d dump.txt]\n"
+		"  -f  replay file (default: %u synthetic samples)\n"
+		"  -p  number of passes over the data (default 20)\n"
+		"  -t  fixed transition position 0-100 (default 0 = P1)\n"
+		"  -i  IMU type, 0 = vector, 1 = quaternion (default 0)\n"
+		"  -d  write angle[] and ServoOut[] per loop (first pass only)\n",
+		prog, SYNTH_SAMPLES);
+}
+
+int main(int argc, char **argv)
+{
+	const char *replay = NULL;
+	const char *dumpname = NULL;
+	FILE *dump = NULL;
+	sample_t *samples;
+	uint32_t count = 0, passes = 20, p, i;
+	int trans = 0;
+	int imu = IMU_VECTOR;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "f:p:t:i:d:h")) != -1)
+	{
+		switch(opt)
+		{
+			case 'f': replay = optarg; break;
+			case 'p': passes = (uint32_t)atoi(optarg); break;
+			case 't': trans = atoi(optarg); break;
+			case 'i': imu = atoi(optarg); break;
+			case 'd': dumpname = optarg; break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+
+	if ((trans < 0) || (trans > 100) || (imu < IMU_VECTOR) || (imu > IMU_QUAT) || (passes == 0))
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (replay != NULL)
+	{
+		samples = load_replay(replay, &count);
+	}
+	else
+	{
+		count = SYNTH_SAMPLES;
+		samples = make_synthetic(count);
+	}
+
+	if ((samples == NULL) || (count == 0))
+	{
+		fprintf(stderr, "no samples to replay\n");
+		return 1;
+	}
+
+	if (dumpname != NULL)
+	{
+		dump = fopen(dumpname, "w");
+		if (dump == NULL)
+		{
+			perror(dumpname);
+			return 1;
+		}
+	}
+
+	// Factory defaults, as a freshly flashed board would boot
+	board_init();
+	Set_EEPROM_Default_Config();
+	Config.ArmMode = ARMABLE;
+	Config.IMU_type = imu;
+	UpdateLimits();
+	init_filters();
+	reset_IMU();
+
+	transition = trans;
+	transition_counter = trans;
+
+	for (p = 0; p < passes; p++)
+	{
+		for (i = 0; i < count; i++)
+		{
+			run_loop(&samples[i], (p == 0) ? dump : NULL);
+		}
+	}
+
+	if (dump != NULL) fclose(dump);
+
+	report(count, passes);
+	free(samples);
+
+	return 0;
+}
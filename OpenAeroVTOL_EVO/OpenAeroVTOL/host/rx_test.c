@@ -0,0 +1,777 @@
+//***********************************************************
+//* rx_test.c
+//*
+//* Serial RC receive tests for serial_rx.c.
+//*
+//* Byte streams are fed through the real USART0_RX_vect from
+//* isr.c, one byte at a time with the Timer1 gaps a receiver
+//* would leave, then drained by RxDecodeSerial() as the main
+//* loop does. The decoded RxChannel[] and SerialChannel[]
+//* values are checked against reference decoders written here
+//* from the format descriptions.
+//*
+//* Covers S.Bus and CRSF channel unpacking, every entry of the
+//* CRSF CRC8 table, Xtreme and Spektrum framing, ring overflow
+//* (RX_RING_LOST), the frame period estimate and RxBurstPulses().
+//* Exits non-zero if any test fails.
+//***********************************************************
+
+//***********************************************************
+//* Includes
+//***********************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <avr/io.h>
+#include "io_cfg.h"
+#include "typedefs.h"
+#include "main.h"
+#include "isr.h"
+#include "serial_rx.h"
+#include "board.h"
+
+//************************************************************
+// Defines
+//************************************************************
+
+#define DEFAULT_CASES	2000
+#define FRAME_GAP		5000			// Gap before each packet in T1 ticks (2ms)
+
+#define SBUS_BYTE		300				// Byte times in T1 ticks (400ns)
+#define SPEKTRUM_BYTE	217
+#define XTREME_BYTE		100
+#define CRSF_BYTE		60
+
+#define SBUS_PERIOD		17500			// 7ms S.Bus frame period
+#define PERIOD_FRAMES	60				// Frames before the estimate is checked
+#define PERIOD_TOLERANCE 32				// T1 ticks
+
+// Copies of the serial_rx.c burst planning constants
+#define PACKET_MARGIN	2500
+#define BURST_SPAN_MAX	100000
+#define BURST_PULSES_MAX 16
+
+extern void USART0_RX_vect(void);
+
+//************************************************************
+// Data
+//************************************************************
+
+// Packet times in T1 ticks, in enum RX_Modes order
+static const uint32_t packet_time[] = {0, 0, 7500, 3472, 3700, 1548};
+
+static uint32_t failures = 0;
+
+//************************************************************
+// Code
+//************************************************************
+
+static int rnd(int lo, int hi)
+{
+	return lo + (rand() % (hi - lo + 1));
+}
+
+static void check(bool ok, const char *test, uint32_t n, const char *what)
+{
+	if (!ok)
+	{
+		if (failures < 20)
+		{
+			printf("  %s case %u: %s\n", test, n, what);
+		}
+
+		failures++;
+	}
+}
+
+// One byte through the USART interrupt, gap T1 ticks after the last one
+static void rx_byte(uint8_t data, uint32_t gap)
+{
+	board_advance(gap);
+	UDR0 = data;
+	USART0_RX_vect();
+}
+
+// A packet whose first byte follows a gap, then the rest at byte_time
+static void rx_packet(const uint8_t *data, uint8_t size, uint32_t gap, uint32_t byte_time)
+{
+	uint8_t i;
+
+	for (i = 0; i < size; i++)
+	{
+		rx_byte(data[i], (i == 0) ? gap : byte_time);
+	}
+}
+
+// Select a receiver and a shuffled channel order, and empty the ring
+static void rx_setup(uint8_t mode)
+{
+	uint8_t i, j, t;
+
+	Config.RxMode = mode;
+
+	for (i = 0; i < MAX_RC_CHANNELS; i++)
+	{
+		Config.ChannelOrder[i] = i;
+	}
+
+	for (i = MAX_RC_CHANNELS - 1; i > 0; i--)
+	{
+		j = rnd(0, i);
+		t = Config.ChannelOrder[i];
+		Config.ChannelOrder[i] = Config.ChannelOrder[j];
+		Config.ChannelOrder[j] = t;
+	}
+
+	board_advance(FRAME_GAP);
+	RxDecodeSerial();
+	Interrupted = false;
+}
+
+// Channel ch of sixteen 11-bit channels packed LSB first
+static uint16_t unpack11(const uint8_t *data, uint8_t ch)
+{
+	uint16_t value = 0;
+	uint16_t bit;
+	uint8_t i;
+
+	for (i = 0; i < 11; i++)
+	{
+		bit = (ch * 11) + i;
+
+		if (data[bit >> 3] & (1 << (bit & 7)))
+		{
+			value |= (1 << i);
+		}
+	}
+
+	return value;
+}
+
+static uint8_t crc8_d5(const uint8_t *data, uint8_t size)
+{
+	uint8_t crc = 0;
+	uint8_t i, j;
+
+	for (i = 0; i < size; i++)
+	{
+		crc ^= data[i];
+
+		for (j = 0; j < 8; j++)
+		{
+			crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0xD5) : (uint8_t)(crc << 1);
+		}
+	}
+
+	return crc;
+}
+
+// Compare RxChannel[] with the first MAX_RC_CHANNELS expected values
+static bool channels_match(const uint16_t *expected)
+{
+	uint8_t ch;
+
+	for (ch = 0; ch < MAX_RC_CHANNELS; ch++)
+	{
+		if (RxChannel[Config.ChannelOrder[ch]] != expected[ch])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+//************************************************************
+// S.Bus
+//************************************************************
+
+static void sbus_frame(uint8_t *frame, uint16_t *expected)
+{
+	uint8_t i;
+
+	frame[0] = 0x0F;
+
+	for (i = 1; i <= 22; i++)
+	{
+		frame[i] = (uint8_t)rand();
+	}
+
+	frame[23] = (uint8_t)rand() & ~(1 << RX_FRAMELOST);
+	frame[24] = 0x00;
+
+	// 0 to 2047 around 1024, x 1.469 around 3750
+	for (i = 0; i < SERIAL_CHANNELS; i++)
+	{
+		int16_t t = (int16_t)unpack11(&frame[1], i) - 1024;
+		t = t + (t >> 2) + (t >> 3) + (t >> 4) + (t >> 5);
+		expected[i] = (uint16_t)(t + 3750);
+	}
+}
+
+static void test_sbus(uint32_t cases)
+{
+	uint8_t frame[25];
+	uint16_t expected[SERIAL_CHANNELS];
+	uint16_t before[MAX_RC_CHANNELS];
+	uint32_t n;
+	uint8_t i;
+	bool ok;
+
+	rx_setup(SBUS);
+
+	for (n = 0; n < cases; n++)
+	{
+		sbus_frame(frame, expected);
+
+		// Every fourth frame is marked lost by the receiver and must be ignored
+		if ((n & 3) == 3)
+		{
+			frame[23] |= (1 << RX_FRAMELOST);
+			memcpy(before, (const void *)RxChannel, sizeof(before));
+		}
+
+		rx_packet(frame, sizeof(frame), FRAME_GAP, SBUS_BYTE);
+		RxDecodeSerial();
+
+		if ((n & 3) == 3)
+		{
+			check(!Interrupted && !memcmp(before, (const void *)RxChannel, sizeof(before)), "sbus", n, "lost frame decoded");
+			continue;
+		}
+
+		ok = true;
+
+		for (i = 0; i < SERIAL_CHANNELS; i++)
+		{
+			ok &= (SerialChannel[i] == expected[i]);
+		}
+
+		check(Interrupted, "sbus", n, "no frame");
+		check(ok && channels_match(expected), "sbus", n, "channels");
+		check(RxFlags == frame[23], "sbus", n, "flags");
+
+		Interrupted = false;
+	}
+}
+
+//************************************************************
+// CRSF
+//************************************************************
+
+static uint8_t crsf_rc_frame(uint8_t *frame, uint16_t *expected)
+{
+	uint8_t i;
+
+	frame[0] = 0xC8;
+	frame[1] = 24;
+	frame[2] = 0x16;
+
+	for (i = 0; i < 22; i++)
+	{
+		frame[3 + i] = (uint8_t)rand();
+	}
+
+	frame[25] = crc8_d5(&frame[2], 23);
+
+	// 0 to 2047 around 992, x 1.5625 around 3750
+	for (i = 0; i < SERIAL_CHANNELS; i++)
+	{
+		int16_t t = (int16_t)unpack11(&frame[3], i) - 992;
+		t = t + (t >> 1) + (t >> 4);
+		expected[i] = (uint16_t)(t + 3750);
+	}
+
+	return 26;
+}
+
+static uint8_t crsf_stats_frame(uint8_t *frame, uint8_t rssi, uint8_t lq)
+{
+	uint8_t i;
+
+	frame[0] = 0xC8;
+	frame[1] = 12;
+	frame[2] = 0x14;
+
+	for (i = 0; i < 10; i++)
+	{
+		frame[3 + i] = (uint8_t)rand();
+	}
+
+	frame[3] = rssi;
+	frame[5] = lq;
+	frame[13] = crc8_d5(&frame[2], 11);
+
+	return 14;
+}
+
+// RC and link statistics frames back to back with no gap between them,
+// with some corrupted or preceded by noise
+static void test_crsf(uint32_t cases)
+{
+	uint8_t frame[26];
+	uint16_t expected[SERIAL_CHANNELS];
+	uint16_t before[MAX_RC_CHANNELS];
+	uint32_t n;
+	uint8_t size, i;
+	uint8_t rssi, lq;
+	bool ok;
+
+	rx_setup(CRSF);
+	rx_byte(0x00, FRAME_GAP);
+
+	for (n = 0; n < cases; n++)
+	{
+		switch (n % 5)
+		{
+			// Link statistics
+			case 1:
+				rssi = (uint8_t)rnd(1, 120);
+				lq = (uint8_t)rnd(0, 100);
+				size = crsf_stats_frame(frame, rssi, lq);
+				rx_packet(frame, size, CRSF_BYTE, CRSF_BYTE);
+				RxDecodeSerial();
+				check(RxLinkQuality == lq, "crsf", n, "link statistics");
+				check(((RxFlags & (1 << RX_FAILSAFE)) != 0) == (lq == 0), "crsf", n, "failsafe flag");
+				continue;
+
+			// Bad CRC
+			case 3:
+				size = crsf_rc_frame(frame, expected);
+				frame[rnd(2, size - 1)] ^= (uint8_t)(1 << rnd(0, 7));
+				memcpy(before, (const void *)RxChannel, sizeof(before));
+				rx_packet(frame, size, CRSF_BYTE, CRSF_BYTE);
+				RxDecodeSerial();
+				check(!Interrupted && !memcmp(before, (const void *)RxChannel, sizeof(before)), "crsf", n, "bad CRC accepted");
+				continue;
+
+			// Noise without the address byte first
+			case 4:
+				for (i = rnd(1, 8); i > 0; i--)
+				{
+					rx_byte((uint8_t)rnd(0, 0xC7), CRSF_BYTE);
+				}
+				break;
+
+			default:
+				break;
+		}
+
+		size = crsf_rc_frame(frame, expected);
+		rx_packet(frame, size, CRSF_BYTE, CRSF_BYTE);
+		RxDecodeSerial();
+
+		ok = true;
+
+		for (i = 0; i < SERIAL_CHANNELS; i++)
+		{
+			ok &= (SerialChannel[i] == expected[i]);
+		}
+
+		check(Interrupted, "crsf", n, "no frame");
+		check(ok && channels_match(expected), "crsf", n, "channels");
+
+		Interrupted = false;
+	}
+}
+
+// The CRC of a link statistics frame ends with crsf_crc_table[state ^ last byte].
+// Stepping the last payload byte through 0 to 255 uses every table entry once.
+static void test_crc_table(void)
+{
+	uint8_t frame[14];
+	uint16_t i;
+
+	rx_setup(CRSF);
+	crsf_stats_frame(frame, 0x55, 100);
+
+	for (i = 0; i < 256; i++)
+	{
+		frame[12] = (uint8_t)i;
+		frame[13] = crc8_d5(&frame[2], 11);
+		RxLinkQuality = 0;
+		rx_packet(frame, sizeof(frame), FRAME_GAP, CRSF_BYTE);
+		RxDecodeSerial();
+		check(RxLinkQuality == 100, "crc table", i, "good CRC rejected");
+
+		frame[13] ^= 0x01;
+		RxLinkQuality = 0;
+		rx_packet(frame, sizeof(frame), FRAME_GAP, CRSF_BYTE);
+		RxDecodeSerial();
+		check(RxLinkQuality == 0, "crc table", i, "bad CRC accepted");
+	}
+}
+
+//************************************************************
+// Xtreme
+//************************************************************
+
+static void test_xtreme(uint32_t cases)
+{
+	uint8_t frame[SBUFFER_SIZE];
+	uint16_t expected[MAX_RC_CHANNELS];
+	uint16_t value, mask, sum;
+	uint32_t n;
+	uint8_t size, j;
+	bool bad;
+
+	rx_setup(XTREME);
+
+	for (n = 0; n < cases; n++)
+	{
+		mask = (uint16_t)rnd(1, 0xFFFF);
+		bad = ((n % 4) == 3);
+
+		// Flags, RSS and the channel mask
+		frame[0] = 0x00;
+		frame[1] = (uint8_t)rand();
+		frame[2] = (uint8_t)(mask >> 8);
+		frame[3] = (uint8_t)mask;
+		size = 4;
+
+		for (j = 0; j < MAX_RC_CHANNELS; j++)
+		{
+			expected[j] = RxChannel[Config.ChannelOrder[j]];
+		}
+
+		// One word per mask bit, in channel order. 1000 to 2000us
+		for (j = 0; j < 16; j++)
+		{
+			if (mask & (1 << j))
+			{
+				value = (uint16_t)rnd(1000, 2000);
+				frame[size++] = (uint8_t)(value >> 8);
+				frame[size++] = (uint8_t)value;
+
+				if (j < MAX_RC_CHANNELS)
+				{
+					expected[j] = (uint16_t)((value * 10) >> 2);
+				}
+			}
+		}
+
+		for (sum = 0, j = 0; j < size; j++)
+		{
+			sum += frame[j];
+		}
+
+		frame[size++] = (uint8_t)sum;
+
+		// A wrong checksum or a channel bank other than 0 is ignored
+		if (bad)
+		{
+			if (n & 4)
+			{
+				frame[size - 1] ^= 0x10;
+			}
+			else
+			{
+				frame[0] = 0x20;
+				frame[size - 1] += 0x20;
+			}
+
+			for (j = 0; j < MAX_RC_CHANNELS; j++)
+			{
+				expected[j] = RxChannel[Config.ChannelOrder[j]];
+			}
+		}
+
+		rx_packet(frame, size, FRAME_GAP, XTREME_BYTE);
+		RxDecodeSerial();
+
+		check(Interrupted != bad, "xtreme", n, bad ? "bad frame accepted" : "no frame");
+		check(channels_match(expected), "xtreme", n, "channels");
+
+		Interrupted = false;
+	}
+}
+
+//************************************************************
+// Spektrum
+//************************************************************
+
+// Seven channel words in a random order, some blank. 10 or 11-bit data
+static void test_spektrum(uint32_t cases)
+{
+	uint8_t frame[16];
+	uint16_t expected[MAX_RC_CHANNELS];
+	double ideal;
+	uint16_t value, word;
+	uint32_t n;
+	uint8_t order[MAX_RC_CHANNELS];
+	uint8_t i, j, t;
+	bool eleven, ok;
+
+	rx_setup(SPEKTRUM);
+
+	for (n = 0; n < cases; n++)
+	{
+		eleven = (n & 1);
+
+		frame[0] = (uint8_t)rand();
+		frame[1] = eleven ? 0x12 : 0x01;
+
+		for (i = 0; i < MAX_RC_CHANNELS; i++)
+		{
+			order[i] = i;
+			expected[i] = RxChannel[Config.ChannelOrder[i]];
+		}
+
+		for (i = MAX_RC_CHANNELS - 1; i > 0; i--)
+		{
+			j = rnd(0, i);
+			t = order[i];
+			order[i] = order[j];
+			order[j] = t;
+		}
+
+		for (i = 0; i < 7; i++)
+		{
+			// Blank words carry channel number 15
+			if (rnd(0, 5) == 0)
+			{
+				word = 0xFFFF;
+			}
+			else if (eleven)
+			{
+				value = (uint16_t)rnd(0, 2047);
+				word = (uint16_t)((order[i] << 11) | value);
+				expected[order[i]] = (uint16_t)(value + 0x8000);
+			}
+			else
+			{
+				value = (uint16_t)rnd(0, 1023);
+				word = (uint16_t)((order[i] << 10) | value);
+				expected[order[i]] = (uint16_t)(value + 0x8000);
+			}
+
+			frame[2 + (i << 1)] = (uint8_t)(word >> 8);
+			frame[3 + (i << 1)] = (uint8_t)word;
+		}
+
+		rx_packet(frame, sizeof(frame), FRAME_GAP, SPEKTRUM_BYTE);
+		RxDecodeSerial();
+
+		check(Interrupted, "spektrum", n, "no frame");
+
+		// x 2.9375 around 3750 (1.5ms), halved for 11-bit. Shift-and-add is within 4 counts
+		ok = true;
+
+		for (i = 0; i < MAX_RC_CHANNELS; i++)
+		{
+			if (expected[i] & 0x8000)
+			{
+				value = expected[i] & 0x7FFF;
+				ideal = eleven ? (3750 + (((int)value - 1024) * 2.9375 / 2)) :
+								 (3750 + (((int)value - 512) * 2.9375));
+				ok &= (fabs(RxChannel[Config.ChannelOrder[i]] - ideal) <= 4);
+			}
+			else
+			{
+				ok &= (RxChannel[Config.ChannelOrder[i]] == expected[i]);
+			}
+		}
+
+		check(ok, "spektrum", n, "channels");
+
+		Interrupted = false;
+	}
+}
+
+//************************************************************
+// Ring overflow
+//************************************************************
+
+// A packet that loses bytes when the ring fills must be dropped, even if
+// what follows the gap in it looks like the end of a frame. The next
+// packet after a gap is decoded normally.
+static void test_overflow(uint32_t cases)
+{
+	uint8_t frame[25], fake[25], noise[RX_RING_SIZE];
+	uint16_t expected[SERIAL_CHANNELS];
+	uint16_t before[MAX_RC_CHANNELS];
+	uint8_t lost, fill;
+	uint32_t n;
+
+	rx_setup(SBUS);
+	memset(noise, 0xFF, sizeof(noise));
+
+	for (n = 0; n < cases; n++)
+	{
+		// Leave room for part of the next frame only
+		fill = (uint8_t)rnd(RX_RING_SIZE - 24, RX_RING_SIZE - 2);
+		lost = (uint8_t)(25 - (RX_RING_SIZE - 1 - fill));
+		rx_packet(noise, fill, FRAME_GAP, SBUS_BYTE);
+
+		// With the bytes lost, byte 24 of the packet falls inside fake[]
+		sbus_frame(frame, expected);
+		sbus_frame(fake, expected);
+		fake[24 - (25 - lost)] = 0x00;
+		fake[23 - (25 - lost)] = 0x00;
+
+		RxOverruns = 0;
+		rx_packet(frame, sizeof(frame), FRAME_GAP, SBUS_BYTE);
+		check(RxOverruns == lost, "overflow", n, "RxOverruns");
+
+		memcpy(before, (const void *)RxChannel, sizeof(before));
+		RxDecodeSerial();
+		rx_packet(fake, sizeof(fake), SBUS_BYTE, SBUS_BYTE);
+		RxDecodeSerial();
+		check(!Interrupted && !memcmp(before, (const void *)RxChannel, sizeof(before)), "overflow", n, "damaged packet decoded");
+
+		sbus_frame(frame, expected);
+		rx_packet(frame, sizeof(frame), FRAME_GAP, SBUS_BYTE);
+		RxDecodeSerial();
+		check(Interrupted && channels_match(expected), "overflow", n, "next packet");
+
+		Interrupted = false;
+	}
+}
+
+//************************************************************
+// Frame period
+//************************************************************
+
+// S.Bus frames at a steady 7ms, drained at random times after each one.
+// The estimate comes from the RxStamp times of the packet starts.
+static void test_frame_period(void)
+{
+	uint8_t frame[25];
+	uint16_t expected[SERIAL_CHANNELS];
+	uint32_t wait, n;
+
+	rx_setup(SBUS);
+	RxFramePeriod = 0;
+	wait = 0;
+
+	for (n = 0; n < PERIOD_FRAMES; n++)
+	{
+		sbus_frame(frame, expected);
+		rx_packet(frame, sizeof(frame), SBUS_PERIOD - (24 * SBUS_BYTE) - wait, SBUS_BYTE);
+
+		wait = (uint32_t)rnd(0, 5000);
+		board_advance(wait);
+		RxDecodeSerial();
+	}
+
+	check(abs((int32_t)RxFramePeriod - SBUS_PERIOD) <= PERIOD_TOLERANCE, "frame period", RxFramePeriod, "estimate");
+}
+
+//************************************************************
+// Burst planning
+//************************************************************
+
+// Shortest burst cycle whose pulse rate is within 1/8 of the best possible
+static uint8_t burst_reference(uint32_t period, uint32_t pwm_interval)
+{
+	uint32_t span[BURST_PULSES_MAX + 1];
+	uint32_t needed;
+	uint8_t count, best, p;
+
+	if (period == 0)
+	{
+		return 1;
+	}
+
+	for (count = 0, p = 1; p <= BURST_PULSES_MAX; p++)
+	{
+		needed = packet_time[Config.RxMode] + PACKET_MARGIN + (p * pwm_interval);
+		span[p] = ((needed + period - 1) / period) * period;
+
+		if ((p > 1) && (span[p] > BURST_SPAN_MAX))
+		{
+			break;
+		}
+
+		count = p;
+	}
+
+	for (best = 1, p = 2; p <= count; p++)
+	{
+		if (((uint64_t)p * span[best]) > ((uint64_t)best * span[p]))
+		{
+			best = p;
+		}
+	}
+
+	for (p = 1; p < best; p++)
+	{
+		if (((uint64_t)8 * p * span[best]) >= ((uint64_t)7 * best * span[p]))
+		{
+			break;
+		}
+	}
+
+	return p;
+}
+
+static void test_burst(uint32_t cases)
+{
+	static const uint8_t modes[] = {SBUS, SPEKTRUM, XTREME, CRSF};
+	uint32_t pwm_interval, n;
+	uint8_t got, want;
+
+	for (n = 0; n < cases; n++)
+	{
+		Config.RxMode = modes[n & 3];
+		RxFramePeriod = (n % 50) ? (uint16_t)rnd(5000, 65000) : 0;
+		pwm_interval = (uint32_t)rnd(5000, 50000);
+
+		got = RxBurstPulses(pwm_interval);
+		want = burst_reference(RxFramePeriod, pwm_interval);
+
+		check(got == want, "burst", n, "pulses");
+	}
+
+	RxFramePeriod = 0;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-n cases] [-s seed]\n"
+		"  -n  random frames per test (default %u)\n"
+		"  -s  random seed (default 1)\n",
+		prog, DEFAULT_CASES);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t cases = DEFAULT_CASES;
+	unsigned int seed = 1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:s:h")) != -1)
+	{
+		switch(opt)
+		{
+			case 'n': cases = (uint32_t)atol(optarg); break;
+			case 's': seed = (unsigned int)atoi(optarg); break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+
+	srand(seed);
+	board_init();
+	memset(&Config, 0, sizeof(Config));
+
+	test_sbus(cases);
+	test_crsf(cases);
+	test_crc_table();
+	test_xtreme(cases);
+	test_spektrum(cases);
+	test_overflow(cases);
+	test_frame_period();
+	test_burst(cases * 10);
+
+	printf("%u failures\n", failures);
+
+	return (failures != 0);
+}
@@ -0,0 +1,84 @@
+//***********************************************************
+//* sim_config.c
+//*
+//* Firmware-side helpers for the simavr cycle profiler.
+//* Built with the firmware's struct packing so that the EEPROM
+//* image matches CONFIG_STRUCT byte for byte on the target.
+//***********************************************************
+
+//***********************************************************
+//* Includes
+//***********************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+#include "io_cfg.h"
+#include "eeprom.h"
+#include "sim_config.h"
+
+//************************************************************
+// Data
+//************************************************************
+
+// Must follow enum LoopStages in io_cfg.h
+static const char *stage_names[NUMBEROFSTAGES] =
+{
+	"main (other)", "main (loop top)", "RxGetChannels", "ReadSensors",
+	"imu_update", "Sensor_PID", "Calculate_PID", "ProcessMixer",
+	"UpdateServos", "output_servo_ppm", "output_servo_ppm_asm", "FAST sync wait",
+	"status/menu"
+};
+
+static const char *rate_names[] = {"LOW", "SYNC", "FAST"};
+
+static const char *imu_names[] = {"vector", "quaternion"};
+
+//************************************************************
+// Code
+//************************************************************
+
+// Factory default configuration with the requested Servo_rate and IMU_type,
+// laid out exactly as Save_Config_to_EEPROM() would store it
+uint16_t sim_config_image(uint8_t *image, uint16_t size, uint8_t servo_rate, uint8_t imu_type)
+{
+	Set_EEPROM_Default_Config();
+	Config.Servo_rate = servo_rate;
+	Config.IMU_type = imu_type;
+
+	if (size < sizeof(CONFIG_STRUCT))
+	{
+		return 0;
+	}
+
+	memset(image, 0xff, size);
+	memcpy(image, &Config, sizeof(CONFIG_STRUCT));
+
+	return sizeof(CONFIG_STRUCT);
+}
+
+uint8_t sim_stage_count(void)
+{
+	return NUMBEROFSTAGES;
+}
+
+uint8_t sim_stage_loop(void)
+{
+	return STAGE_LOOP;
+}
+
+const char *sim_stage_name(uint8_t stage)
+{
+	return (stage < NUMBEROFSTAGES) ? stage_names[stage] : "?";
+}
+
+const char *sim_rate_name(uint8_t servo_rate)
+{
+	return (servo_rate <= FAST) ? rate_names[servo_rate] : "?";
+}
+
+const char *sim_imu_name(uint8_t imu_type)
+{
+	return (imu_type <= IMU_QUAT) ? imu_names[imu_type] : "?";
+}
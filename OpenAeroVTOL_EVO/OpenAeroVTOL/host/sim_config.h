@@ -0,0 +1,24 @@
+/*********************************************************************
+ * sim_config.h
+ *
+ * Interface between the simavr profiler and the firmware-side
+ * helpers. Kept free of firmware headers so that it can be included
+ * next to the simavr headers, which are built without struct packing.
+ ********************************************************************/
+
+#ifndef HOST_SIM_CONFIG_H
+#define HOST_SIM_CONFIG_H
+
+#include <stdint.h>
+
+#define SIM_SERVO_RATES	3				// LOW, SYNC, FAST
+#define SIM_IMU_TYPES	2				// Vector, quaternion
+
+extern uint16_t sim_config_image(uint8_t *image, uint16_t size, uint8_t servo_rate, uint8_t imu_type);
+extern uint8_t sim_stage_count(void);
+extern uint8_t sim_stage_loop(void);
+extern const char *sim_stage_name(uint8_t stage);
+extern const char *sim_rate_name(uint8_t servo_rate);
+extern const char *sim_imu_name(uint8_t imu_type);
+
+#endif // HOST_SIM_CONFIG_H
@@ -0,0 +1,503 @@
+//***********************************************************
+//* sim_profile.c
+//*
+//* Cycle-accurate main loop profiler for OpenAeroVTOL.
+//*
+//* Boots a firmware image built with SIM_PROFILE under simavr,
+//* with a register-level MPU6050 on the TWI bus and an S.Bus
+//* receiver on USART0. The firmware writes an enum LoopStages
+//* value to GPIOR0 at each stage boundary (LOOP_STAGE() in main.h);
+//* every write is timestamped with the simulator cycle counter.
+//*
+//* Each Servo_rate mode is run with each IMU_type from a fresh boot
+//* with a factory default EEPROM image whose Servo_rate and IMU_type
+//* have been changed, and a cycles-per-stage report is printed for
+//* each. The "imu_update" line compares the two attitude engines.
+//*
+//* Cycles spent in interrupt handlers are charged to whichever
+//* stage was interrupted, as they are on the real board.
+//***********************************************************
+
+//***********************************************************
+//* Includes
+//***********************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_irq.h"
+#include "sim_cycle_timers.h"
+#include "avr_twi.h"
+#include "avr_uart.h"
+#include "avr_ioport.h"
+#include "avr_eeprom.h"
+#include "sim_config.h"
+
+//************************************************************
+// Defines
+//************************************************************
+
+#define F_CPU_HZ		20000000
+#define GPIOR0_ADDR		0x3E			// GPIOR0 in data space (I/O 0x1E) on the ATmega644/1284
+#define MAX_STAGES		32
+
+#define MPU6050_ADDR	0xD0			// 0x68 << 1, as seen on the bus
+#define MPU6050_REGS	128
+#define MPU_WHO_AM_I	0x75
+#define MPU_ACCEL_XOUT	0x3B
+#define MPU_GYRO_XOUT	0x43
+#define SENSOR_RATE_US	1000			// MPU6050 output rate
+
+#define SBUS_BYTES		25
+#define SBUS_BYTE_US	120				// 12 bits (8E2 + start) at 100kbit/s
+#define SBUS_CENTER		992
+#define SBUS_MIN		172
+
+#define EEPROM_SIZE		2048
+
+typedef struct
+{
+	uint64_t	min;
+	uint64_t	max;
+	uint64_t	total;
+	uint32_t	calls;
+} cycle_stats_t;
+
+typedef struct
+{
+	// Stage accounting
+	uint8_t			stage;
+	uint64_t		stage_start;
+	uint64_t		loop_start;
+	int				recording;
+	cycle_stats_t	stages[MAX_STAGES];
+	cycle_stats_t	loop;
+
+	// MPU6050 model
+	avr_irq_t		*twi_irq;
+	uint8_t			twi_selected;
+	uint8_t			twi_index;
+	uint8_t			reg;
+	uint8_t			regs[MPU6050_REGS];
+	uint32_t		sensor_ticks;
+
+	// S.Bus model
+	avr_irq_t		*uart_in;
+	uint8_t			frame[SBUS_BYTES];
+	uint8_t			frame_pos;
+	uint32_t		frame_count;
+	uint32_t		frame_us;
+} sim_t;
+
+static const char *twi_irq_names[2] =
+{
+	[TWI_IRQ_INPUT] = "8>mpu6050.out",
+	[TWI_IRQ_OUTPUT] = "32<mpu6050.in",
+};
+
+//************************************************************
+// Stage accounting
+//************************************************************
+
+static void account(cycle_stats_t *s, uint64_t cycles)
+{
+	if ((s->calls == 0) || (cycles < s->min)) s->min = cycles;
+	if (cycles > s->max) s->max = cycles;
+	s->total += cycles;
+	s->calls++;
+}
+
+static void stage_write(struct avr_t *avr, avr_io_addr_t addr, uint8_t v, void *param)
+{
+	sim_t *p = (sim_t *)param;
+	uint64_t now = avr->cycle;
+
+	if (p->recording && (p->stage < MAX_STAGES))
+	{
+		account(&p->stages[p->stage], now - p->stage_start);
+	}
+
+	if (v == sim_stage_loop())
+	{
+		if (p->recording && p->loop_start)
+		{
+			account(&p->loop, now - p->loop_start);
+		}
+		p->loop_start = now;
+	}
+
+	p->stage = v;
+	p->stage_start = now;
+	avr->data[addr] = v;
+}
+
+//************************************************************
+// MPU6050 - register file with auto-increment, as the real part
+//************************************************************
+
+static void put_word(uint8_t *regs, uint8_t reg, int16_t value)
+{
+	regs[reg] = (uint8_t)((uint16_t)value >> 8);
+	regs[reg + 1] = (uint8_t)value;
+}
+
+static avr_cycle_count_t sensor_update(struct avr_t *avr, avr_cycle_count_t when, void *param)
+{
+	sim_t *p = (sim_t *)param;
+	double t = p->sensor_ticks * (SENSOR_RATE_US / 1000000.0);
+	double move = (t > 4.0) ? 1.0 : 0.0;	// Hold still for the startup gyro calibration
+
+	put_word(p->regs, MPU_ACCEL_XOUT, (int16_t)(move * 1400.0 * sin(t * 1.3)));
+	put_word(p->regs, MPU_ACCEL_XOUT + 2, (int16_t)(move * 1100.0 * sin(t * 0.9)));
+	put_word(p->regs, MPU_ACCEL_XOUT + 4, 8192);
+	put_word(p->regs, MPU_GYRO_XOUT, (int16_t)(move * 900.0 * cos(t * 0.9)));
+	put_word(p->regs, MPU_GYRO_XOUT + 2, (int16_t)(move * 1200.0 * cos(t * 1.3)));
+	put_word(p->regs, MPU_GYRO_XOUT + 4, (int16_t)(move * 300.0 * sin(t * 0.4)));
+
+	p->sensor_ticks++;
+
+	return when + avr_usec_to_cycles(avr, SENSOR_RATE_US);
+}
+
+static void twi_hook(struct avr_irq_t *irq, uint32_t value, void *param)
+{
+	sim_t *p = (sim_t *)param;
+	avr_twi_msg_irq_t v;
+
+	v.u.v = value;
+
+	if (v.u.twi.msg & TWI_COND_STOP)
+	{
+		p->twi_selected = 0;
+	}
+
+	if (v.u.twi.msg & TWI_COND_START)
+	{
+		p->twi_selected = 0;
+		p->twi_index = 0;
+
+		if ((v.u.twi.addr & 0xFE) == MPU6050_ADDR)
+		{
+			p->twi_selected = v.u.twi.addr;
+			avr_raise_irq(p->twi_irq + TWI_IRQ_INPUT, avr_twi_irq_msg(TWI_COND_ACK, p->twi_selected, 1));
+		}
+	}
+
+	if (p->twi_selected)
+	{
+		if (v.u.twi.msg & TWI_COND_WRITE)
+		{
+			avr_raise_irq(p->twi_irq + TWI_IRQ_INPUT, avr_twi_irq_msg(TWI_COND_ACK, p->twi_selected, 1));
+
+			// First byte is the register pointer, then data
+			if (p->twi_index == 0)
+			{
+				p->reg = v.u.twi.data & (MPU6050_REGS - 1);
+			}
+			else
+			{
+				p->regs[p->reg] = v.u.twi.data;
+				p->reg = (p->reg + 1) & (MPU6050_REGS - 1);
+			}
+
+			p->twi_index++;
+		}
+
+		if (v.u.twi.msg & TWI_COND_READ)
+		{
+			avr_raise_irq(p->twi_irq + TWI_IRQ_INPUT, avr_twi_irq_msg(TWI_COND_READ, p->twi_selected, p->regs[p->reg]));
+			p->reg = (p->reg + 1) & (MPU6050_REGS - 1);
+		}
+	}
+}
+
+static void mpu6050_attach(struct avr_t *avr, sim_t *p)
+{
+	p->regs[MPU_WHO_AM_I] = 0x68;
+	put_word(p->regs, MPU_ACCEL_XOUT + 4, 8192);
+
+	p->twi_irq = avr_alloc_irq(&avr->irq_pool, 0, 2, twi_irq_names);
+	avr_irq_register_notify(p->twi_irq + TWI_IRQ_OUTPUT, twi_hook, p);
+
+	avr_connect_irq(p->twi_irq + TWI_IRQ_INPUT, avr_io_getirq(avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_INPUT));
+	avr_connect_irq(avr_io_getirq(avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_OUTPUT), p->twi_irq + TWI_IRQ_OUTPUT);
+
+	avr_cycle_timer_register_usec(avr, SENSOR_RATE_US, sensor_update, p);
+}
+
+//************************************************************
+// S.Bus receiver - 16 x 11-bit channels, LSB first
+//************************************************************
+
+static void sbus_build(sim_t *p)
+{
+	uint16_t ch[16];
+	double t = p->frame_count * (p->frame_us / 1000000.0);
+	uint32_t bits = 0;
+	uint8_t nbits = 0, pos = 1, i;
+
+	for (i = 0; i < 16; i++)
+	{
+		ch[i] = SBUS_CENTER;
+	}
+
+	// Futaba order: AIL, ELE, THR, RUD. Throttle stays low so that the
+	// board doesn't latch a throttle-high error at startup.
+	ch[0] = SBUS_CENTER + (int16_t)(300.0 * sin(t * 0.7));
+	ch[1] = SBUS_CENTER + (int16_t)(300.0 * sin(t * 0.5));
+	ch[2] = SBUS_MIN;
+	ch[3] = SBUS_CENTER + (int16_t)(150.0 * sin(t * 0.3));
+
+	memset(p->frame, 0, sizeof(p->frame));
+	p->frame[0] = 0x0F;
+
+	for (i = 0; i < 16; i++)
+	{
+		bits |= (uint32_t)(ch[i] & 0x7FF) << nbits;
+		nbits += 11;
+
+		while (nbits >= 8)
+		{
+			p->frame[pos++] = (uint8_t)bits;
+			bits >>= 8;
+			nbits -= 8;
+		}
+	}
+
+	p->frame[23] = 0x00;					// No failsafe, no lost frame
+	p->frame[24] = 0x00;
+	p->frame_count++;
+}
+
+static avr_cycle_count_t sbus_byte(struct avr_t *avr, avr_cycle_count_t when, void *param)
+{
+	sim_t *p = (sim_t *)param;
+
+	if (p->frame_pos == 0)
+	{
+		sbus_build(p);
+	}
+
+	avr_raise_irq(p->uart_in, p->frame[p->frame_pos]);
+	p->frame_pos++;
+
+	if (p->frame_pos < SBUS_BYTES)
+	{
+		return when + avr_usec_to_cycles(avr, SBUS_BYTE_US);
+	}
+
+	// Wait for the next frame
+	p->frame_pos = 0;
+	return when + avr_usec_to_cycles(avr, p->frame_us - ((SBUS_BYTES - 1) * SBUS_BYTE_US));
+}
+
+static void sbus_attach(struct avr_t *avr, sim_t *p)
+{
+	uint32_t flags = 0;
+
+	// Keep simavr from echoing UART traffic to the console
+	avr_ioctl(avr, AVR_IOCTL_UART_GET_FLAGS('0'), &flags);
+	flags &= ~AVR_UART_FLAG_STDIO;
+	avr_ioctl(avr, AVR_IOCTL_UART_SET_FLAGS('0'), &flags);
+
+	p->uart_in = avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('0'), UART_IRQ_INPUT);
+	avr_cycle_timer_register_usec(avr, 100000, sbus_byte, p);
+}
+
+//************************************************************
+// Report
+//************************************************************
+
+static double to_us(double cycles)
+{
+	return cycles * 1000000.0 / F_CPU_HZ;
+}
+
+static void report(const sim_t *p, uint8_t servo_rate, uint8_t imu_type, double seconds)
+{
+	uint8_t i;
+	const cycle_stats_t *s;
+
+	printf("\nServo_rate %s, %s IMU: %u loops in %.1fs simulated", sim_rate_name(servo_rate), sim_imu_name(imu_type), p->loop.calls, seconds);
+
+	if (p->loop.calls)
+	{
+		printf(", %.1f Hz mean loop rate\n", F_CPU_HZ / ((double)p->loop.total / p->loop.calls));
+	}
+	else
+	{
+		printf("\n");
+	}
+
+	printf("%-22s %8s %10s %10s %10s %10s %12s\n",
+		"stage", "calls", "min cyc", "mean cyc", "max cyc", "max us", "cyc/loop");
+
+	for (i = 0; i < sim_stage_count(); i++)
+	{
+		s = &p->stages[i];
+		if (s->calls == 0) continue;
+
+		printf("%-22s %8u %10llu %10.0f %10llu %10.1f %12.0f\n", sim_stage_name(i), s->calls,
+			(unsigned long long)s->min, (double)s->total / s->calls, (unsigned long long)s->max,
+			to_us((double)s->max), p->loop.calls ? (double)s->total / p->loop.calls : 0.0);
+	}
+
+	s = &p->loop;
+	if (s->calls)
+	{
+		printf("%-22s %8u %10llu %10.0f %10llu %10.1f\n", "whole loop", s->calls,
+			(unsigned long long)s->min, (double)s->total / s->calls, (unsigned long long)s->max,
+			to_us((double)s->max));
+	}
+}
+
+//************************************************************
+// Run one Servo_rate mode and IMU_type from a fresh boot
+//************************************************************
+
+static int run_mode(elf_firmware_t *fw, const char *mcu, uint8_t servo_rate, uint8_t imu_type, double warmup, double seconds, uint32_t frame_us)
+{
+	static uint8_t image[EEPROM_SIZE];
+	avr_eeprom_desc_t ee;
+	avr_t *avr;
+	sim_t *p;
+	uint64_t start, end;
+	uint8_t i;
+	int state = cpu_Running;
+
+	avr = avr_make_mcu_by_name(mcu);
+	if (avr == NULL)
+	{
+		fprintf(stderr, "simavr does not know mcu '%s'\n", mcu);
+		return -1;
+	}
+
+	p = calloc(1, sizeof(sim_t));
+	p->frame_us = frame_us;
+
+	avr_init(avr);
+	avr_load_firmware(avr, fw);
+	avr->frequency = F_CPU_HZ;
+
+	// Factory defaults with the requested Servo_rate and IMU_type
+	ee.ee = image;
+	ee.offset = 0;
+	ee.size = sim_config_image(image, sizeof(image), servo_rate, imu_type);
+	avr_ioctl(avr, AVR_IOCTL_EEPROM_SET, &ee);
+
+	// Buttons are active low - release them all
+	for (i = 4; i < 8; i++)
+	{
+		avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), i), 1);
+	}
+
+	avr_register_io_write(avr, GPIOR0_ADDR, stage_write, p);
+	mpu6050_attach(avr, p);
+	sbus_attach(avr, p);
+
+	// Boot, calibrate and settle before recording
+	end = (uint64_t)(warmup * F_CPU_HZ);
+	while ((avr->cycle < end) && (state != cpu_Done) && (state != cpu_Crashed))
+	{
+		state = avr_run(avr);
+	}
+
+	p->recording = 1;
+	p->loop_start = 0;
+	start = avr->cycle;
+	end = start + (uint64_t)(seconds * F_CPU_HZ);
+
+	while ((avr->cycle < end) && (state != cpu_Done) && (state != cpu_Crashed))
+	{
+		state = avr_run(avr);
+	}
+
+	if (state == cpu_Crashed)
+	{
+		fprintf(stderr, "firmware crashed at pc 0x%04x\n", avr->pc);
+	}
+
+	report(p, servo_rate, imu_type, (double)(avr->cycle - start) / F_CPU_HZ);
+
+	avr_terminate(avr);
+	free(p);
+
+	return (state == cpu_Crashed) ? -1 : 0;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-m mcu] [-r rate] [-i imu] [-w seconds] [-t seconds] [-f ms] firmware.elf\n"
+		"  -m  simavr core (default atmega644p)\n"
+		"  -r  0 = LOW, 1 = SYNC, 2 = FAST (default: all three)\n"
+		"  -i  0 = vector, 1 = quaternion IMU (default: both)\n"
+		"  -w  warm-up before recording (default 6s, covers gyro calibration)\n"
+		"  -t  recorded time per mode (default 5s)\n"
+		"  -f  S.Bus frame period in ms (default 14, 7 for high speed)\n",
+		prog);
+}
+
+int main(int argc, char **argv)
+{
+	elf_firmware_t fw;
+	const char *mcu = "atmega644p";
+	double warmup = 6.0, seconds = 5.0;
+	uint32_t frame_us = 14000;
+	int rate = -1, imu = -1, r, i, opt, result = 0;
+
+	while ((opt = getopt(argc, argv, "m:r:i:w:t:f:h")) != -1)
+	{
+		switch(opt)
+		{
+			case 'm': mcu = optarg; break;
+			case 'r': rate = atoi(optarg); break;
+			case 'i': imu = atoi(optarg); break;
+			case 'w': warmup = atof(optarg); break;
+			case 't': seconds = atof(optarg); break;
+			case 'f': frame_us = (uint32_t)(atof(optarg) * 1000.0); break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+
+	if ((optind >= argc) || (rate >= SIM_SERVO_RATES) || (imu >= SIM_IMU_TYPES) || (frame_us < (SBUS_BYTES * SBUS_BYTE_US)))
+	{
+		usage(argv[0]);
+		return 1;
+	}
+
+	memset(&fw, 0, sizeof(fw));
+	if (elf_read_firmware(argv[optind], &fw) != 0)
+	{
+		fprintf(stderr, "cannot read %s\n", argv[optind]);
+		return 1;
+	}
+
+	fw.frequency = F_CPU_HZ;
+
+	printf("%s on %s at %d MHz, S.Bus every %.1f ms\n", argv[optind], mcu, F_CPU_HZ / 1000000, frame_us / 1000.0);
+
+	for (r = 0; r < SIM_SERVO_RATES; r++)
+	{
+		if ((rate >= 0) && (r != rate)) continue;
+
+		for (i = 0; i < SIM_IMU_TYPES; i++)
+		{
+			if ((imu >= 0) && (i != imu)) continue;
+
+			if (run_mode(&fw, mcu, (uint8_t)r, (uint8_t)i, warmup, seconds, frame_us) != 0)
+			{
+				result = 1;
+			}
+		}
+	}
+
+	return result;
+}
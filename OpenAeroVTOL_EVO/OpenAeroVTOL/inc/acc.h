@@ -7,8 +7,10 @@
 //***********************************************************
 
 extern void ReadAcc(void);
+extern void ProcessAcc(void);
 extern void CalibrateAcc(int8_t type);
 extern void get_raw_accs(void);
+extern void decode_accs(const uint8_t *Accs);
 
 extern int16_t accADC[NUMBEROFAXIS];
 extern int16_t accVert;
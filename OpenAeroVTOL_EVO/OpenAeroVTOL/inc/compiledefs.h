@@ -14,4 +14,33 @@
 // Debug - choose D-term method
 // Uncommented = average differences in gyros
 // Commented = measure differences in averaged gyros
-#define D_METHOD
\ No newline at end of file
+#define D_METHOD
+
+// Uncomment this to mark main loop stages on GPIOR0 for the
+// simavr cycle profiler (host/sim_profile.c)
+//#define SIM_PROFILE
+
+// Uncomment this to run the attitude estimator in fixed point
+// instead of soft-float (imu.c)
+//#define IMU_FIXED
+
+// Uncomment this to build the quaternion attitude engine, selected by
+// IMU type in the General menu. Otherwise only the vector engine is built (imu.c)
+//#define IMU_QUATERNION
+
+// Uncomment this to sample the MPU6050 at a fixed 1kHz through its FIFO.
+// The IMU and I-terms then use the exact time the samples cover (sensors.c)
+//#define MPU6050_FIFO
+
+// Uncomment this to keep per-stage main loop timing statistics.
+// Button 4 on the status screen steps through them (loop_timing.c)
+//#define LOOP_TIMING
+
+// Uncomment this to time the servo/ESC pulses from the Timer1 compare
+// interrupt instead of the cycle-counted assembly. RC interrupts then
+// stay on in FAST mode (servos_isr.c)
+//#define SERVO_ISR
+
+// Uncomment this to ramp the sticks and throttle from one RC frame to
+// the next in FAST mode, instead of stepping at each frame (rc.c)
+//#define RC_SMOOTHING
\ No newline at end of file
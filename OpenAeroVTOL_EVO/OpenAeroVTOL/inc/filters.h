@@ -0,0 +1,15 @@
+/*********************************************************************
+ * filters.h
+ ********************************************************************/
+
+//***********************************************************
+//* Externals
+//***********************************************************
+
+extern void init_filters(void);
+extern void filter_period(uint32_t period);
+extern void filter_gyros(void);
+extern void filter_accs(void);
+
+extern uint16_t FilterPeriod;
+extern int32_t	AccState[NUMBEROFAXIS];
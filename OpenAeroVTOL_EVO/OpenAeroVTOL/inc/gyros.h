@@ -7,8 +7,10 @@
 //***********************************************************
 
 extern void ReadGyros(void);
+extern void ProcessGyros(void);
 extern void CalibrateGyrosFast(void);
 extern bool CalibrateGyrosSlow(void);
 extern void get_raw_gyros(void);
+extern void decode_gyros(const uint8_t *Gyros);
 
 extern int16_t gyroADC[NUMBEROFAXIS];		// Holds 16-bit gyro values
@@ -7,11 +7,7 @@
 //***********************************************************
 
 extern int16_t	angle[2];
-extern float accSmooth[NUMBEROFAXIS];
+extern int16_t accSmooth[NUMBEROFAXIS];
 
 extern void imu_update(uint32_t period);
 extern void reset_IMU(void);
-
-//extern const uint8_t LPF_lookup[7] PROGMEM;
-extern const float LPF_lookup[8] PROGMEM;
-extern const float LPF_lookup_HS[8] PROGMEM;
\ No newline at end of file
@@ -93,7 +93,7 @@ extern CONFIG_STRUCT Config;
 //***********************************************************
 
 enum RPYArrayIndex 	{ROLL = 0, PITCH, YAW};
-enum RX_Modes		{CPPM_MODE = 0, PWM, SBUS, SPEKTRUM, XTREME};
+enum RX_Modes		{CPPM_MODE = 0, PWM, SBUS, SPEKTRUM, XTREME, CRSF};
 enum RX_Sequ		{JRSEQ = 0, FUTABASEQ};
 enum Polarity 		{NORMAL = 0, REVERSED};
 enum KKoutputs 		{OUT1 = 0, OUT2, OUT3, OUT4, OUT5, OUT6, OUT7, OUT8};
@@ -111,8 +111,12 @@ enum Safety			{ARMED = 0, ARMABLE};
 enum Devices		{ASERVO = 0, DSERVO, MOTOR}; 
 enum Curve			{LINEAR = 0, SINE, SQRTSINE}; 
 enum Filters		{HZ5 = 0, HZ10, HZ21, HZ44, HZ94, HZ184, HZ260, NOFILTER};
+enum IMU_Types		{IMU_VECTOR = 0, IMU_QUAT};
 enum Presets		{QUADX = 0, QUADP, TRICOPTER, BLANK, OPTIONS};
 enum Frames			{BASIC = 0, EDIT, ABORT, LOG};
+enum TWIStatus		{TWI_IDLE = 0, TWI_PENDING, TWI_DONE, TWI_ERROR};
+enum SerialFlags	{RX_FAILSAFE = 4, RX_FRAMELOST, RX_CH18, RX_CH17};
+enum LoopStages		{STAGE_MAIN = 0, STAGE_LOOP, STAGE_RC, STAGE_SENSORS, STAGE_IMU, STAGE_SENSOR_PID, STAGE_CALC_PID, STAGE_MIXER, STAGE_SERVOS, STAGE_OUTPUT, STAGE_OUTPUT_ASM, STAGE_WAIT, STAGE_UI, NUMBEROFSTAGES};
 	
 enum Errors			{NOERR = 0, REBOOT, MANUAL, NOSIGNAL, TIMER};
 
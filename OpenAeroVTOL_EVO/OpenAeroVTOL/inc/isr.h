@@ -4,19 +4,30 @@
 
 #include "io_cfg.h"
 
+//***********************************************************
+//* Defines
+//***********************************************************
+
+// Capture emulation for INT2 (CPPM or rudder). PB2 has no input capture unit,
+// so interrupt handlers and cli() sections that can run for several microseconds
+// call this while they work. An edge that arrives meanwhile is then stamped 
+// when it happens, not when INT2_vect is finally entered.
+#define CPPM_CAPTURE()	do { if ((EIFR & (1 << INTF2)) && (EIMSK & (1 << INT2)) && !CPPM_captured) { CPPM_capture = TCNT1; CPPM_captured = true; } } while (0)
+
 //***********************************************************
 //* Externals
 //***********************************************************
 
 extern volatile uint16_t RxChannel[MAX_RC_CHANNELS]; 
 extern volatile uint16_t TMR0_counter;	
-extern volatile uint16_t checksum;
 extern volatile uint8_t max_chan;
 extern volatile uint8_t ch_num;
 extern volatile bool Interrupted;
 extern volatile bool JitterFlag;
 extern volatile bool JitterGate;
-extern volatile uint16_t FrameRate;
+extern volatile uint16_t CPPM_capture;
+extern volatile bool CPPM_captured;
+extern volatile uint8_t CPPM_frames;
 
 extern uint16_t TIM16_ReadTCNT1(void);
 extern void init_int(void);
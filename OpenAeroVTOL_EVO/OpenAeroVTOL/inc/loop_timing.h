@@ -0,0 +1,12 @@
+/*********************************************************************
+ * loop_timing.h
+ ********************************************************************/
+
+//***********************************************************
+//* Externals
+//***********************************************************
+
+extern void loop_timing_mark(uint8_t stage);
+extern void loop_timing_reset(void);
+
+extern stage_timing_t StageTiming[NUMBEROFSTAGES + 1];
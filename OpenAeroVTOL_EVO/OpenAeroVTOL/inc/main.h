@@ -10,6 +10,18 @@
 #define	PBUFFER_SIZE 25 // Print buffer
 #define	SBUFFER_SIZE 38 // Serial input buffer (Xtreme maximum is 37 bytes)
 
+// Main loop stage marker for the cycle profiler.
+// GPIOR0 is otherwise unused, so each marker is a single OUT instruction.
+// With LOOP_TIMING each marker also stamps TCNT1 (loop_timing.c).
+#ifdef SIM_PROFILE
+#define LOOP_STAGE(stage) GPIOR0 = (stage)
+#elif defined(LOOP_TIMING)
+#define LOOP_STAGE(stage) loop_timing_mark(stage)
+extern void loop_timing_mark(uint8_t stage);
+#else
+#define LOOP_STAGE(stage)
+#endif
+
 //***********************************************************
 //* Externals
 //***********************************************************
@@ -17,7 +29,6 @@
 // Buffers
 extern char pBuffer[PBUFFER_SIZE];
 extern uint8_t	buffer[1024];
-extern char sBuffer[SBUFFER_SIZE];
 
 extern bool	RefreshStatus;
 extern uint32_t ticker_32;	
@@ -34,6 +45,5 @@ extern volatile uint8_t	Alarm_flags;
 extern volatile uint16_t InterruptCount;
 extern volatile uint16_t LoopStartTCNT1;
 extern volatile bool Overdue;
-extern volatile uint8_t	LoopCount;
 
 
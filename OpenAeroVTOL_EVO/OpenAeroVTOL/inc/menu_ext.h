@@ -12,6 +12,7 @@ extern void Display_balance(void);
 extern void Display_sensors(void);
 extern void Display_rcinput(void);
 extern void Display_sticks(void);
+extern void Display_timing(uint8_t stage);
 extern void idle_screen(void);
 
 // Menus
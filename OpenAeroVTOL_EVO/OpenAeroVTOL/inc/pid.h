@@ -8,6 +8,7 @@
 
 extern void Calculate_PID(void);
 extern void Sensor_PID(uint32_t period);
+extern void CompilePID(void);
 
 extern int16_t 	PID_Gyros[FLIGHT_MODES][NUMBEROFAXIS];
 extern int16_t 	PID_ACCs[FLIGHT_MODES][NUMBEROFAXIS];
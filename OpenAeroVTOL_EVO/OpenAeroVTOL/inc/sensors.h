@@ -0,0 +1,15 @@
+/*********************************************************************
+ * sensors.h
+ ********************************************************************/
+
+//***********************************************************
+//* Externals
+//***********************************************************
+
+extern void StartSensors(void);
+extern void ReadSensors(void);
+extern void init_sensor_fifo(void);
+extern void reset_sensor_fifo(void);
+
+extern int16_t sensorTemp;					// Raw MPU6050 temperature
+extern uint32_t SensorInterval;				// Time covered by the last FIFO samples
@@ -0,0 +1,36 @@
+/*********************************************************************
+ * serial_rx.h
+ ********************************************************************/
+
+//***********************************************************
+//* Defines
+//***********************************************************
+
+#define RX_RING_SIZE	128			// Must be a power of 2. Holds 8ms of CRSF at 500Hz, 10ms of S.Bus
+#define RX_RING_START	0x0100		// Entry flag: first byte after a gap of PACKET_TIMER
+#define RX_RING_LOST	0x0200		// Entry flag: bytes before this one were dropped
+#define RX_RING_FLAGS	0x03		// Flag bits of one entry in RxRingFlags[], as (entry >> 8)
+#define RX_FLAG_SHIFT(index) (((index) & 3) << 1) // Position of those bits, four entries per byte
+#define RX_STAMPS		4			// Must be a power of 2. Packet start times waiting to be parsed
+
+//***********************************************************
+//* Externals
+//***********************************************************
+
+extern void RxDecodeSerial(void);
+extern void RxParseByte(uint16_t entry);
+extern uint8_t RxBurstPulses(uint32_t pwm_interval);
+
+extern volatile uint8_t RxRing[RX_RING_SIZE];
+extern volatile uint8_t RxRingFlags[RX_RING_SIZE / 4];
+extern volatile uint8_t RxRingHead;
+extern volatile uint8_t RxRingTail;
+extern volatile uint16_t RxStampTime[RX_STAMPS];
+extern volatile uint8_t RxStampEntry[RX_STAMPS];
+extern volatile uint8_t RxStampHead;
+extern volatile uint8_t RxOverruns;
+extern uint16_t SerialChannel[SERIAL_CHANNELS];
+extern volatile uint8_t RxFlags;
+extern uint8_t RxLinkQuality;
+extern volatile bool RxBlocked;
+extern uint16_t RxFramePeriod;
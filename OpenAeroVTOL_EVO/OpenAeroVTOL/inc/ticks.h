@@ -0,0 +1,19 @@
+/*********************************************************************
+ * ticks.h
+ ********************************************************************/
+
+//***********************************************************
+//* Defines
+//***********************************************************
+
+// Tick counts are 19.531kHz (51.2us) Timer2 ticks
+#define TICKS_ELAPSED(start, now)			((uint32_t)((now) - (start)))
+#define TICKS_EXPIRED(start, now, period)	(TICKS_ELAPSED(start, now) > (uint32_t)(period))
+
+//***********************************************************
+//* Externals
+//***********************************************************
+
+extern uint32_t ticks_now(void);
+
+extern volatile uint32_t T2_overflows;
@@ -0,0 +1,15 @@
+/*********************************************************************
+ * twi_isr.h
+ ********************************************************************/
+
+//***********************************************************
+//* Externals
+//***********************************************************
+
+extern bool twi_read(uint8_t address, uint8_t location, uint8_t *data, uint8_t size, volatile uint8_t *status);
+extern bool twi_write(uint8_t address, uint8_t location, uint8_t *data, uint8_t size, volatile uint8_t *status);
+extern bool twi_wait(volatile uint8_t *status);
+extern void twi_flush(void);
+extern void twi_recover(void);
+
+extern volatile uint8_t TWI_errors;
@@ -13,6 +13,7 @@
 
 #define MAX_RC_CHANNELS 8				// Maximum input channels from RX
 #define MAX_OUTPUTS 8					// Maximum output channels
+#define SERIAL_CHANNELS 16				// Proportional channels in a serial RC frame
 #define MAX_ZGAIN 500					// Maximum amount of Z-based height dampening
 #define	FLIGHT_MODES 2					// Number of flight profiles
 #define NUMBEROFAXIS 3					// Number of axis (Roll, Pitch, Yaw)
@@ -117,6 +118,36 @@ typedef struct
 
 } channel_t;
 
+// Compiled mixer term (3 bytes)
+typedef struct
+{
+	uint8_t		source;					// Mixer source index plus MIXTERM_SUB flag
+	int16_t		gain;					// Signed gain in Q12 (4096 = 100%)
+} mix_term_t;
+
+// Compiled 3-point offset curve (7 bytes)
+typedef struct
+{
+	int16_t		start;					// P1 offset * 128
+	int16_t		step1;					// Step per transition % up to P1.n, * 128
+	int16_t		step2;					// Step per transition % after P1.n, * 128
+	int8_t		knee;					// P1.n position
+} offset_curve_t;
+
+// Compiled flight profile gains for the PID loop, indexed [profile][axis] (96 bytes)
+typedef struct
+{
+	int32_t		I_limit[FLIGHT_MODES][NUMBEROFAXIS];		// I-term output limits
+	int32_t		I_constrain[FLIGHT_MODES][NUMBEROFAXIS];	// I-term input limits
+	int16_t		P_gain[FLIGHT_MODES][NUMBEROFAXIS];			// Gyro P gain * 3
+	int16_t		Yaw_trim[FLIGHT_MODES];						// Gyro yaw trim * 64 * 3
+	int16_t		L_trim[FLIGHT_MODES][2];					// Roll and pitch acc trims in 0.01 degrees
+	int16_t		D_gain[NUMBEROFAXIS];						// Gyro D gain * 2, shared by both profiles
+	int8_t		I_gain[FLIGHT_MODES][NUMBEROFAXIS];
+	int8_t		L_gain[FLIGHT_MODES][NUMBEROFAXIS];			// Acc P gains, Z acc in [YAW]
+	uint8_t		Stick_shift[FLIGHT_MODES][NUMBEROFAXIS];	// Stick rate divider as a right shift
+} flight_profile_t;
+
 // Config settings structure
 typedef struct
 {
@@ -211,6 +242,12 @@ typedef struct
 	int8_t		log_pointer;
 	int8_t		Log[LOGLENGTH];
 
+	// V1.2 items. Always add new items here so that older settings keep their locations (4)
+	int8_t		IMU_type;				// Attitude engine (enum IMU_Types)
+	int8_t		Gyro_notch1;			// Gyro notch centres in 10Hz steps, 0 = off
+	int8_t		Gyro_notch2;
+	int8_t		CPPM_slew;				// CPPM median/slew filter, max change per frame in %, 0 = off
+
 } CONFIG_STRUCT;
 
 
@@ -231,6 +268,37 @@ typedef struct
 	uint16_t	y;
 } mugui_size16_t;
 
+// Main loop timing for one stage (loop_timing.c)
+#define TIMING_BUCKETS 8
+
+typedef struct
+{
+	uint16_t	min;					// Time per loop in TCNT1 ticks (400ns)
+	uint16_t	max;
+	uint32_t	sum;
+	uint16_t	count;					// Loops the stage ran in
+	uint16_t	hist[TIMING_BUCKETS];	// Histogram, bucket widths doubling from 25.6us
+} stage_timing_t;
+
+// Queued TWI transfer (twi_isr.c)
+typedef struct
+{
+	uint8_t		address;				// Device address, write form
+	uint8_t		location;				// First register
+	uint8_t		*data;					// Bytes to write or read buffer
+	uint8_t		size;					// Number of data bytes
+	uint8_t		flags;					// Direction
+	volatile uint8_t *status;			// Set to TWI_DONE or TWI_ERROR when finished
+} twi_request_t;
+
+// Falling edge of one or more servo pulses (servos_isr.c)
+typedef struct
+{
+	uint16_t	time;					// TCNT1 value at the edge
+	uint8_t		port_a;					// PORTA bits to clear
+	uint8_t		port_c;					// PORTC bits to clear
+} servo_edge_t;
+
 
 
 // The following code courtesy of: stu_san on AVR Freaks
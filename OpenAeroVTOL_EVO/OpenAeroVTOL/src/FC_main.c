@@ -145,6 +145,7 @@
 #include "gyros.h"
 #include "init.h"
 #include "acc.h"
+#include "sensors.h"
 #include "isr.h"
 #include "glcd_driver.h"
 #include "pid.h"
@@ -157,6 +158,9 @@
 #include "imu.h"
 #include "eeprom.h"
 #include "uart.h"
+#include "ticks.h"
+#include "serial_rx.h"
+#include "loop_timing.h"
 
 //***********************************************************
 //* Fonts
@@ -178,13 +182,17 @@
 #define TRANSITION_TIMER 195		// Transition timer units (10ms * 100) (1 to 10 = 1s to 10s)
 #define ARM_TIMER 19531				// Amount of time the sticks must be held to trigger arm. Currently one second.
 #define DISARM_TIMER 58593			// Amount of time the sticks must be held to trigger disarm. Currently three seconds.
-#define SBUS_PERIOD	6250			// Period for S.Bus data to be transmitted (no margin) (2.5ms)
-#define SBUS_MARGIN	8750			// Period for S.Bus data to be transmitted (+ 1ms margin) (3.5ms)
 #define PWM_PERIOD 12500			// Average PWM generation period (5ms)
 #define PWM_PERIOD_WORST 20833		// PWM generation period (8.3ms - 120Hz)
 #define PWM_PERIOD_BEST 8333		// PWM generation period (3.333ms - 300Hz)
 #define FASTSYNCLIMIT 293			// Max time from end of PWM to next interrupt (15ms)
 
+// The loop interval times the IMU unless the MPU6050 FIFO times the samples,
+// and sets the FAST mode PWM rate unless the servo ISR generates the PWM
+#if !defined(MPU6050_FIFO) || !defined(SERVO_ISR)
+#define LOOP_INTERVAL
+#endif
+
 //***********************************************************
 //* Code and Data variables
 //***********************************************************
@@ -202,9 +210,6 @@ volatile uint8_t	Alarm_flags = 0;
 // Global buffers
 char pBuffer[PBUFFER_SIZE];			// Print buffer (25 bytes)
 
-// Serial buffer
-char sBuffer[SBUFFER_SIZE];			// Serial buffer (38 bytes)
-
 // Transition matrix
 // Usage: Transition_state = Trans_Matrix[Config.FlightSel][old_flight]
 // Config.FlightSel is where you've been asked to go, and old_flight is where you were.
@@ -220,7 +225,6 @@ const int8_t Trans_Matrix[3][3] PROGMEM =
 volatile uint16_t	InterruptCount = 0;
 volatile uint16_t	LoopStartTCNT1 = 0;
 volatile bool		Overdue = false;
-volatile uint8_t	LoopCount = 0;
 			
 //************************************************************
 //* Main loop
@@ -234,39 +238,33 @@ int main(void)
 	bool PWMBlocked = false;
 	bool RCInterruptsON = false;
 	bool ServoTick = false;
-	bool ResampleRCRate = false;
 	bool PWMOverride = false;
 	bool Interrupted_Clone = false;
 	bool SlowRC = true;
 
 	// 32-bit timers
-	uint32_t Arm_timer = 0;
 	uint32_t RC_Rate_Timer = 0;
 	uint32_t PWM_interval = PWM_PERIOD_WORST;	// Loop period when generating PWM. Initialise with worst case until updated.
 	
 	// 16-bit timers
-	uint16_t Status_timeout = 0;
-	uint16_t UpdateStatus_timer = 0;
-	uint16_t Ticker_Count = 0;
-	uint16_t RC_Timeout = 0;
-	uint16_t Servo_Rate = 0;
-	uint16_t Transition_timeout = 0;
-	uint16_t Disarm_timer = 0;
 	uint16_t Save_TCNT1 = 0;
+#ifdef LOOP_INTERVAL
 	uint16_t ticker_16 = 0;
-	uint16_t fast_sync_timer = 0;
+#endif
 
 	// Timer incrementers
 	uint16_t RC_Rate_TCNT1 = 0;
-	uint8_t Transition_TCNT2 = 0;
-	uint8_t Status_TCNT2 = 0;
-	uint8_t Refresh_TCNT2 = 0;
-	uint8_t Disarm_TCNT2 = 0;
-	uint8_t Arm_TCNT2 = 0;
-	uint8_t Ticker_TCNT2 = 0;
-	uint8_t Servo_TCNT2 = 0;
-	uint8_t ServoRate_TCNT2 = 0;
-	uint8_t fast_sync_TCNT2 = 0;
+
+	// Tick timers. Each holds the tick count at which it was last reset (ticks.h)
+	uint32_t Ticks = 0;				// Tick count for this loop
+	uint32_t Arm_start = 0;			// Stick hold for arm/disarm
+	uint32_t Status_start = 0;		// Status_seconds
+	uint32_t Refresh_start = 0;		// Status screen refresh
+	uint32_t Disarm_start = 0;		// Disarm_seconds
+	uint32_t ServoRate_start = 0;	// LOW rate output
+	uint32_t RC_start = 0;			// Last RC input
+	uint32_t Transition_start = 0;	// Transition steps
+	uint32_t fast_sync_start = 0;
 
 	// Locals
 	uint16_t InterruptCounter = 0;
@@ -281,7 +279,13 @@ int main(void)
 	uint8_t ServoFlag = 0;
 	uint8_t i = 0;
 	int16_t PWM_pulses = 3; 
-	uint32_t interval = 0;			// IMU interval
+#ifdef LOOP_INTERVAL
+	uint32_t interval = 0;			// Loop interval
+#endif
+	uint32_t sample_interval = 0;	// Time covered by this loop's sensor data
+#ifdef LOOP_TIMING
+	uint8_t TimingPage = 0;			// Status screen page. 0 = status, then each loop stage
+#endif
 	
 	// Do all init tasks
 	init();
@@ -289,8 +293,16 @@ int main(void)
 	// Main loop
 	while (1)
 	{
-		// Increment the loop counter
-		LoopCount++;
+		LOOP_STAGE(STAGE_LOOP);
+
+		//************************************************************
+		//* Parse any serial RC bytes received since the last loop.
+		//* This sets Interrupted when a frame completes
+		//************************************************************
+
+		LOOP_STAGE(STAGE_RC);
+		RxDecodeSerial();
+		LOOP_STAGE(STAGE_MAIN);
 		
 		//************************************************************
 		//* Check for interruption of PWM generation
@@ -306,25 +318,18 @@ int main(void)
 		//************************************************************
 		//* Once per second events
 		//* - Increment Status_seconds
-		//* - Do an RC rate resample
 		//* - Check the battery voltage
 		//************************************************************
 
 		// Count elapsed seconds
-		if (Status_timeout > SECOND_TIMER)
+		if (TICKS_EXPIRED(Status_start, Ticks, SECOND_TIMER))
 		{
 			Status_seconds++;
-			Status_timeout = 0;
+			Status_start = Ticks;
 
 			// Update the interrupt count each second
 			InterruptCount = InterruptCounter;
 			InterruptCounter = 0;
-			
-			// Re-measure the frame rate in FAST mode every second
-			if (Config.Servo_rate == FAST)
-			{
-				ResampleRCRate = true;
-			}
 	
 			// Check if Vbat lower than trigger
 			if (GetVbat() < Config.PowerTriggerActual)
@@ -352,6 +357,8 @@ int main(void)
 		// it will set this flag
 		PWMOverride = false; 
 
+		LOOP_STAGE(STAGE_UI);
+
 		switch(Menu_mode) 
 		{
 			// In IDLE mode, the text "Press for status" is displayed ONCE.
@@ -405,9 +412,16 @@ int main(void)
 			// Status screen first display
 			case STATUS:
 				// Reset the status screen period
-				UpdateStatus_timer = 0;
+				Refresh_start = Ticks;
 
 				// Update status screen
+#ifdef LOOP_TIMING
+				if (TimingPage != 0)
+				{
+					Display_timing(TimingPage - 1);
+				}
+				else
+#endif
 				Display_status();
 				
 				// Prevent PWM output just after updating the LCD
@@ -421,7 +435,11 @@ int main(void)
 			// This is designed to stop the menu appearing instead of the status screen
 			// as it will stay in this state until the button is released
 			case WAITING_TIMEOUT_BD:
+#ifdef LOOP_TIMING
+				if((BUTTON1 == 0) || (BUTTON3 == 0) || (BUTTON4 == 0))
+#else
 				if(BUTTON1 == 0)
+#endif
 				{
 					Menu_mode = WAITING_TIMEOUT_BD;
 				}
@@ -452,8 +470,35 @@ int main(void)
 					PWMOverride = true;
 				}
 
+#ifdef LOOP_TIMING
+				// Step to the next loop timing page
+				else if(BUTTON4 == 0)
+				{
+					TimingPage++;
+
+					// Pages for each stage and the whole loop, then back to status
+					if (TimingPage > (NUMBEROFSTAGES + 1))
+					{
+						TimingPage = 0;
+					}
+
+					Status_seconds = 0;
+					Menu_mode = PRESTATUS;
+					PWMOverride = true;
+				}
+
+				// Clear the loop timing statistics
+				else if((BUTTON3 == 0) && (TimingPage != 0))
+				{
+					loop_timing_reset();
+					Status_seconds = 0;
+					Menu_mode = PRESTATUS;
+					PWMOverride = true;
+				}
+#endif
+
 				// Update status screen four times/sec while waiting to time out
-				else if (UpdateStatus_timer > (SECOND_TIMER >> 2))
+				else if (TICKS_EXPIRED(Refresh_start, Ticks, (SECOND_TIMER >> 2)))
 				{
 					Menu_mode = PRESTATUS;
 
@@ -545,6 +590,10 @@ int main(void)
 				Status_seconds = 0;
 				// Reset IMU on return from menu
 				reset_IMU();
+#ifdef LOOP_TIMING
+				// The time spent in the menu would swamp the statistics
+				loop_timing_reset();
+#endif
 				
 				// Prevent PWM output
 				PWMOverride = true;
@@ -555,6 +604,8 @@ int main(void)
 				break;
 		}
 
+		LOOP_STAGE(STAGE_MAIN);
+
 		//************************************************************
 		//* Alarms
 		//************************************************************
@@ -612,21 +663,21 @@ int main(void)
 				(ARM_TIMER_RESET_2 < MonopolarThrottle)
 			   )
 			{
-				Arm_timer = 0;
+				Arm_start = Ticks;
 			}
 			
 			// If disarmed
 			if ((General_error & (1 << DISARMED)) != 0)
 			{
 				// Reset auto-disarm count
-				Disarm_timer = 0;
+				Disarm_start = Ticks;
 				Disarm_seconds = 0;
 								
 				// If arm timer times out, the sticks must have been at extremes for ARM_TIMER seconds
 				// If aileron is at min, arm the FC
-				if ((Arm_timer > ARM_TIMER) && (RCinputs[AILERON] < -ARM_TIMER_RESET_1))
+				if (TICKS_EXPIRED(Arm_start, Ticks, ARM_TIMER) && (RCinputs[AILERON] < -ARM_TIMER_RESET_1))
 				{
-					Arm_timer = 0;
+					Arm_start = Ticks;
 					General_error &= ~(1 << DISARMED);		// Set flags to armed (negate disarmed)
 					CalibrateGyrosSlow();					// Calibrate gyros
 					LED1 = 1;								// Signal that FC is ready
@@ -638,9 +689,9 @@ int main(void)
 			else 
 			{
 				// Disarm the FC after DISARM_TIMER seconds if aileron at max
-				if ((Arm_timer > DISARM_TIMER) && (RCinputs[AILERON] > ARM_TIMER_RESET_1))
+				if (TICKS_EXPIRED(Arm_start, Ticks, DISARM_TIMER) && (RCinputs[AILERON] > ARM_TIMER_RESET_1))
 				{
-					Arm_timer = 0;
+					Arm_start = Ticks;
 					General_error |= (1 << DISARMED);		// Set flags to disarmed
 					LED1 = 0;								// Signal that FC is now disarmed
 #ifdef ERROR_LOG
@@ -652,15 +703,15 @@ add_log(MANUAL);
 				// Reset auto-disarm count if any RX activity or set to zero
 				if ((Flight_flags & (1 << RxActivity)) || (Config.Disarm_timer == 0))
 				{
-					Disarm_timer = 0;
+					Disarm_start = Ticks;
 					Disarm_seconds = 0;
 				}
 		
 				// Increment disarm timer (seconds) if armed
-				if (Disarm_timer > SECOND_TIMER)
+				if (TICKS_EXPIRED(Disarm_start, Ticks, SECOND_TIMER))
 				{
 					Disarm_seconds++;
-					Disarm_timer = 0;
+					Disarm_start = Ticks;
 				}
 
 				// Auto-disarm model if timeout enabled and due
@@ -693,7 +744,9 @@ add_log(TIMER);
 			//************************************************************
 
 			// Update zeroed RC channel data
+			LOOP_STAGE(STAGE_RC);
 			RxGetChannels();
+			LOOP_STAGE(STAGE_MAIN);
 
 			// Check for throttle reset
 			if (MonopolarThrottle < THROTTLEIDLE)
@@ -817,11 +870,11 @@ add_log(TIMER);
 			transition_time = TRANSITION_TIMER * Config.TransitionSpeed;
 		
 			// Update state, values and transition_counter every Config.TransitionSpeed if not zero.
-			if (((Config.TransitionSpeed != 0) && (Transition_timeout > transition_time)) ||
+			if (((Config.TransitionSpeed != 0) && TICKS_EXPIRED(Transition_start, Ticks, transition_time)) ||
 				// Update immediately
 				TransitionUpdated)
 			{
-				Transition_timeout = 0;
+				Transition_start = Ticks;
 				TransitionUpdated = false;
 
 				// Fixed, end-point states
@@ -915,6 +968,13 @@ add_log(TIMER);
 			old_flight = Config.FlightSel;
 
 		} // Interrupted
+
+#ifdef RC_SMOOTHING
+		// Ramp the sticks and throttle between RC frames in FAST mode
+		LOOP_STAGE(STAGE_RC);
+		RC_Smooth();
+		LOOP_STAGE(STAGE_MAIN);
+#endif
 				
 		//************************************************************
 		//* Update timers
@@ -938,48 +998,18 @@ add_log(TIMER);
 		
 		RC_Rate_TCNT1 = Save_TCNT1;
 
-		// Arm timer for timing stick hold
-		Arm_timer += (uint8_t)(TCNT2 - Arm_TCNT2); 
-		Arm_TCNT2 = TCNT2;
-
-		// 16-bit timers (Max. 3.35s measurement on T2)
-		// All TCNT2 timers increment at 19.531 kHz
-
-		// Sets the desired SERVO_RATE by flagging ServoTick when PWM due
-		Servo_Rate += (uint8_t)(TCNT2 - ServoRate_TCNT2);
-		ServoRate_TCNT2 = TCNT2;
-		
-		// Signal RC overdue after RC_OVERDUE time (500ms)
-		RC_Timeout += (uint8_t)(TCNT2 - Servo_TCNT2);
-		Servo_TCNT2 = TCNT2;
-		
-		// Update transition timer
-		Transition_timeout += (uint8_t)(TCNT2 - Transition_TCNT2);
-		Transition_TCNT2 = TCNT2;
-
-		// Update status timeout
-		Status_timeout += (uint8_t)(TCNT2 - Status_TCNT2);
-		Status_TCNT2 = TCNT2;
-		
-		// Status refresh timer
-		UpdateStatus_timer += (uint8_t)(TCNT2 - Refresh_TCNT2);
-		Refresh_TCNT2 = TCNT2;
-
-		// Auto-disarm timer
-		Disarm_timer += (uint8_t)(TCNT2 - Disarm_TCNT2);
-		Disarm_TCNT2 = TCNT2;
-
-		// Timer for audible alarms
-		Ticker_Count += (uint8_t)(TCNT2 - Ticker_TCNT2);
-		Ticker_TCNT2 = TCNT2;
+		// Sample the system tick once per loop. All the tick timers
+		// (arm, disarm, status, transition, RC timeout and servo rate)
+		// measure from this value at 19.531 kHz
+		Ticks = ticks_now();
 
 		//************************************************************
-		//* System ticker - based on TCNT2 (19.531kHz)
+		//* System ticker - based on the system tick (19.531kHz)
 		//* 
-		//* ((Ticker_Count >> 8) &8) 	= 4.77Hz (Disarm and LVA alarms)
+		//* ((Ticks >> 8) &8) 	= 4.77Hz (Disarm and LVA alarms)
 		//************************************************************
 
-		if ((Ticker_Count >> 8) &8) 
+		if ((Ticks >> 8) &8) 
 		{
 			Alarm_flags |= (1 << BUZZER_ON);	// 4.77Hz beep
 		}
@@ -994,18 +1024,18 @@ add_log(TIMER);
 		//************************************************************
 
 		// Flag update required based on the variable Servo_Match
-		if (Servo_Rate > SERVO_RATE_LOW)
+		if (TICKS_EXPIRED(ServoRate_start, Ticks, SERVO_RATE_LOW))
 		{
 			ServoTick = true;	// Slow device is ready for output generation
-			Servo_Rate = 0;
+			ServoRate_start = Ticks;
 		}
 		
 		//************************************************************
 		//* Measure incoming RC rate and flag no signal
 		//************************************************************
 
-		// Check to see if the RC input is overdue (500ms)
-		if (RC_Timeout > RC_OVERDUE)
+		// Check to see if the RC input is overdue (500ms) or the serial receiver reports failsafe
+		if (TICKS_EXPIRED(RC_start, Ticks, RC_OVERDUE) || (RxFlags & (1 << RX_FAILSAFE)))
 		{
 #ifdef ERROR_LOG
 			// Log the no signal event if previously NOT overdue, armable and armed
@@ -1022,8 +1052,9 @@ add_log(TIMER);
 		//* Read sensors
 		//************************************************************
 
-		ReadGyros();
-		ReadAcc();
+		LOOP_STAGE(STAGE_SENSORS);
+		ReadSensors();
+		LOOP_STAGE(STAGE_MAIN);
 		
 		//************************************************************
 		//* Update IMU
@@ -1039,6 +1070,7 @@ add_log(TIMER);
 		// Reset Timer0 count
 		TCNT0 = 0;
 
+#ifdef LOOP_INTERVAL
 		// Handle TCNT1 overflow correctly - this actually seems necessary...
 		// ticker_16 will hold the most recent amount measured by TCNT1
 		// Timer1 (16bit) - run @ 2.5MHz (400ns) - max 26.2ms
@@ -1051,9 +1083,6 @@ add_log(TIMER);
 			ticker_16 = (Save_TCNT1 - LoopStartTCNT1);
 		}
 		
-		// Store old TCNT for next measurement
-		LoopStartTCNT1 = Save_TCNT1;
-		
 		// Handle both Timer1 under- and over-run cases
 		// If TMR0_counter is less than 2, ICNT1 has not overflowed
 		if (TMR0_counter < 2)
@@ -1069,28 +1098,57 @@ add_log(TIMER);
 		{
 			interval = ticker_16 + (TMR0_counter * 32768);
 		}
+#endif
+
+		// Store old TCNT for next measurement
+		LoopStartTCNT1 = Save_TCNT1;
 
 		TMR0_counter = 0;
+
+#ifdef MPU6050_FIFO
+		// The samples were timed by the MPU6050, so the IMU and I-terms
+		// use the time they cover rather than the loop time
+		sample_interval = SensorInterval;
+#else
+		sample_interval = interval;
+#endif
 	
 		//************************************************************
 		//* Update attitude, average acc values each loop
+		//* With no new sensor data, leave the attitude and I-terms alone
 		//************************************************************
 				
-		imu_update(interval);
+		if (sample_interval != 0)
+		{
+			LOOP_STAGE(STAGE_IMU);
+			imu_update(sample_interval);
+
+			//************************************************************
+			//* Update I-terms, average gyro values each loop
+			//************************************************************
+
+			LOOP_STAGE(STAGE_SENSOR_PID);
+			Sensor_PID(sample_interval);
+			LOOP_STAGE(STAGE_MAIN);
+		}
 
 		//************************************************************
-		//* Update I-terms, average gyro values each loop
+		//* Start the next sensor read now that this one is used.
+		//* The TWI interrupt collects it while the PID and mixer run.
+		//* ReadSensors() collects it next loop, so the IMU and PID
+		//* use samples taken up to one loop period earlier than if
+		//* the read were started and waited for there.
 		//************************************************************
 
-		Sensor_PID(interval);
+		StartSensors();
 		
 		//************************************************************
 		//* This is where things start getting really tricky... 
 		//* Use the Interrupted state to measure the RC rate.
 		//* Result in SlowRC state.
 		//* 
-		//* RCrateMeasured = Gap between two interrupts successfully measured.
-		//* FrameRate = Serial frame gap as measured by the ISR.
+		//* RCrateMeasured = RC frame period known.
+		//* RxFramePeriod = Serial frame period estimated by serial_rx.c.
 		//* PWM_interval = Copied from Interval, is the current loop rate.
 		//* 
 		//************************************************************
@@ -1111,109 +1169,25 @@ add_log(TIMER);
 				}
 			}
 			
-			// Use Framerate in FAST mode, but only when NOT skipping frames
-			if ((!RCrateMeasured) && (Config.Servo_rate == FAST))
+			// In FAST mode the frame period estimate keeps running while RC 
+			// interrupts are blocked, as it allows for the frames missed.
+			else
 			{
-				// In high-speed mode, the RC rate will be unfairly marked as "slow" once measured and interrupt blocking starts.
-				// To stop this being a problem, only set SlowRC prior to RCrateMeasured becoming true in this mode
-				if (FrameRate > SLOW_RC_RATE)
-				{
-					SlowRC = true;
-				}
-				else
-				{
-					SlowRC = false;
-				}	
-
-				// Once the high speed rate has been calculated, signal that PWM is good to go.
-				RCrateMeasured = true;
+				RCrateMeasured = (RxFramePeriod != 0);
 			}
 
 			//***********************************************************************
-			//* Work out the high speed mode RC blocking period when requested. 
+			//* Work out the high speed mode RC blocking period for each frame. 
 			//* Only relevant for high speed mode. The slower the PWM rate the fewer
-			//* PWM pulses will fit in the serial data gap.
+			//* PWM pulses will fit before the next packet that can be caught.
 			//***********************************************************************
 
 			if (RCrateMeasured && (Config.Servo_rate == FAST))
 			{
-				// Slow packets (19.7ms gap). Pulse spans just two input packets.
-				// 38.8s available space for S.Bus, 40ms for Satellite and 39.92ms for Xtreme.
-				// Each PWM period is about 2.6ms so we need to see how many will fit before the next packet.
-				// It is easiest to assume that say 38ms is safe for all formats.
-
-				if (SlowRC)
-				{
-					PWM_pulses = 4;				// Four pulses will fit if interval faster than 103Hz
-				
-					if (PWM_interval < 19400)	// 19600 = 7.76ms
-					{
-						PWM_pulses += 1;		// One more pulse will fit if interval faster than 129Hz
-					}
-				
-					if (PWM_interval < 16166)	// 16333 = 6.46ms
-					{
-						PWM_pulses += 1;		// One more pulse will fit if interval faster than 154Hz
-					}
-				
-					if (PWM_interval < 13857)	// 14000 = 5.5ms
-					{
-						PWM_pulses += 1;		// One more pulse will fit if interval faster than 180Hz
-					}
-				
-					if (PWM_interval < 12125)	// 12250 = 4.85ms
-					{
-						PWM_pulses += 1;		// One more pulse will fit if interval faster than 206Hz
-					}
-				
-					if (PWM_interval < 10700)	// 10888 = 4.3ms
-					{
-						PWM_pulses += 1;		// One more pulse will fit if interval faster than 232Hz
-					}
-				
-					if (PWM_interval < 9700)	// 9800 = 3.88ms
-					{
-						PWM_pulses += 1;		// One more pulse will fit if interval faster than 257Hz
-					}
-				}
-
-				// Fast packets (9ms gap). Pulse spans three input packets.
-				// 30ms available space for S.Bus, 31.5ms for Satellite and Xtreme.
-				// Each PWM period is about 2.6ms so we need to see how many will fit before the next packet.
-				// It is easiest to assume that say 29ms is safe for all formats.
-
-				else
-				{
-					PWM_pulses = 3;				// Three pulses will fit if interval faster than 103Hz
-				
-					if (PWM_interval < 18125)	// 18125 = 7.25ms
-					{
-						PWM_pulses += 1;		// One more pulse will fit if interval faster than 138Hz
-					}
-				
-					if (PWM_interval < 14500)	// 14500 = 5.8ms
-					{
-						PWM_pulses += 1;		// One more pulse will fit if interval faster than 172Hz
-					}
-				
-					if (PWM_interval < 12083)	// 12083 = 4.83ms
-					{
-						PWM_pulses += 1;		// One more pulse will fit if interval faster than 206Hz
-					}
-				
-					if (PWM_interval < 10357)	// 10357 = 4.14ms
-					{
-						PWM_pulses += 1;		// One more pulse will fit if interval faster than 241Hz
-					}
-				
-					if (PWM_interval < 9062)	// 9062 = 3.62ms
-					{
-						PWM_pulses += 1;		// One more pulse will fit if interval faster than 275Hz
-					}
-				}
+				PWM_pulses = RxBurstPulses(PWM_interval);
 			}
 			
-			// Rate not measured or re-calibrating or not FAST mode
+			// Rate not measured or not FAST mode
 			// In all these other modes, just output one pulse
 			else
 			{
@@ -1221,10 +1195,10 @@ add_log(TIMER);
 			}
 
 			// Reset RC timeout now that Interrupt has been received.
-			RC_Timeout = 0;
+			RC_start = Ticks;
 
-			// No longer overdue. This will cancel the "No signal" alarm
-			Overdue = false;
+			// No longer overdue unless the receiver is in failsafe. This will cancel the "No signal" alarm
+			Overdue = ((RxFlags & (1 << RX_FAILSAFE)) != 0);
 			
 			// Reset rate timer once data received. Reset to current time.
 			RC_Rate_Timer = 0;
@@ -1242,31 +1216,25 @@ add_log(TIMER);
 			// and PWM mode is FAST.
 			if ((Config.Servo_rate == FAST) && RCrateMeasured)
 			{
-				// If it's time to resample the RC rate, do it now
-				// so as not to disturb PWM generation.
-				// This will result in a double gap with just one PWM.
-				if (ResampleRCRate)
-				{
-					RCrateMeasured = false;		// Force remeasure of RC rate
-					PWMBlocked = true;			// Disable Fast-mode PWM generation		
-					ResampleRCRate = false;		// Reset resample request
-				}
-
-				// If not, block the RC interrupts until we run out of pulses
+#ifdef SERVO_ISR
+				// The pulses are timed by the Timer1 compare interrupt, which RC
+				// interrupts can only delay slightly. So the RC interrupts stay on
+				// and PWM is never blocked.
+				PWMBlocked = false;
+#else
+				// Block the RC interrupts until we run out of pulses
 				// We need to cancel the Interrupted flag but have to make a copy until 
 				// the status screen state machine has seen it.
-				else
+				if (Interrupted)
 				{
-					if (Interrupted)
-					{
-						Interrupted_Clone = true;	// Hand "Interrupted" baton on to its clone
-					}
-					
-					Interrupted = false;		// Cancel pending interrupts
-					Disable_RC_Interrupts();	// Disable RC interrupts
-					RCInterruptsON = false;		// Flag it for the rest of the code
-					PWMBlocked = false;			// Enable PWM generation	
+					Interrupted_Clone = true;	// Hand "Interrupted" baton on to its clone
 				}
+				
+				Interrupted = false;		// Cancel pending interrupts
+				Disable_RC_Interrupts();	// Disable RC interrupts
+				RCInterruptsON = false;		// Flag it for the rest of the code
+				PWMBlocked = false;			// Enable PWM generation	
+#endif
 			}
 		} // Interrupted
 
@@ -1323,9 +1291,10 @@ add_log(TIMER);
 				ServoTick = false;
 				
 				// Reset the Servo rate counter here so that it doesn't force an unusually small gap next time
-				Servo_Rate = 0;
+				ServoRate_start = Ticks;
 			}
 
+#ifndef SERVO_ISR
 			// Block PWM generation after last PWM pulse
 			if ((PWM_pulses == 1) && (Config.Servo_rate == FAST))
 			{
@@ -1348,10 +1317,15 @@ add_log(TIMER);
 					PWM_interval = interval;		// Actual interval
 				}
 			}
+#endif
 			
+			LOOP_STAGE(STAGE_CALC_PID);
 			Calculate_PID();						// Calculate PID values
+			LOOP_STAGE(STAGE_MIXER);
 			ProcessMixer();							// Do all the mixer tasks - can be very slow
+			LOOP_STAGE(STAGE_SERVOS);
 			UpdateServos();							// Transfer Config.Channel[i].value data to ServoOut[i] and check servo limits				
+			LOOP_STAGE(STAGE_MAIN);
 
 			// Set motors to idle on loss of signal.
 			// Output LOW pulse (1.1ms) for each output that is set to MOTOR
@@ -1378,7 +1352,9 @@ add_log(TIMER);
 			// Otherwise just output PWM normally
 			else
 			{
+				LOOP_STAGE(STAGE_OUTPUT);
 				output_servo_ppm(ServoFlag);		// Output servo signal			
+				LOOP_STAGE(STAGE_MAIN);
 			}
 
 
@@ -1387,37 +1363,38 @@ add_log(TIMER);
 			{
 				PWM_pulses--;
 			}
-			
-			LoopCount = 0;						// Reset loop counter for averaging accVert
 		}
 		
 		// In FAST mode and in-between bursts, sync up with the RC so that the time from Interrupt to PWM is constant.
 		// This helps tighten up the number of pulses allowable
 		else if ((Config.Servo_rate == FAST) && (PWMBlocked == true) && (RCrateMeasured == true) && (RCInterruptsON == true) && (Overdue == false))
 		{
-			fast_sync_timer = 0;
+			fast_sync_start = ticks_now();
 			
 			// Wait here until interrupted or timed out (15ms)
-			while ((Interrupted == false) && (fast_sync_timer < FASTSYNCLIMIT))
+			LOOP_STAGE(STAGE_WAIT);
+			while ((Interrupted == false) && !TICKS_EXPIRED(fast_sync_start, ticks_now(), FASTSYNCLIMIT))
 			{
-				fast_sync_timer += (uint8_t)(TCNT2 - fast_sync_TCNT2);
-				fast_sync_TCNT2 = TCNT2;
+				RxDecodeSerial();
 			}
+			LOOP_STAGE(STAGE_MAIN);
 			
 			// Debug - Whhaaaat? - delete this unless I recall why it is even here.
 			Interrupted_Clone = false;
 		}
 	
 		//************************************************************
-		//* Enable RC interrupts when ready (RC rate measured and RC interrupts OFF)
-		//* and just one PWM remains
+		//* Enable RC interrupts when ready (RC interrupts OFF)
+		//* and the last PWM of the burst has been output
 		//************************************************************
 
-		if ((PWM_pulses < 1) && RCrateMeasured && !RCInterruptsON && (Config.Servo_rate == FAST))
+#ifndef SERVO_ISR
+		if ((PWM_pulses < 1) && !RCInterruptsON && (Config.Servo_rate == FAST))
 		{
 			init_int();					// Re-enable interrupts
 			RCInterruptsON = true;
 		}
+#endif
 		
 		//************************************************************
 		//* Carefully update idle screen if error level changed
@@ -23,6 +23,7 @@
 #include "i2c.h"
 #include "MPU6050.h"
 #include "imu.h"
+#include "filters.h"
 #include "menu_ext.h"
 
 //************************************************************
@@ -30,8 +31,10 @@
 //************************************************************
 
 void ReadAcc(void);
+void ProcessAcc(void);
 void CalibrateAcc(int8_t type);
 void get_raw_accs(void);
+void decode_accs(const uint8_t *Accs);
 
 //************************************************************
 // Defines
@@ -78,9 +81,14 @@ int16_t accVert = 0;			// Holds the level-zeroed Z-acc value. Used for height da
 
 void ReadAcc()
 {
-	uint8_t i;
-
 	get_raw_accs();				// Updates accADC[] (RPY)
+	ProcessAcc();
+}
+
+// Remove zeros and correct polarity of the raw accADC[] data, then update accVert
+void ProcessAcc(void)
+{
+	uint8_t i;
 
 	// Use default Config.AccZero for Acc-Z if inverse calibration not done yet
 	// Actual zero is held in Config.AccZeroNormZ waiting for inv calibration
@@ -107,8 +115,9 @@ void ReadAcc()
 
 	// Recalculate current accVert using filtered acc value
 	// Note that AccSmooth[YAW] is already zeroed around 1G so we have to re-add 
-	// the zero back here so that Config.AccZeroNormZ subtracts the correct amount
-	 accVert = accSmooth[YAW] + (Config.AccZeroNormZ - Config.AccZero[YAW]);
+	// the zero back here so that Config.AccZeroNormZ subtracts the correct amount.
+	// This uses the Q8 filter state so that the sum truncates as a whole
+	accVert = (int16_t)((AccState[YAW] + ((int32_t)(Config.AccZeroNormZ - Config.AccZero[YAW]) << 8)) / 256);
 }
 
 //***************************************************************
@@ -117,16 +126,22 @@ void ReadAcc()
 
 void get_raw_accs(void)
 {
-	int16_t RawADC[NUMBEROFAXIS];
-	uint8_t i;
-
 	// Get data from MPU6050
 	uint8_t Accs[6];
-	int16_t temp1, temp2;
 
 	// Get the i2c data from the MPU6050
 	readI2CbyteArray(MPU60X0_DEFAULT_ADDRESS,MPU60X0_RA_ACCEL_XOUT_H,(uint8_t *)Accs,6);
 
+	decode_accs(Accs);
+}
+
+// Fill accADC[] from the six ACCEL_XOUT_H to ACCEL_ZOUT_L bytes
+void decode_accs(const uint8_t *Accs)
+{
+	int16_t RawADC[NUMBEROFAXIS];
+	uint8_t i;
+	int16_t temp1, temp2;
+
 	// Reassemble data into accADC array and down sample to reduce resolution and noise
 	// This notation is true to the chip, but not the board orientation
 
@@ -20,6 +20,7 @@
 #include "acc.h"
 #include "gyros.h"
 #include "acc.h"
+#include "sensors.h"
 #include "menu_ext.h"
 #include "i2c.h"
 #include "MPU6050.h"
@@ -45,8 +46,7 @@ void Display_sensors(void)
 	// While BACK not pressed
 	while(BUTTON1 != 0)
 	{
-		ReadGyros();
-		ReadAcc();
+		ReadSensors();
 
 		LCD_Display_Text(26,(const unsigned char*)Verdana8,37,0); 	// Gyro
 		LCD_Display_Text(30,(const unsigned char*)Verdana8,77,0); 	// Acc
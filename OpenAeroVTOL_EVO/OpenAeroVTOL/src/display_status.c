@@ -19,6 +19,8 @@
 #include "menu_ext.h"
 #include "mixer.h"
 #include "main.h"
+#include "typedefs.h"
+#include "serial_rx.h"
 
 //************************************************************
 // Prototypes
@@ -60,6 +62,12 @@ void Display_status(void)
 		mugui_lcd_puts(itoa(InterruptCount,pBuffer,10),(const unsigned char*)Verdana8,110,12); // Interrupt counter
 	}
 
+	if (Config.RxMode == CRSF)
+	{
+		LCD_Display_Text(45,(const unsigned char*)Verdana8,77,12); // Link quality text 
+		mugui_lcd_puts(itoa(RxLinkQuality,pBuffer,10),(const unsigned char*)Verdana8,110,12); // Uplink LQ (%)
+	}
+
 	// Display transition point
 	if (transition <= 0)
 	{
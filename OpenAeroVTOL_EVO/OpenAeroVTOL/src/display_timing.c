@@ -0,0 +1,107 @@
+//***********************************************************
+//* display_timing.c
+//*
+//* Loop timing pages of the status screen (LOOP_TIMING).
+//* Shows the min/mean/max time per loop of one main loop
+//* stage in microseconds, the number of loops it ran in and
+//* its histogram.
+//***********************************************************
+
+//***********************************************************
+//* Includes
+//***********************************************************
+
+#include "compiledefs.h"
+#include <avr/io.h>
+#include <stdlib.h>
+#include <avr/pgmspace.h>
+#include "io_cfg.h"
+#include "glcd_driver.h"
+#include "mugui.h"
+#include "glcd_menu.h"
+#include "main.h"
+#include "menu_ext.h"
+#include "loop_timing.h"
+
+#ifdef LOOP_TIMING
+
+//************************************************************
+// Prototypes
+//************************************************************
+
+void Display_timing(uint8_t stage);
+
+//************************************************************
+// Defines
+//************************************************************
+
+#define TIMINGTEXT	292				// Start of the stage names in text_menu[]
+#define HIST_X		64				// Histogram position and size
+#define HIST_BOTTOM	46
+#define HIST_HEIGHT	34
+#define HIST_WIDTH	7
+
+//************************************************************
+// Code
+//************************************************************
+
+// Convert TCNT1 ticks (400ns) to microseconds
+static uint16_t ticks_to_us(uint32_t ticks)
+{
+	return (uint16_t)((ticks << 1) / 5);
+}
+
+void Display_timing(uint8_t stage)
+{
+	stage_timing_t *timing = &StageTiming[stage];
+	uint16_t hist_max = 1;
+	uint8_t height;
+	uint8_t i;
+
+	clear_buffer(buffer);
+
+	// Stage name and number of loops it ran in
+	LCD_Display_Text(TIMINGTEXT + stage,(const unsigned char*)Verdana8,0,0);
+	mugui_lcd_puts(utoa(timing->count,pBuffer,10),(const unsigned char*)Verdana8,HIST_X + 20,0);
+
+	// Min, mean and max in us
+	LCD_Display_Text(TIMINGTEXT + NUMBEROFSTAGES + 1,(const unsigned char*)Verdana8,0,12);	// Min
+	LCD_Display_Text(TIMINGTEXT + NUMBEROFSTAGES + 2,(const unsigned char*)Verdana8,0,24);	// Avg
+	LCD_Display_Text(TIMINGTEXT + NUMBEROFSTAGES + 3,(const unsigned char*)Verdana8,0,36);	// Max
+
+	if (timing->count != 0)
+	{
+		mugui_lcd_puts(utoa(ticks_to_us(timing->min),pBuffer,10),(const unsigned char*)Verdana8,28,12);
+		mugui_lcd_puts(utoa(ticks_to_us(timing->sum / timing->count),pBuffer,10),(const unsigned char*)Verdana8,28,24);
+		mugui_lcd_puts(utoa(ticks_to_us(timing->max),pBuffer,10),(const unsigned char*)Verdana8,28,36);
+	}
+
+	// Histogram, scaled to the largest bucket
+	for (i = 0; i < TIMING_BUCKETS; i++)
+	{
+		if (timing->hist[i] > hist_max)
+		{
+			hist_max = timing->hist[i];
+		}
+	}
+
+	for (i = 0; i < TIMING_BUCKETS; i++)
+	{
+		height = (uint8_t)(((uint32_t)timing->hist[i] * HIST_HEIGHT) / hist_max);
+		fillrect(buffer, HIST_X + (i * HIST_WIDTH), HIST_BOTTOM - height, HIST_WIDTH - 1, height, 1);
+	}
+
+	drawline(buffer, HIST_X, HIST_BOTTOM, HIST_X + (TIMING_BUCKETS * HIST_WIDTH), HIST_BOTTOM, 1);
+
+	// Print bottom markers
+	LCD_Display_Text(9, (const unsigned char*)Wingdings, 0, 59);		// Down
+	LCD_Display_Text(14,(const unsigned char*)Verdana8,10,55);		// Menu
+	LCD_Display_Text(TIMINGTEXT + NUMBEROFSTAGES + 4,(const unsigned char*)Verdana8,75,55);	// Clear
+	LCD_Display_Text(TIMINGTEXT + NUMBEROFSTAGES + 5,(const unsigned char*)Verdana8,105,55);	// Next
+
+	// Write buffer to complete
+	write_buffer(buffer);
+	clear_buffer(buffer);
+}
+
+#endif // LOOP_TIMING
@@ -33,6 +33,9 @@ void Update_V1_1_to_V1_1_B8(void);
 void Update_V1_1B8_to_V1_1_B10(void);
 void Update_V1_1B10_to_V1_1_B12(void);
 void Update_V1_1B12_to_V1_1_B18(void);
+void Update_V1_1B18_to_V1_2_B3(void);
+void Update_V1_2B3_to_V1_2_B4(void);
+void Update_V1_2B4_to_V1_2_B5(void);
 
 uint8_t convert_filter_B8_B10(uint8_t);
 
@@ -51,8 +54,11 @@ void Load_eeprom_preset(uint8_t preset);
 #define V1_1_B10_SIGNATURE 0x38	// EEPROM signature for V1.1 Beta 10-11
 #define V1_1_B12_SIGNATURE 0x39	// EEPROM signature for V1.1 Beta 12+
 #define V1_1_B18_SIGNATURE 0x3A	// EEPROM signature for V1.1 Beta 18+
+#define V1_2_B3_SIGNATURE 0x3B	// EEPROM signature for V1.2 Beta 3
+#define V1_2_B4_SIGNATURE 0x3C	// EEPROM signature for V1.2 Beta 4
+#define V1_2_B5_SIGNATURE 0x3D	// EEPROM signature for V1.2 Beta 5+
 
-#define MAGIC_NUMBER V1_1_B18_SIGNATURE // Set current signature to that of V1.1 Beta 18+
+#define MAGIC_NUMBER V1_2_B5_SIGNATURE // Set current signature to that of V1.2 Beta 5+
 
 //************************************************************
 // Code
@@ -128,9 +134,24 @@ bool Initial_EEPROM_Config_Load(void)
 
 		case V1_1_B12_SIGNATURE:			// V1.1 Beta 12 detected
 			Update_V1_1B12_to_V1_1_B18();
-			updated = true;
+			// Fall through...
 
 		case V1_1_B18_SIGNATURE:			// V1.1 Beta 18+ detected
+			Update_V1_1B18_to_V1_2_B3();
+			updated = true;
+			// Fall through...
+
+		case V1_2_B3_SIGNATURE:				// V1.2 Beta 3 detected
+			Update_V1_2B3_to_V1_2_B4();
+			updated = true;
+			// Fall through...
+
+		case V1_2_B4_SIGNATURE:				// V1.2 Beta 4 detected
+			Update_V1_2B4_to_V1_2_B5();
+			updated = true;
+			// Fall through...
+
+		case V1_2_B5_SIGNATURE:				// V1.2 Beta 5+ detected
 			// Fall through...
 			break;
 
@@ -525,6 +546,38 @@ void Update_V1_1B12_to_V1_1_B18(void)
 	Config.setup = V1_1_B18_SIGNATURE;
 }
 
+// Upgrade V1.1 B18+ settings to V1.2 Beta 3 settings
+void Update_V1_1B18_to_V1_2_B3(void)
+{
+	// IMU_type is new at the end of the structure.
+	// Keep the vector IMU that the settings were tuned with
+	Config.IMU_type = IMU_VECTOR;
+
+	// Set magic number to V1.2 Beta 3 signature
+	Config.setup = V1_2_B3_SIGNATURE;
+}
+
+// Upgrade V1.2 B3 settings to V1.2 Beta 4 settings
+void Update_V1_2B3_to_V1_2_B4(void)
+{
+	// The gyro notches are new at the end of the structure. Notches off
+	Config.Gyro_notch1 = 0;
+	Config.Gyro_notch2 = 0;
+
+	// Set magic number to V1.2 Beta 4 signature
+	Config.setup = V1_2_B4_SIGNATURE;
+}
+
+// Upgrade V1.2 B4 settings to V1.2 Beta 5 settings
+void Update_V1_2B4_to_V1_2_B5(void)
+{
+	// The CPPM filter setting is new at the end of the structure. Filter off
+	Config.CPPM_slew = 0;
+
+	// Set magic number to V1.2 Beta 5 signature
+	Config.setup = V1_2_B5_SIGNATURE;
+}
+
 // Convert pre-V1.1 B10 filter settings
 uint8_t convert_filter_B8_B10(uint8_t old_filter)
 {
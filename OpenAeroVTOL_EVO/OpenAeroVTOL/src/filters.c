@@ -0,0 +1,395 @@
+//***********************************************************
+//* filters.c
+//*
+//* Sensor filters and the service that keeps their coefficients
+//* matched to the loop rate.
+//*
+//* Gyros: a 2nd-order Butterworth low-pass set by Gyro_LPF and
+//* up to two notches for motor and prop noise, run in that order
+//* on gyroADC[] each loop. Each stage is a Direct Form I biquad
+//* with Q14 coefficients, so a sample costs five 16x16 multiplies.
+//* The rounding residue of each output is fed into the next one,
+//* which stops the low cutoffs from sticking short of the input.
+//*
+//* Accs: a single-pole low-pass set by Acc_LPF, producing
+//* accSmooth[] from accADC[]. The state is Q8 and each loop moves
+//* it by a Q16 fraction of the error, rather than dividing by a
+//* smoothing factor. The IMU reads the Q8 state (AccState[]) directly.
+//*
+//* Every coefficient depends on the loop rate, so they are all
+//* worked out (in float, off the fast path) from a running
+//* average of the measured loop period. init_filters() designs
+//* them straight away for new settings. After that, whenever the
+//* average moves by more than 1/32 from the period they were made
+//* for, they are redesigned one per loop so no single loop
+//* carries the whole cost.
+//***********************************************************
+
+//***********************************************************
+//* Includes
+//***********************************************************
+
+#include <avr/pgmspace.h>
+#include <stdbool.h>
+#include <math.h>
+#include "io_cfg.h"
+#include "main.h"
+#include "gyros.h"
+#include "acc.h"
+#include "imu.h"
+#include "filters.h"
+
+//************************************************************
+// Prototypes
+//************************************************************
+
+void init_filters(void);
+void filter_period(uint32_t period);
+void filter_gyros(void);
+void filter_accs(void);
+
+//************************************************************
+// Defines
+//************************************************************
+
+#define GYRO_STAGES		3				// LPF, notch 1, notch 2
+#define ACC_ITEM		GYRO_STAGES		// Designed after the gyro stages
+#define FILTER_ITEMS	(GYRO_STAGES + 1)
+
+#define BQ_SHIFT		14				// Q14 coefficients
+#define BQ_ONE			(1L << BQ_SHIFT)
+#define BQ_MAX			32767L			// Largest coefficient (just under 2.0)
+#define GYRO_Q			3				// Fractional bits added to gyroADC[] inside the filters
+#define ACC_Q			8				// Fractional bits of the acc LPF state
+#define ACC_ALPHA_MAX	65535L			// Q16 acc LPF step, just under all of the error
+#define ACC_ERROR_SHIFT	5				// Acc LPF error is cut to Q3 for a 16x16 multiply
+
+#define T1_HZ			2500000.0f		// Timer1 rate. Periods are in T1 ticks
+#define BUTTERWORTH_Q	0.7071f
+#define NOTCH_Q			2.0f			// Notch width is centre/NOTCH_Q
+#define NOTCH_STEP		10				// Hz per notch menu step
+#define NYQUIST_LIMIT	0.45f			// Gyro stages tuned above this fraction of the loop rate are bypassed
+
+#define PERIOD_NOMINAL	3571			// Assume 700Hz until measured
+#define PERIOD_MIN		1000			// Loop periods outside 100Hz to 2.5kHz are not averaged
+#define PERIOD_MAX		25000			// (e.g. the first loop back from the menus)
+#define PERIOD_SHIFT	5				// Period average time constant of 32 loops
+#define PERIOD_DRIFT	5				// Redesign once the average is 1/32 away from FilterPeriod
+#define SETTLE_LOOPS	128				// Loops averaged before the average is trusted
+
+typedef struct
+{
+	int16_t		b0;
+	int16_t		b1;
+	int16_t		b2;
+	int16_t		a1;
+	int16_t		a2;
+} biquad_coeff_t;
+
+typedef struct
+{
+	int16_t		x1;						// Last two inputs and outputs
+	int16_t		x2;
+	int16_t		y1;
+	int16_t		y2;
+	uint16_t	residue;				// Part of the last output lost to rounding
+} biquad_state_t;
+
+//************************************************************
+// Data
+//************************************************************
+
+// LPF cutoffs in Hz for Acc_LPF and Gyro_LPF (enum Filters, NOFILTER excluded)
+const uint16_t LPF_Hz[NOFILTER] PROGMEM = {5, 10, 21, 44, 94, 184, 260};
+
+uint16_t FilterPeriod = PERIOD_NOMINAL;			// Loop period the coefficients were made for (T1 ticks)
+
+biquad_coeff_t GyroCoeff[GYRO_STAGES];
+biquad_state_t GyroState[GYRO_STAGES][NUMBEROFAXIS];
+uint8_t GyroStages = 0;							// Bit per active stage
+uint8_t GyroPrime = 0;							// Stages to preload with the next sample
+
+uint16_t AccAlpha = 0;							// Q16 step of the acc LPF. 0 = LPF off
+int32_t	AccState[NUMBEROFAXIS];					// Acc LPF outputs in Q8, negated like accSmooth[]
+
+uint32_t PeriodSum = 0;							// Loop period average in Q5
+uint8_t	 PeriodLoops = 0;						// Loops averaged, saturates at SETTLE_LOOPS
+uint8_t	 DesignItem = FILTER_ITEMS;				// Next item to redesign, FILTER_ITEMS when done
+
+//************************************************************
+// Code
+//************************************************************
+
+static int16_t coeff_q14(float c)
+{
+	int32_t q = lround(c * BQ_ONE);
+
+	if (q > BQ_MAX) q = BQ_MAX;
+	if (q < -BQ_MAX) q = -BQ_MAX;
+
+	return (int16_t)q;
+}
+
+// Work out one gyro stage from its RBJ cookbook form. Returns false if the
+// frequency is off or too close to Nyquist to be usable at this loop rate.
+// The numerator is rebuilt from the rounded denominator so that the 
+// DC gain stays exactly 1 however coarse the Q14 coefficients are.
+static bool design_stage(biquad_coeff_t *c, float hz, bool notch)
+{
+	float w0, cs, alpha, a0;
+	int32_t sum;
+
+	if ((hz <= 0.0f) || (hz > ((T1_HZ / FilterPeriod) * NYQUIST_LIMIT)))
+	{
+		return false;
+	}
+
+	w0 = (2.0f * (float)M_PI * hz * FilterPeriod) / T1_HZ;
+	cs = cos(w0);
+	alpha = sin(w0) / (2.0f * (notch ? NOTCH_Q : BUTTERWORTH_Q));
+	a0 = 1.0f + alpha;
+
+	c->a1 = coeff_q14((-2.0f * cs) / a0);
+	c->a2 = coeff_q14((1.0f - alpha) / a0);
+
+	if (notch)
+	{
+		// b = (1, -2cos(w0), 1) / a0, where 2/a0 = 1 + a2
+		c->b0 = (int16_t)((BQ_ONE + c->a2 + 1) >> 1);
+		c->b1 = c->a1;
+	}
+	else
+	{
+		// b = (1, 2, 1) * (1 + a1 + a2) / 4
+		// The sum reaches about 3.2 at NYQUIST_LIMIT, so it needs 32 bits
+		sum = BQ_ONE + c->a1 + c->a2;
+		c->b0 = (int16_t)((sum + 2) >> 2);
+		c->b1 = (int16_t)(sum - (c->b0 << 1));
+	}
+
+	c->b2 = c->b0;
+
+	return true;
+}
+
+// Step of a single-pole LPF matching an RC filter sampled at FilterPeriod: 
+// 1 - e^(-2.pi.fc.T). The -3dB point is accurate well below the loop rate
+// and drifts up as the cutoff nears it, as the old divisor tables did.
+static uint16_t design_acc(void)
+{
+	float step;
+	int32_t q;
+
+	if (Config.Acc_LPF == NOFILTER)
+	{
+		return 0;
+	}
+
+	step = 1.0f - exp((-2.0f * (float)M_PI * pgm_read_word(&LPF_Hz[Config.Acc_LPF]) * FilterPeriod) / T1_HZ);
+
+	q = lround(step * 65536.0f);
+	if (q > ACC_ALPHA_MAX) q = ACC_ALPHA_MAX;
+
+	return (uint16_t)q;
+}
+
+// Recalculate one item for the current settings and FilterPeriod
+static void design_item(uint8_t item)
+{
+	uint8_t bit = (1 << item);
+	bool on;
+
+	switch(item)
+	{
+		case 0:
+			on = (Config.Gyro_LPF != NOFILTER) && 
+				 design_stage(&GyroCoeff[0], pgm_read_word(&LPF_Hz[Config.Gyro_LPF]), false);
+			break;
+
+		case 1:
+			on = design_stage(&GyroCoeff[1], (float)Config.Gyro_notch1 * NOTCH_STEP, true);
+			break;
+
+		case 2:
+			on = design_stage(&GyroCoeff[2], (float)Config.Gyro_notch2 * NOTCH_STEP, true);
+			break;
+
+		default:
+			AccAlpha = design_acc();
+			return;
+	}
+
+	if (on)
+	{
+		// A stage just switched on starts from the next gyro reading rather than from stale data
+		if (!(GyroStages & bit))
+		{
+			GyroPrime |= bit;
+		}
+
+		GyroStages |= bit;
+	}
+	else
+	{
+		GyroStages &= ~bit;
+	}
+}
+
+// Call when the filter settings change. Designs everything for the period
+// measured so far, then remeasures it.
+void init_filters(void)
+{
+	uint8_t item;
+
+	for (item = 0; item < FILTER_ITEMS; item++)
+	{
+		design_item(item);
+	}
+
+	DesignItem = FILTER_ITEMS;
+	PeriodLoops = 0;
+}
+
+// Run each loop with the loop period. Keeps the coefficients in step
+// with the loop rate.
+void filter_period(uint32_t period)
+{
+	uint16_t average;
+	uint16_t drift;
+
+	// Finish any redesign in progress, one item per loop
+	if (DesignItem < FILTER_ITEMS)
+	{
+		design_item(DesignItem);
+		DesignItem++;
+	}
+
+	if ((period < PERIOD_MIN) || (period > PERIOD_MAX))
+	{
+		return;
+	}
+
+	if (PeriodLoops == 0)
+	{
+		PeriodSum = period << PERIOD_SHIFT;
+	}
+	else
+	{
+		PeriodSum += period - (PeriodSum >> PERIOD_SHIFT);
+	}
+
+	if (PeriodLoops < SETTLE_LOOPS)
+	{
+		PeriodLoops++;
+		return;
+	}
+
+	// Start a redesign if the loop rate has moved meaningfully
+	average = (uint16_t)(PeriodSum >> PERIOD_SHIFT);
+	drift = (average > FilterPeriod) ? (average - FilterPeriod) : (FilterPeriod - average);
+
+	if ((DesignItem == FILTER_ITEMS) && (drift > (FilterPeriod >> PERIOD_DRIFT)))
+	{
+		FilterPeriod = average;
+		DesignItem = 0;
+	}
+}
+
+static int16_t biquad(const biquad_coeff_t *c, biquad_state_t *s, int16_t x)
+{
+	int32_t acc;
+	int16_t y;
+
+	acc = s->residue;
+	acc += (int32_t)c->b0 * x;
+	acc += (int32_t)c->b1 * s->x1;
+	acc += (int32_t)c->b2 * s->x2;
+	acc -= (int32_t)c->a1 * s->y1;
+	acc -= (int32_t)c->a2 * s->y2;
+
+	s->residue = (uint16_t)acc & (BQ_ONE - 1);
+	acc >>= BQ_SHIFT;
+
+	if (acc > 32767) acc = 32767;
+	if (acc < -32767) acc = -32767;
+	y = (int16_t)acc;
+
+	s->x2 = s->x1;
+	s->x1 = x;
+	s->y2 = s->y1;
+	s->y1 = y;
+
+	return y;
+}
+
+// Filters gyroADC[] in place
+void filter_gyros(void)
+{
+	biquad_state_t *s;
+	int16_t x;
+	uint8_t axis, stage;
+
+	if (GyroStages == 0)
+	{
+		return;
+	}
+
+	for (axis = 0; axis <= YAW; axis++)
+	{
+		x = gyroADC[axis] << GYRO_Q;
+
+		for (stage = 0; stage < GYRO_STAGES; stage++)
+		{
+			if (!(GyroStages & (1 << stage)))
+			{
+				continue;
+			}
+
+			s = &GyroState[stage][axis];
+
+			// Both filter types have unity DC gain, so a state holding
+			// the input throughout is already settled
+			if (GyroPrime & (1 << stage))
+			{
+				s->x1 = x;
+				s->x2 = x;
+				s->y1 = x;
+				s->y2 = x;
+				s->residue = 0;
+			}
+
+			x = biquad(&GyroCoeff[stage], s, x);
+		}
+
+		gyroADC[axis] = (x + (1 << (GYRO_Q - 1))) >> GYRO_Q;
+	}
+
+	GyroPrime = 0;
+}
+
+// Smooth accADC[] into accSmooth[]. Note that accSmooth is negated 
+// and in [ROLL, PITCH, YAW] order
+void filter_accs(void)
+{
+	int32_t x;
+	int16_t error;
+	uint8_t axis;
+
+	for (axis = 0; axis < NUMBEROFAXIS; axis++)
+	{
+		x = -((int32_t)accADC[axis] << ACC_Q);
+
+		if (AccAlpha == 0)
+		{
+			AccState[axis] = x;
+		}
+		else
+		{
+			error = (int16_t)((x - AccState[axis]) >> ACC_ERROR_SHIFT);
+			AccState[axis] += ((int32_t)error * AccAlpha) >> (16 - ACC_ERROR_SHIFT);
+		}
+
+		// Divide rather than shift so that this truncates towards zero
+		accSmooth[axis] = (int16_t)(AccState[axis] / (1 << ACC_Q));
+	}
+}
@@ -50,6 +50,7 @@ const char StatusText5[]  PROGMEM = "0";
 const char StatusText7[]  PROGMEM = "Battery:";
 const char StatusText8[]  PROGMEM = "Pos:";
 const char StatusText9[]  PROGMEM = "Jitter:";
+const char StatusText10[] PROGMEM = "LQ:";
 //
 const char MenuFrame0[] PROGMEM = "A"; 						// Down marker
 const char MenuFrame2[] PROGMEM = "B";						// Right
@@ -128,6 +129,7 @@ const char RXMode1[]  PROGMEM = "PWM";
 const char RXMode2[]  PROGMEM = "S-Bus";
 const char RXMode3[]  PROGMEM = "Spektrum";
 const char RXMode4[]  PROGMEM = "Xtreme";
+const char RXMode5[]  PROGMEM = "CRSF";
 //
 const char RCMenuItem6[]  PROGMEM = "JR,Spktm"; 			// Channel order
 const char RCMenuItem7[]  PROGMEM = "Futaba"; 
@@ -139,7 +141,11 @@ const char GeneralText2[]  PROGMEM = "Disarm time:";
 const char GeneralText3[]  PROGMEM = "PWM rate:";
 const char GeneralText6[] PROGMEM =  "Acc. LPF:";
 const char GeneralText16[] PROGMEM =  "Gyro LPF:";
+const char GeneralText17[] PROGMEM =  "Notch1 x10Hz:";
+const char GeneralText18[] PROGMEM =  "Notch2 x10Hz:";
 const char GeneralText7[] PROGMEM =  "AL correct:";
+const char GeneralText8[] PROGMEM =  "IMU type:";
+const char GeneralText19[] PROGMEM =  "CPPM slew %:";
 const char BattMenuItem2[]  PROGMEM = "Low V Alarm:";
 const char GeneralText20[] PROGMEM =  "Preset:";
 //
@@ -263,6 +269,9 @@ const char MixerItem16[] PROGMEM = "RevScaled";
 //
 const char GeneralText5[] PROGMEM  =  "Sync RC";			// PWM output modes
 //
+const char IMUType0[] PROGMEM  =  "Vector";					// IMU types
+const char IMUType1[] PROGMEM  =  "Quat.";
+//
 const char Safety1[] PROGMEM =  "Armed";
 const char Safety2[] PROGMEM =  "Armable";
 const char Random1[] PROGMEM =  "High";
@@ -319,6 +328,28 @@ const char ERROR_MSG_0[] PROGMEM =  "Clear";
 const char Debug_1[] PROGMEM =  "Roll D:";
 const char Debug_2[] PROGMEM =  "Pitch D:";
 
+#ifdef LOOP_TIMING
+// Loop timing stages. Must follow enum LoopStages in io_cfg.h
+const char Timing_0[] PROGMEM =  "Other";
+const char Timing_1[] PROGMEM =  "Loop top";
+const char Timing_2[] PROGMEM =  "RC input";
+const char Timing_3[] PROGMEM =  "Sensors";
+const char Timing_4[] PROGMEM =  "IMU";
+const char Timing_5[] PROGMEM =  "Sensor PID";
+const char Timing_6[] PROGMEM =  "PID";
+const char Timing_7[] PROGMEM =  "Mixer";
+const char Timing_8[] PROGMEM =  "Servos";
+const char Timing_9[] PROGMEM =  "PWM";
+const char Timing_10[] PROGMEM = "PWM asm";
+const char Timing_11[] PROGMEM = "FAST sync";
+const char Timing_12[] PROGMEM = "Status/menu";
+const char Timing_13[] PROGMEM = "Whole loop";
+const char Timing_14[] PROGMEM = "Min:";
+const char Timing_15[] PROGMEM = "Avg:";
+const char Timing_16[] PROGMEM = "Max:";
+const char Timing_17[] PROGMEM = "Next";
+#endif
+
 const char* const text_menu[] PROGMEM = 
 	{
 		AutoMenuItem11, VBAT32, VBAT33, VBAT34,	VBAT35, VBAT36, VBAT37, VBAT38, VBAT39,		// 0 to 8 Vbat cell voltages
@@ -340,7 +371,7 @@ const char* const text_menu[] PROGMEM =
 		MPU6050LPF1, MPU6050LPF2, MPU6050LPF3, MPU6050LPF4,
 		MPU6050LPF5, MPU6050LPF6, MPU6050LPF7, ChannelRef8,									// 37 to 44  MPU6050 LPF, 5Hz to 260Hz + None
 		//
-		Dummy0, 																			// 45 Spare 
+		StatusText10,																		// 45 CRSF link quality
 		//
 		MixerItem40, MixerItem41,															// 46 to 47 Device types - Servo/Motor													// 
 		// 
@@ -362,12 +393,12 @@ const char* const text_menu[] PROGMEM =
 		//
 		PText4, 																			// 61 Failed
 		//
-		RXMode0, RXMode1, RXMode2, RXMode3,													// 62 to 65 RX mode
-		RXMode4, Dummy0, 
+		RXMode0, RXMode1, RXMode2, RXMode3,													// 62 to 67 RX mode
+		RXMode4, RXMode5, 
 		//
 		AutoMenuItem11, AutoMenuItem15, MixerItem15, MixerItem12, MixerItem16,				// 68 to 71 off/on/scale/rev/revscale 
 		//
-		Dummy0, Dummy0, 
+		IMUType0, IMUType1,																	// 73 to 74 IMU types
 		//
 		ErrorText3, ErrorText4,																// 75 to 76 Error messages
 		//
@@ -415,16 +446,14 @@ const char* const text_menu[] PROGMEM =
 		Transition, Transition_P1n,
 		Debug_1, Debug_2,	 
 		//
-		MixerMenuItem0, Contrast, AutoMenuItem2,											// 158 to 167 General
+		MixerMenuItem0, Contrast, AutoMenuItem2,											// 158 to 171 General
 		GeneralText2, BattMenuItem2, GeneralText10, 
-		GeneralText6, GeneralText16, GeneralText7, 
-		GeneralText20,
-		
-		Dummy0,
-		Dummy0,																				// 168-169 Spare
+		GeneralText6, GeneralText16, GeneralText17, 
+		GeneralText18, GeneralText7, GeneralText8, 
+		GeneralText19, GeneralText20,
 
 		//
-						 																	// 170 to 189 Flight menu
+						 																	// 172 to 189 Flight menu
 		AutoMenuItem1, StabMenuItem2, StabMenuItem10, StabMenuItem3,						// Roll gyro
 		AutoMenuItem20, AutoMenuItem7,														// Roll acc
 		AutoMenuItem4, StabMenuItem5, StabMenuItem11, StabMenuItem6, 						// Pitch gyro
@@ -432,8 +461,6 @@ const char* const text_menu[] PROGMEM =
 		StabMenuItem7, StabMenuItem8, StabMenuItem12, StabMenuItem9,	 					// Yaw gyro
 		StabMenuItem30,	StabMenuItem13,														// Yaw trim, Z-Acc, 
 
-		Dummy0, Dummy0,
-
 		//
 		MixerItem1,																			// 190 Motor marker (34 mixer items in total)
 		MixerItem20, 																		// Offset for P1
@@ -491,6 +518,12 @@ const char* const text_menu[] PROGMEM =
 		Dummy0, Dummy0, Dummy0, 	
 		
 		ERROR_MSG_0,																		// 291 Log menu
+
+#ifdef LOOP_TIMING
+		Timing_0, Timing_1, Timing_2, Timing_3, Timing_4, Timing_5, Timing_6,				// 292 to 305 Loop timing stages
+		Timing_7, Timing_8, Timing_9, Timing_10, Timing_11, Timing_12, Timing_13,
+		Timing_14, Timing_15, Timing_16, ERROR_MSG_0, Timing_17,							// 306 to 310 Min, Avg, Max, Clear, Next
+#endif
 	}; 
 
 //************************************************************
@@ -23,15 +23,18 @@
 #include "main.h"
 #include "imu.h"
 #include "eeprom.h"
+#include "ticks.h"
 
 //************************************************************
 // Prototypes
 //************************************************************
 
 void ReadGyros(void);
+void ProcessGyros(void);
 void CalibrateGyrosFast(void);
 bool CalibrateGyrosSlow(void);
 void get_raw_gyros(void);
+void decode_gyros(const uint8_t *Gyros);
 
 //************************************************************
 // Defines
@@ -83,9 +86,14 @@ int16_t gyroADC[NUMBEROFAXIS];			// Holds Gyro ADCs
 
 void ReadGyros(void)					// Conventional orientation
 {
-	uint8_t i;
-
 	get_raw_gyros();					// Updates gyroADC[]
+	ProcessGyros();
+}
+
+// Remove zeros and correct polarity of the raw gyroADC[] data
+void ProcessGyros(void)
+{
+	uint8_t i;
 
 	for (i=0; i<NUMBEROFAXIS; i++)	
 	{
@@ -99,14 +107,21 @@ void ReadGyros(void)					// Conventional orientation
 
 void get_raw_gyros(void)
 {
-	int16_t RawADC[NUMBEROFAXIS];
-	uint8_t i;
 	uint8_t Gyros[6];
-	int16_t temp1, temp2;
 
 	// Get the i2c data from the MPU6050
 	readI2CbyteArray(MPU60X0_DEFAULT_ADDRESS,MPU60X0_RA_GYRO_XOUT_H,(uint8_t *)Gyros,6);
 
+	decode_gyros(Gyros);
+}
+
+// Fill gyroADC[] from the six GYRO_XOUT_H to GYRO_ZOUT_L bytes
+void decode_gyros(const uint8_t *Gyros)
+{
+	int16_t RawADC[NUMBEROFAXIS];
+	uint8_t i;
+	int16_t temp1, temp2;
+
 	// Reassemble data into gyroADC array and down-sample to reduce resolution and noise
 	temp1 = Gyros[0] << 8;
 	temp2 = Gyros[1];
@@ -163,10 +178,10 @@ bool CalibrateGyrosSlow(void)
 	float 		GyroSmooth[NUMBEROFAXIS];
 	int16_t		GyroOld[NUMBEROFAXIS] = {0,0,0};
 	uint16_t	Stable_counter = 0;	
-	uint16_t	Gyro_timeout = 0;
+	uint32_t	Gyro_start = ticks_now();
+	uint32_t	Gyro_ticks;
 	uint8_t		axis;
 	uint8_t		Gyro_seconds = 0;
-	uint8_t		Gyro_TCNT2 = 0;
 	bool		Gyros_Stable = false;
 
 	// Populate Config.gyroZero[] with ballpark figures
@@ -182,15 +197,13 @@ bool CalibrateGyrosSlow(void)
 	// Wait until gyros stable. Timeout after CAL_TIMEOUT seconds
 	while (!Gyros_Stable && ((Gyro_seconds <= CAL_TIMEOUT)))
 	{
-		// Update status timeout
-		Gyro_timeout += (uint8_t)(TCNT2 - Gyro_TCNT2);
-		Gyro_TCNT2 = TCNT2;
-
 		// Count elapsed seconds
-		if (Gyro_timeout > SECOND_TIMER)
+		Gyro_ticks = ticks_now();
+
+		if (TICKS_EXPIRED(Gyro_start, Gyro_ticks, SECOND_TIMER))
 		{
 			Gyro_seconds++;
-			Gyro_timeout = 0;
+			Gyro_start = Gyro_ticks;
 		}
 
 		get_raw_gyros();
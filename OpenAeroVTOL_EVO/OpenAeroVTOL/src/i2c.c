@@ -7,51 +7,61 @@
 //***********************************************************
 
 #include <avr/io.h>
+#include <stdbool.h>
+#include <string.h>
 #include "io_cfg.h"
-#include "i2cmaster.h"
+#include "twi_isr.h"
 #include "compiledefs.h"
 
 //************************************************************
 // Prototypes
 //************************************************************
 
-void writeI2Cbyte(uint8_t address, uint8_t location, uint8_t value);
+bool writeI2Cbyte(uint8_t address, uint8_t location, uint8_t value);
 void readI2CbyteArray(uint8_t address, uint8_t location, uint8_t *array,uint8_t size);
 
 //************************************************************
 // Code
 //************************************************************
 
-void writeI2Cbyte(uint8_t address, uint8_t location, uint8_t value)
+// Blocking register access through the TWI queue.
+// Both wait at most TWI_TIMEOUT, so a dead bus no longer hangs the board.
+// If the queue is full of background requests, they are let finish first.
+
+// Returns false if the write could not be queued or did not complete
+bool writeI2Cbyte(uint8_t address, uint8_t location, uint8_t value)
 {
-    i2c_start_wait(address+I2C_WRITE);				// Set up device address 
-    i2c_write(location);							// Set up register address 
-    i2c_write(value); 								// Write byte
-    i2c_stop();
+	volatile uint8_t status;
+
+	if (!twi_write(address, location, &value, 1, &status))
+	{
+		twi_flush();
+
+		if (!twi_write(address, location, &value, 1, &status))
+		{
+			return false;
+		}
+	}
+
+	return twi_wait(&status);
 }
 
 void readI2CbyteArray(uint8_t address, uint8_t location, uint8_t *array,uint8_t size)
 {
-	int i=0;
+	volatile uint8_t status;
 
-    i2c_start_wait(address+I2C_WRITE);
-    i2c_write(location);							// Set up register address 
-    i2c_rep_start(address+I2C_READ);
-
-	while (i < size)
+	if (!twi_read(address, location, array, size, &status))
 	{
-		if ((i+1)!=size)
-		{
-			array[i]=i2c_readAck();
-		}
-		else
+		twi_flush();
+
+		if (!twi_read(address, location, array, size, &status))
 		{
-			array[i]=i2c_readNak(); 				// Read without ACK on last byte
+			status = TWI_ERROR;
 		}
-		i++;
 	}
 
-    i2c_stop();
+	if ((status == TWI_ERROR) || !twi_wait(&status))
+	{
+		memset(array, 0, size);						// As the polled driver returned on a timeout
+	}
 }
-
-
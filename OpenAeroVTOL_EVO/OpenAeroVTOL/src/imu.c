@@ -25,21 +25,33 @@
 #include "menu_ext.h"
 #include "rc.h"
 #include "isr.h"
+#include "filters.h"
 
 //************************************************************
 // IMU Prototypes
 //************************************************************
 
 void imu_update(uint32_t period);
-void Rotate3dVector(float intervalf);
 void ExtractEulerAngles(void);
+void reset_IMU(void);
 
+#ifdef IMU_QUATERNION
+void imu_quat_update(uint32_t period);
+#endif
+
+#ifdef IMU_FIXED
+void Rotate3dVector(uint16_t scale);
+int32_t thetascale(int32_t gyro, uint16_t scale);
+void RotateVector(int32_t angle);
+int32_t ext2(int32_t Vector);
+#else
+void Rotate3dVector(float intervalf);
 float small_sine(float angle);
 float small_cos(float angle);
 float thetascale(float gyro, float intervalf);
 void RotateVector(float angle);
 float ext2(float Vector);
-void reset_IMU(void);
+#endif
 
 //************************************************************
 // 	Defines
@@ -60,11 +72,59 @@ void reset_IMU(void);
 
 #define maxdeltaangle		0.2618f		// Limit possible instantaneous change in angle to +/-15 degrees (720 deg/s)
 
+#define GYROSCALE_Q44		119944UL	// GYROSENSRADIANS / 2500000 in Q44. Rad per LSB per Timer1 tick
+#define GYROSCALE_FRAC		54408U		// GYROSCALE_Q44 - 65536
+#define ACC_1_15G_SQ		21668UL
+#define ACC_0_85G_SQ		11837UL
+
+										// Quaternion engine fixed-point formats:
+										// Quaternion, up vector, acc	Q30
+										// Half angle per loop			Q32 radians
+										// Rates						Q4 gyro LSBs
+										// Gyro bias					Q16 gyro LSBs
+#define QUAT_ONE			1073741824L	// 1.0 in Q30
+#define QUAT_PERIOD_MAX		35800UL		// Longest period integrated in one step (14.3ms), so scale fits 16 bits
+#define QUAT_RATE_MAX		32767L		// Rate limit, 2048 gyro LSBs in Q4 (2000 deg/s)
+#define QUAT_BIAS_MAX		(64L << 16)	// Gyro bias estimate limit, 64 gyro LSBs in Q16 (62 deg/s)
+#define QUAT_BIAS_SHIFT		14			// Bias integral time constant, about 15s
+#define QUAT_ACC_SHIFT		5			// AccState[] Q8 to Q10 g (1024 = 1g)
+#define ACC_Q30_SHIFT		5			// Q10 acc * Q15 reciprocal = Q25
+
+#ifdef IMU_FIXED
+										// Fixed-point formats:
+										// Vector	Q30, 1.0 = 1073741824
+										// theta	Q32 radians
+										// Gyro		Q4 LSBs
+										// Angles	Q8 degrees
+#define VECTOR_ONE			1073741824L	// 1.0 in Q30
+#define VECTOR_HALF			536870912L	// 0.5 in Q30
+#define MAXDELTA_Q32		1124422438L	// maxdeltaangle in Q32
+#define EULER_Q8			92160L		// 90 degrees, scaled so that mul_q32(Q30 vector) gives Q8 degrees
+#define SMALLANGLE_Q8		169			// SMALLANGLEFACTOR in Q8
+#define DEG180_Q8			46080L		// 180 degrees in Q8
+#else
+#define VECTOR_ONE			1.0f
+#endif
+
 
 //************************************************************
 // 	Globals
 //************************************************************
 
+#ifdef IMU_FIXED
+int32_t VectorA, VectorB;
+
+int32_t VectorX = 0;					// Initialise the vector to point straight up
+int32_t VectorY = 0;
+int32_t VectorZ = VECTOR_ONE;
+
+int32_t VectorNewA, VectorNewB;
+int32_t GyroPitchVC, GyroRollVC;
+int32_t AccAnglePitch, AccAngleRoll, EulerAngleRoll, EulerAnglePitch;
+
+// Reciprocals of the CF divisor (11 - Config.CF_factor) in Q12
+const uint16_t CF_recip[11] PROGMEM = {0,4096,2048,1365,1024,819,683,585,512,455,410};
+#else
 float VectorA, VectorB;
 
 float VectorX = 0;						// Initialise the vector to point straight up
@@ -74,17 +134,22 @@ float VectorZ = 1;
 float VectorNewA, VectorNewB;
 float GyroPitchVC, GyroRollVC;
 float AccAnglePitch, AccAngleRoll, EulerAngleRoll, EulerAnglePitch;
+#endif
 
-float 	accSmooth[NUMBEROFAXIS];		// Filtered acc data
+int16_t	accSmooth[NUMBEROFAXIS];		// Filtered acc data, 128 = 1g
 int16_t	angle[2];						// Attitude in degrees - pitch and roll
 
-// Software LPF conversion table 5Hz, 10Hz, 21Hz, 32Hz, 44Hz, 74Hz, None
-//const uint8_t LPF_lookup[7] PROGMEM  = {23,12,6,4,3,2,1}; // 700Hz
-	
-// Software LPF conversion table 5Hz, 10Hz, 21Hz, 44Hz, 94Hz, 184Hz, 260Hz, None	
-const float LPF_lookup[8] PROGMEM		= {23.0,11.58,5.85,3.1,1.82,1.35,1.24,1.0};	// 700Hz (All settings usable)
-const float LPF_lookup_HS[8] PROGMEM	= {8.53,4.53,2.49,1.58,1.24,1.0,1.0,1.0};	// 250Hz (Cannot use 184Hz, 260Hz settings)
-	
+#ifdef IMU_QUATERNION
+int32_t Quat[4] = {QUAT_ONE, 0, 0, 0};	// Attitude quaternion (w, x, y, z), body to earth
+int32_t QuatBias[3];					// Gyro bias estimate (x, y, z)
+int32_t QuatUp[3] = {0, 0, QUAT_ONE};	// Estimated up vector (x, y, z) from Quat
+
+// Quaternion engine acc correction gain for Config.CF_factor (1 to 10).
+// Matches the vector engine's 1/(11 - CF_factor) gyro LSBs per degree, 
+// as Q4 gyro LSBs per radian of error in Q8 (57.3 * 4 / (11 - CF_factor))
+const uint16_t Quat_Kp[11] PROGMEM = {0,5867,6519,7334,8382,9778,11734,14668,19557,29335,58671};
+#endif
+
 //************************************************************
 // Code
 //
@@ -126,53 +191,260 @@ const float LPF_lookup_HS[8] PROGMEM	= {8.53,4.53,2.49,1.58,1.24,1.0,1.0,1.0};	/
 //
 //
 
+//************************************************************
+// Fixed-point helpers. These only use 16x16 bit multiplies,
+// which the AVR does in hardware
+//************************************************************
+
+#ifdef IMU_QUATERNION
+// Top half of a signed 32x32 bit multiply from three 16x16 bit multiplies.
+// The low half products are dropped, so it reads up to 3 LSBs low.
+static inline int32_t qmul(int32_t a, int32_t b)
+{
+	int16_t ah = (int16_t)(a >> 16);
+	int16_t bh = (int16_t)(b >> 16);
+	uint16_t al = (uint16_t)a;
+	uint16_t bl = (uint16_t)b;
+
+	return ((int32_t)ah * bh) + (((int32_t)ah * bl) >> 16) + (((int32_t)bh * al) >> 16);
+}
+#endif
+
+#if defined(IMU_FIXED) || defined(IMU_QUATERNION)
+// Rad per gyro LSB over (period) in Q28. (period) is in units of 400ns and is
+// limited to QUAT_PERIOD_MAX so that the result fits 16 bits.
+// GYROSCALE_Q44 is 1 + GYROSCALE_FRAC/65536 in Q16, which leaves one multiply.
+static uint16_t gyro_scale(uint32_t period)
+{
+	if (period > QUAT_PERIOD_MAX)
+	{
+		period = QUAT_PERIOD_MAX;
+	}
+
+	return (uint16_t)period + (uint16_t)(((uint32_t)(uint16_t)period * GYROSCALE_FRAC) >> 16);
+}
+#endif
+
+#ifdef IMU_FIXED
+
+// Top half of a signed 32x32 bit multiply, rounded to nearest so that
+// repeated rotations do not drift the vector in one direction.
+// As qmul() but the middle products are halved so that they can be summed
+// with the low product before rounding, which costs a fourth multiply.
+static inline int32_t mul_q32(int32_t a, int32_t b)
+{
+	int16_t ah = (int16_t)(a >> 16);
+	int16_t bh = (int16_t)(b >> 16);
+	uint16_t al = (uint16_t)a;
+	uint16_t bl = (uint16_t)b;
+	int32_t mid;
+
+	mid = (((int32_t)ah * bl) >> 1) + (((int32_t)bh * al) >> 1) + (((uint32_t)al * bl) >> 17);
+
+	return ((int32_t)ah * bh) + ((mid + 0x4000) >> 15);
+}
+
 void imu_update(uint32_t period)
 {
-	float		tempf, accADCf;
-	float		intervalf;						// Interval in seconds since the last loop
+	uint16_t	scale;							// Q28 radians per gyro LSB over this period
+	int32_t		temp32;
+	uint16_t	recip;
 	int8_t		axis;
 	uint32_t	roll_sq, pitch_sq, yaw_sq;
 	uint32_t 	AccMag = 0;
-		
-	// Work out interval in seconds
-	// Convert (period) from units of 400ns (1/2500000) to seconds (1s/400ns = 2500000)
-	tempf = period;						// Promote uint32_t to float
-	intervalf = tempf/2500000.0f;		// This gives the period in seconds
+	
+	// Work out the rotation per gyro LSB over the interval
+	scale = gyro_scale(period);
 
 	//************************************************************
 	// Acc LPF
 	//************************************************************	
 
-	// Note: Two sets of values for normal and high-speed mode
-	if (Config.Servo_rate != FAST)
+	filter_accs();
+
+#ifdef IMU_QUATERNION
+	// Hand over to the quaternion engine if selected
+	if (Config.IMU_type == IMU_QUAT)
 	{
-		memcpy_P(&tempf, &LPF_lookup[Config.Acc_LPF], sizeof(float));
+		imu_quat_update(period);
+		return;
 	}
-	else
+#endif
+	
+	// Add correction data to gyro inputs based on difference between Euler angles and acc angles
+	// Q8 acc * Q8 factor = Q16, rounded to Q8 degrees
+	AccAngleRoll = ((AccState[ROLL] * SMALLANGLE_Q8) + 128) >> 8;
+	AccAnglePitch = ((AccState[PITCH] * SMALLANGLE_Q8) + 128) >> 8;
+
+	// Copy/promote gyro values for rotate
+	GyroRollVC = (int32_t)gyroADC[ROLL] << 4;
+	GyroPitchVC = (int32_t)gyroADC[PITCH] << 4;
+
+	// Calculate acceleration magnitude.
+	roll_sq = ((int32_t)accADC[ROLL] * accADC[ROLL]);
+	pitch_sq = ((int32_t)accADC[PITCH] * accADC[PITCH]);
+	yaw_sq = ((int32_t)accADC[YAW] * accADC[YAW]);
+	AccMag = roll_sq + pitch_sq + yaw_sq;
+	
+	// Add acc correction if inside local acceleration bounds and not inverted according to VectorZ
+	if	((AccMag > ACC_0_85G_SQ) && (AccMag < ACC_1_15G_SQ) && (VectorZ > VECTOR_HALF))
 	{
-		memcpy_P(&tempf, &LPF_lookup_HS[Config.Acc_LPF], sizeof(float));
+		axis = 11 - Config.CF_factor;
+		if (axis < 1) axis = 1;
+		if (axis > 10) axis = 10;
+		recip = pgm_read_word(&CF_recip[(uint8_t)axis]);
+
+		// Q8 degrees * Q12 reciprocal = Q20, rounded down to Q4
+		temp32 = (EulerAngleRoll - AccAngleRoll) * (int32_t)recip;
+		GyroRollVC += ((temp32 + 32768) >> 16);
+		
+		temp32 = (EulerAnglePitch - AccAnglePitch) * (int32_t)recip;
+		GyroPitchVC += ((temp32 + 32768) >> 16);
 	}
+
+	// Rotate up-direction 3D vector with gyro inputs
+	Rotate3dVector(scale);
+	ExtractEulerAngles();
 	
-	// Smooth Acc signals - note that accSmooth is in [ROLL, PITCH, YAW] order
-	for (axis = 0; axis < NUMBEROFAXIS; axis++)
+	// Convert to 0.01 degrees resolution and copy to angle[] for display
+	angle[ROLL] = (int16_t)((EulerAngleRoll * -100) / 256);
+	angle[PITCH] = (int16_t)((EulerAnglePitch * -100) / 256);
+}
+
+void Rotate3dVector(uint16_t scale)
+{
+	int32_t theta;
+	
+	// Rotate around X axis (pitch)
+	theta = thetascale(GyroPitchVC, scale);
+	VectorA = VectorY;
+	VectorB = VectorZ;
+	RotateVector(theta);
+	VectorY = VectorNewA;
+	VectorZ = VectorNewB;
+
+	// Rotate around Y axis (roll)
+	theta = thetascale(GyroRollVC, scale);
+	VectorA = VectorX;
+	VectorB = VectorZ;
+	RotateVector(theta);
+	VectorX = VectorNewA;
+	VectorZ = VectorNewB;
+
+	// Rotate around Z axis (yaw)
+	theta = thetascale((int32_t)gyroADC[YAW] << 4, scale);
+	VectorA = VectorX;
+	VectorB = VectorY;
+	RotateVector(theta);
+	VectorX = VectorNewA;
+	VectorY = VectorNewB;
+}
+
+// Small angle rotation, as the float version:
+// A' = A.cos - B.sin, B' = A.sin + B.cos with sin = theta, cos = 1 - theta^2/2
+void RotateVector(int32_t angle)
+{
+	int32_t half_sq = mul_q32(angle, angle) >> 1;
+
+	VectorNewA = VectorA - mul_q32(VectorA, half_sq) - mul_q32(VectorB, angle);
+	VectorNewB = VectorB - mul_q32(VectorB, half_sq) + mul_q32(VectorA, angle);
+}
+
+// Q4 gyro * Q28 scale = Q32 radians, limited to +/-15 degrees.
+// The gyro is first limited to 16 bits (2000 deg/s) for a 16x16 bit multiply
+int32_t thetascale(int32_t gyro, uint16_t scale)
+{
+	int32_t theta;
+	
+	if (gyro > INT16_MAX)
 	{
-		accADCf = accADC[axis]; // Promote
-		
-		// Acc LPF
-		if (Config.Acc_LPF != NOFILTER)
+		gyro = INT16_MAX;
+	}
+	
+	if (gyro < -INT16_MAX)
+	{
+		gyro = -INT16_MAX;
+	}
+
+	theta = (int32_t)(int16_t)gyro * scale;
+	
+	if (theta > MAXDELTA_Q32)
+	{
+		theta = MAXDELTA_Q32;
+	}
+	
+	if (theta < -MAXDELTA_Q32)
+	{
+		theta = -MAXDELTA_Q32;
+	}
+	
+	return theta;
+}
+
+void ExtractEulerAngles(void)
+{
+	EulerAngleRoll = ext2(VectorX);
+	EulerAnglePitch = ext2(VectorY);
+}
+
+int32_t ext2(int32_t Vector)
+{
+	int32_t temp;
+	
+	// Rough translation to Euler angles (Q8 degrees)
+	temp = mul_q32(Vector, EULER_Q8);
+
+	// Change 0-90-0 to 0-90-180 so that
+	// swap happens at 100% inverted
+	if (VectorZ < 0)
+	{
+		// CW rotations
+		if (temp > 0)
 		{
-			accSmooth[axis] = ((accSmooth[axis] * (tempf - 1.0f)) - accADCf) / tempf;
+			temp = DEG180_Q8 - temp;
 		}
+		// CCW rotations
 		else
 		{
-			// Use raw accADC[axis] as source for acc values when filter off
-			accSmooth[axis] =  -accADCf;
+			temp = -DEG180_Q8 - temp;
 		}
 	}
+
+	return (temp);
+}
+
+#else
+
+void imu_update(uint32_t period)
+{
+	float		tempf;
+	float		intervalf;						// Interval in seconds since the last loop
+	uint32_t	roll_sq, pitch_sq, yaw_sq;
+	uint32_t 	AccMag = 0;
+		
+	// Work out interval in seconds
+	// Convert (period) from units of 400ns (1/2500000) to seconds (1s/400ns = 2500000)
+	tempf = period;						// Promote uint32_t to float
+	intervalf = tempf/2500000.0f;		// This gives the period in seconds
+
+	//************************************************************
+	// Acc LPF
+	//************************************************************	
+
+	filter_accs();
+
+#ifdef IMU_QUATERNION
+	// Hand over to the quaternion engine if selected
+	if (Config.IMU_type == IMU_QUAT)
+	{
+		imu_quat_update(period);
+		return;
+	}
+#endif
 	
 	// Add correction data to gyro inputs based on difference between Euler angles and acc angles
-	AccAngleRoll = accSmooth[ROLL] * SMALLANGLEFACTOR;		// KK2 - AccYfilter
-	AccAnglePitch = accSmooth[PITCH] * SMALLANGLEFACTOR;
+	AccAngleRoll = (AccState[ROLL] * (1.0f / 256)) * SMALLANGLEFACTOR;		// KK2 - AccYfilter
+	AccAnglePitch = (AccState[PITCH] * (1.0f / 256)) * SMALLANGLEFACTOR;
 
 	// Copy/promote gyro values for rotate
 	GyroRollVC = gyroADC[ROLL];								// KK2 - GyroRoll
@@ -317,12 +589,265 @@ float ext2(float Vector)
 	return (temp);
 }
 
+#endif
+
+#ifdef IMU_QUATERNION
+//************************************************************
+// Quaternion attitude engine (Config.IMU_type = IMU_QUAT)
+//
+// Mahony complementary filter on a fixed-point quaternion. There are
+// no small-angle approximations and no per-loop rotation limit, and 
+// the acc correction includes an integral term that estimates the
+// gyro bias. The body axes are those of VectorX/Y/Z above, which
+// makes the gyro rates x = -pitch, y = roll and z = -yaw.
+//
+// Each loop:
+// 1. Take the error e = a x v, where a is the normalised acc up vector
+//    and v is the up vector estimated last loop, if the acc magnitude 
+//    is near 1g
+// 2. Rate = gyro + Kp.e + bias, where the bias integrates Kp.e
+// 3. Rotate the quaternion by rate * period and renormalise
+// 4. Estimate v from the quaternion
+// 5. Convert v to roll and pitch angles, 0-90-180 as the vector engine
+//************************************************************
+
+// Integer square root of a 32-bit value
+static uint16_t isqrt32(uint32_t x)
+{
+	uint32_t result = 0;
+	uint32_t bit = 1UL << 30;
+
+	while (bit > x)
+	{
+		bit >>= 2;
+	}
+
+	while (bit)
+	{
+		if (x >= (result + bit))
+		{
+			x -= result + bit;
+			result = (result >> 1) + bit;
+		}
+		else
+		{
+			result >>= 1;
+		}
+
+		bit >>= 2;
+	}
+
+	return (uint16_t)result;
+}
+
+// atan(a / b) in 0.01 degrees for Q15 a, b >= 0, accurate to 0.1 degrees.
+// atan(z) = z.pi/4 + z(1 - z)(0.2447 + 0.0663z) for z = 0 to 1
+static int16_t atan_cdeg(uint16_t a, uint16_t b)
+{
+	uint16_t z, temp;
+	int32_t t, u;
+	int16_t result;
+	bool swap = (a > b);
+
+	if (swap)
+	{
+		temp = a;
+		a = b;
+		b = temp;
+	}
+
+	if (b == 0)
+	{
+		return 0;
+	}
+
+	z = (uint16_t)(((uint32_t)a << 15) / b);			// Q15
+	t = 8018 + ((2172UL * z) >> 15);					// 0.2447 + 0.0663z in Q15
+	u = ((uint32_t)z * (uint16_t)(32768U - z)) >> 15;	// z(1 - z) in Q15
+	u = ((uint32_t)(uint16_t)u * (uint16_t)t) >> 15;	// Radians in Q15
+	result = (int16_t)((((uint32_t)z * 4500U) + ((uint32_t)(uint16_t)u * 5730U)) >> 15);
+
+	if (swap)
+	{
+		result = 9000 - result;
+	}
+
+	return result;
+}
+
+// Angle of one up vector component from the horizontal in 0.01 degrees,
+// taken past 90 degrees up to 180 degrees when inverted
+static int16_t quat_angle(int32_t v, int32_t vz)
+{
+	int32_t v_sq = qmul(v, v) << 2;
+	int16_t result;
+
+	if (v_sq > QUAT_ONE)
+	{
+		v_sq = QUAT_ONE;
+	}
+
+	// Q30 component vs Q15 square root of the rest
+	result = atan_cdeg((uint16_t)(labs(v) >> 15), isqrt32((uint32_t)(QUAT_ONE - v_sq)));
+
+	if (vz < 0)
+	{
+		result = 18000 - result;
+	}
+
+	if (v < 0)
+	{
+		result = -result;
+	}
+
+	return result;
+}
+
+void imu_quat_update(uint32_t period)
+{
+	int32_t		acc[3], e[3], dq[4];
+	int32_t		rate[3];
+	int32_t		norm;
+	int32_t		temp32;
+	uint32_t	roll_sq, pitch_sq, yaw_sq;
+	uint32_t	x;
+	uint16_t	x15, y, y_sq;
+	uint16_t	scale, kp;
+	int8_t		axis;
+	bool		correct = false;
+
+	// Rad per gyro LSB over the interval in Q28
+	scale = gyro_scale(period);
+
+	// Gyro rates in body axes
+	rate[0] = -((int32_t)gyroADC[PITCH] << 4);
+	rate[1] = (int32_t)gyroADC[ROLL] << 4;
+	rate[2] = -((int32_t)gyroADC[YAW] << 4);
+
+	// Measured up vector from the acc LPF state, 1024 = 1g
+	acc[0] = AccState[ROLL] >> QUAT_ACC_SHIFT;
+	acc[1] = AccState[PITCH] >> QUAT_ACC_SHIFT;
+	acc[2] = -(AccState[YAW] >> QUAT_ACC_SHIFT);
+
+	// Only correct inside local acceleration bounds, both raw and filtered
+	roll_sq = ((int32_t)accADC[ROLL] * accADC[ROLL]);
+	pitch_sq = ((int32_t)accADC[PITCH] * accADC[PITCH]);
+	yaw_sq = ((int32_t)accADC[YAW] * accADC[YAW]);
+	x = roll_sq + pitch_sq + yaw_sq;
+
+	if ((x > ACC_0_85G_SQ) && (x < ACC_1_15G_SQ))
+	{
+		// Q10 squares are Q20, and 1g is 128 in ACC_xG_SQ
+		x = ((int32_t)(int16_t)acc[0] * (int16_t)acc[0]) + ((int32_t)(int16_t)acc[1] * (int16_t)acc[1]) + ((int32_t)(int16_t)acc[2] * (int16_t)acc[2]);
+		correct = ((x > (ACC_0_85G_SQ << 6)) && (x < (ACC_1_15G_SQ << 6)));
+	}
+
+	if (correct)
+	{
+		// 1/|acc| by Newton-Raphson in Q15, y = y(3 - x.y^2)/2. 
+		// x15 is |acc|^2 in Q15, below 1.15^2 so every product is 16x16 bits
+		x15 = (uint16_t)(x >> 5);
+		y = (uint16_t)((98304UL - x15) >> 1);
+		for (axis = 0; axis < 2; axis++)
+		{
+			y_sq = (uint16_t)(((uint32_t)y * y) >> 15);
+			temp32 = 32768L - (int32_t)(((uint32_t)x15 * y_sq) >> 15);
+			y += (int16_t)(((int32_t)y * (int16_t)temp32) >> 16);
+		}
+
+		for (axis = 0; axis < NUMBEROFAXIS; axis++)
+		{
+			acc[axis] = ((int32_t)(int16_t)acc[axis] * y) << ACC_Q30_SHIFT;
+		}
+
+		// Error between measured and estimated up vectors in Q28
+		e[0] = qmul(acc[1], QuatUp[2]) - qmul(acc[2], QuatUp[1]);
+		e[1] = qmul(acc[2], QuatUp[0]) - qmul(acc[0], QuatUp[2]);
+		e[2] = qmul(acc[0], QuatUp[1]) - qmul(acc[1], QuatUp[0]);
+
+		axis = Config.CF_factor;
+		if (axis < 1) axis = 1;
+		if (axis > 10) axis = 10;
+		kp = pgm_read_word(&Quat_Kp[(uint8_t)axis]);
+
+		for (axis = 0; axis < NUMBEROFAXIS; axis++)
+		{
+			// Q14 error * Q8 gain = Q4 rate correction
+			temp32 = ((int32_t)(int16_t)(e[axis] >> 14) * kp) >> 20;
+			rate[axis] += temp32;
+
+			// Integrate into the gyro bias estimate
+			QuatBias[axis] += ((int32_t)(int16_t)temp32 * scale) >> QUAT_BIAS_SHIFT;
+
+			if (QuatBias[axis] > QUAT_BIAS_MAX)
+			{
+				QuatBias[axis] = QUAT_BIAS_MAX;
+			}
+			else if (QuatBias[axis] < -QUAT_BIAS_MAX)
+			{
+				QuatBias[axis] = -QUAT_BIAS_MAX;
+			}
+		}
+	}
+
+	// Half angles over the interval in Q32 radians
+	for (axis = 0; axis < NUMBEROFAXIS; axis++)
+	{
+		temp32 = rate[axis] + (QuatBias[axis] >> 12);
+
+		if (temp32 > QUAT_RATE_MAX)
+		{
+			temp32 = QUAT_RATE_MAX;
+		}
+		else if (temp32 < -QUAT_RATE_MAX)
+		{
+			temp32 = -QUAT_RATE_MAX;
+		}
+
+		rate[axis] = ((int32_t)(int16_t)temp32 * scale) >> 1;
+	}
+
+	// q = q + q x (0, half angles)
+	dq[0] = -qmul(Quat[1], rate[0]) - qmul(Quat[2], rate[1]) - qmul(Quat[3], rate[2]);
+	dq[1] =  qmul(Quat[0], rate[0]) + qmul(Quat[2], rate[2]) - qmul(Quat[3], rate[1]);
+	dq[2] =  qmul(Quat[0], rate[1]) - qmul(Quat[1], rate[2]) + qmul(Quat[3], rate[0]);
+	dq[3] =  qmul(Quat[0], rate[2]) + qmul(Quat[1], rate[1]) - qmul(Quat[2], rate[0]);
+
+	for (axis = 0; axis < 4; axis++)
+	{
+		Quat[axis] += dq[axis];
+	}
+
+	// Renormalise. As |q| stays close to 1, 1/|q| = 1 + (1 - |q|^2) / 2
+	for (axis = 0; axis < 4; axis++)
+	{
+		dq[axis] = qmul(Quat[axis], Quat[axis]);
+	}
+	norm = (dq[0] + dq[1] + dq[2] + dq[3]) << 2;
+	temp32 = (QUAT_ONE - norm) << 1;
+
+	for (axis = 0; axis < 4; axis++)
+	{
+		Quat[axis] += qmul(Quat[axis], temp32);
+	}
+
+	// Estimated up vector from the third row of the rotation matrix
+	QuatUp[0] = (qmul(Quat[1], Quat[3]) - qmul(Quat[0], Quat[2])) << 3;
+	QuatUp[1] = (qmul(Quat[0], Quat[1]) + qmul(Quat[2], Quat[3])) << 3;
+	QuatUp[2] = (qmul(Quat[0], Quat[0]) - qmul(Quat[1], Quat[1]) - qmul(Quat[2], Quat[2]) + qmul(Quat[3], Quat[3])) << 2;
+
+	// Convert to 0.01 degrees resolution and copy to angle[]
+	angle[ROLL] = -quat_angle(QuatUp[0], QuatUp[2]);
+	angle[PITCH] = -quat_angle(QuatUp[1], QuatUp[2]);
+}
+#endif
+
 void reset_IMU(void)
 {
 	// Initialise the vector to point straight up
 	VectorX = 0;
 	VectorY = 0;
-	VectorZ = 1;
+	VectorZ = VECTOR_ONE;
 	
 	// Initialise internal vectors and attitude	
 	VectorA = 0;
@@ -330,6 +855,20 @@ void reset_IMU(void)
 	EulerAngleRoll = 0;
 	EulerAnglePitch = 0;
 
+#ifdef IMU_QUATERNION
+	// Level quaternion with no gyro bias
+	Quat[0] = QUAT_ONE;
+	Quat[1] = 0;
+	Quat[2] = 0;
+	Quat[3] = 0;
+	QuatBias[ROLL] = 0;
+	QuatBias[PITCH] = 0;
+	QuatBias[YAW] = 0;
+	QuatUp[0] = 0;
+	QuatUp[1] = 0;
+	QuatUp[2] = QUAT_ONE;
+#endif
+
 	// Reset loop count to zero
 	TMR0_counter = 0;	// TMR0 overflow counter
 	TCNT1 = 0;			// TCNT1 current time
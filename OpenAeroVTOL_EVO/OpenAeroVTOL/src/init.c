@@ -17,11 +17,13 @@
 #include "io_cfg.h"
 #include "isr.h"
 #include "rc.h"
+#include "serial_rx.h"
 #include "main.h"
 #include "adc.h"
 #include "vbat.h"
 #include "servos.h"
 #include "gyros.h"
+#include "sensors.h"
 #include "acc.h"
 #include "mixer.h"
 #include "glcd_driver.h"
@@ -29,6 +31,7 @@
 #include <avr/pgmspace.h>
 #include "glcd_menu.h"
 #include "pid.h"
+#include "filters.h"
 #include "menu_ext.h"
 #include "imu.h"
 #include "uart.h"
@@ -122,11 +125,11 @@ void init(void)
 	TCCR1B |= (1 << CS11);					// Clk/8 = 2.5MHz
 
 	// Timer2 8bit - run @ 20MHz / 1024 = 19.531kHz or 51.2us - max 13.1ms
-	// Used to time arm/disarm intervals
+	// Overflows are counted to make the 32-bit system tick (ticks.c)
 	TCCR2A = 0;	
 	TCCR2B = 0x07;							// Clk/1024 = 19.531kHz
-	TIMSK2 = 0;
-	TIFR2 = 0;
+	TIMSK2 = (1 << TOIE2);					// Enable overflow interrupts
+	TIFR2 = (1 << TOV2);					// Clear any pending overflow
 	TCNT2 = 0;								// Reset counter
 
 	//***********************************************************
@@ -302,6 +305,9 @@ void init(void)
 	i2c_init();
 	init_i2c_gyros();
 	init_i2c_accs();
+#ifdef MPU6050_FIFO
+	init_sensor_fifo();
+#endif
 
 	//***********************************************************
 	// Remaining init tasks
@@ -336,6 +342,7 @@ void init(void)
 	// Update voltage detection
 	SystemVoltage = GetVbat();				// Check power-up battery voltage
 	UpdateLimits();							// Update travel and trigger limits
+	init_filters();							// Set up the acc and gyro filters
 
 	// Disarm on start-up if Armed setting is ARMABLE
 	if (Config.ArmMode == ARMABLE)
@@ -344,6 +351,7 @@ void init(void)
 	}
 
 	// Check to see that throttle is low if RC detected
+	RxDecodeSerial();
 	if (Interrupted)
 	{
 		RxGetChannels();
@@ -0,0 +1,151 @@
+//***********************************************************
+//* loop_timing.c
+//*
+//* Per-stage main loop timing, enabled by LOOP_TIMING.
+//* Each LOOP_STAGE() marker in FC_main.c stamps TCNT1 and
+//* charges the time since the previous marker to the stage
+//* that was running. At the top of each loop the time spent
+//* in every stage that ran is folded into its min/max/mean
+//* and a histogram. The last entry holds the whole loop.
+//*
+//* Times are in TCNT1 ticks (400ns). Spans longer than one
+//* TCNT1 period (26.2ms) cannot be measured.
+//***********************************************************
+
+//***********************************************************
+//* Includes
+//***********************************************************
+
+#include "compiledefs.h"
+#include <avr/io.h>
+#include <stdbool.h>
+#include <string.h>
+#include "io_cfg.h"
+#include "isr.h"
+
+#ifdef LOOP_TIMING
+
+//************************************************************
+// Prototypes
+//************************************************************
+
+void loop_timing_mark(uint8_t stage);
+void loop_timing_reset(void);
+
+//************************************************************
+// Defines
+//************************************************************
+
+#define TIMING_SHIFT	6			// First histogram bucket is below 64 ticks (25.6us)
+
+//************************************************************
+// Data
+//************************************************************
+
+stage_timing_t StageTiming[NUMBEROFSTAGES + 1];	// Per stage, then the whole loop
+
+static uint16_t StageTicks[NUMBEROFSTAGES];		// Time in each stage during this loop
+static uint16_t StageRan;						// Stages that ran during this loop
+static uint16_t MarkTCNT1;						// TCNT1 at the last marker
+static uint16_t LoopTCNT1;						// TCNT1 at the top of this loop
+static uint8_t CurrentStage = STAGE_MAIN;
+static bool TimingStarted = false;
+
+//************************************************************
+// Code
+//************************************************************
+
+// Add one loop's worth of time to a stage's statistics
+static void add_timing(stage_timing_t *timing, uint16_t ticks)
+{
+	uint16_t temp = ticks >> TIMING_SHIFT;
+	uint8_t bucket = 0;
+	uint8_t i;
+
+	// Halve the history rather than let the count wrap
+	if (timing->count == 0xFFFF)
+	{
+		timing->count >>= 1;
+		timing->sum >>= 1;
+
+		for (i = 0; i < TIMING_BUCKETS; i++)
+		{
+			timing->hist[i] >>= 1;
+		}
+	}
+
+	if ((timing->count == 0) || (ticks < timing->min))
+	{
+		timing->min = ticks;
+	}
+
+	if (ticks > timing->max)
+	{
+		timing->max = ticks;
+	}
+
+	timing->sum += ticks;
+	timing->count++;
+
+	// Buckets double in width: <25.6us, <51us, <102us ... >=1.64ms
+	while ((temp != 0) && (bucket < (TIMING_BUCKETS - 1)))
+	{
+		temp >>= 1;
+		bucket++;
+	}
+
+	timing->hist[bucket]++;
+}
+
+// Called by LOOP_STAGE() on entry to each stage
+void loop_timing_mark(uint8_t stage)
+{
+	uint16_t now = TIM16_ReadTCNT1();
+	uint16_t elapsed = now - MarkTCNT1;
+	uint8_t i;
+
+	// Charge the time since the last marker to the stage that was running
+	if (StageTicks[CurrentStage] > (0xFFFF - elapsed))
+	{
+		StageTicks[CurrentStage] = 0xFFFF;
+	}
+	else
+	{
+		StageTicks[CurrentStage] += elapsed;
+	}
+
+	StageRan |= (1 << CurrentStage);
+	MarkTCNT1 = now;
+	CurrentStage = stage;
+
+	// Top of a new loop. Fold the last one into the statistics
+	if (stage == STAGE_LOOP)
+	{
+		if (TimingStarted)
+		{
+			for (i = 0; i < NUMBEROFSTAGES; i++)
+			{
+				if (StageRan & (1 << i))
+				{
+					add_timing(&StageTiming[i], StageTicks[i]);
+				}
+			}
+
+			add_timing(&StageTiming[NUMBEROFSTAGES], now - LoopTCNT1);
+		}
+
+		memset(StageTicks, 0, sizeof(StageTicks));
+		StageRan = 0;
+		LoopTCNT1 = now;
+		TimingStarted = true;
+	}
+}
+
+// Clear the statistics. The next complete loop starts them again
+void loop_timing_reset(void)
+{
+	memset(StageTiming, 0, sizeof(StageTiming));
+	TimingStarted = false;
+}
+
+#endif // LOOP_TIMING
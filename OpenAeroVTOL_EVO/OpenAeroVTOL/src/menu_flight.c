@@ -34,7 +34,7 @@ void menu_flight(uint8_t i);
 // Defines
 //************************************************************
 
-#define FLIGHTSTART 170 // Start of Menu text items
+#define FLIGHTSTART 172 // Start of Menu text items
 #define FLIGHTOFFSET 79	// LCD offsets
 #define FLIGHTTEXT 38 	// Start of value text items
 #define FLIGHTITEMS 18 	// Number of menu items
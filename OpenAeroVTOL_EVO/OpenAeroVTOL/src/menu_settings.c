@@ -27,6 +27,8 @@
 #include "i2c.h"
 #include "isr.h"
 #include "MPU6050.h"
+#include "sensors.h"
+#include "filters.h"
 
 //************************************************************
 // Prototypes
@@ -34,6 +36,8 @@
 
 // Menu items
 void menu_rc_setup(uint8_t section);
+void get_general_items(int8_t *items);
+void set_general_items(int8_t *items);
 
 //************************************************************
 // Defines
@@ -46,9 +50,10 @@ void menu_rc_setup(uint8_t section);
 #define GENERALTEXT	124
 #define RCITEMS 9 		// Number of menu items displayed
 #define RCITEMSOFFSET 9 // Actual number of menu items
-#define GENERALITEMS 10
+#define GENERALITEMS 14
 
-#define PRESETITEM 167	// Location of Preset menu item in list
+#define PRESETITEM 171	// Location of Preset menu item in list
+#define GENERALBLOCK 8	// General items stored together in Config, Orientation to Gyro_LPF
 
 //************************************************************
 // RC menu items
@@ -57,14 +62,14 @@ void menu_rc_setup(uint8_t section);
 const uint16_t RCMenuText[2][GENERALITEMS] PROGMEM = 
 {
 	{RCTEXT, 118, 105, 116, 105, 0, 0, 0, 0},		// RC setup
-	{GENERALTEXT, 0, 53, 0, 0, 37, 37, 37, 0, 273},	// General 
+	{GENERALTEXT, 0, 53, 0, 0, 37, 37, 37, 0, 0, 0, 73, 0, 273},	// General 
 };
 
 const menu_range_t rc_menu_ranges[2][GENERALITEMS] PROGMEM = 
 {
 	{
 		// RC setup (9)					// Min, Max, Increment, Style, Default
-		{CPPM_MODE,XTREME,1,1,SBUS},	// Receiver type
+		{CPPM_MODE,CRSF,1,1,SBUS},		// Receiver type
 		{LOW,FAST,1,1,FAST},			// Servo rate
 		{THROTTLE,GEAR,1,1,GEAR},		// PWM sync channel
 		{JRSEQ,FUTABASEQ,1,1,JRSEQ}, 	// Channel order
@@ -75,7 +80,7 @@ const menu_range_t rc_menu_ranges[2][GENERALITEMS] PROGMEM =
 		{-127,127,1,0,0},				// Pitch D-term - Debug
 	},
 	{
-		// General (10)
+		// General (14)
 		{HORIZONTAL,PITCHUP,1,1,HORIZONTAL}, // Orientation
 		// Limit contrast range for KK2 Mini
 #ifdef KK2Mini
@@ -89,7 +94,15 @@ const menu_range_t rc_menu_ranges[2][GENERALITEMS] PROGMEM =
 		{HZ5,HZ260,1,1,HZ44},			// MPU6050 LPF. Default is 44Hz
 		{HZ5,NOFILTER,1,1,HZ21},		// Acc. LPF 21Hz default	(5, 10, 21, 44, 94, 184, 260, None)
 		{HZ5,NOFILTER,1,1,NOFILTER},	// Gyro LPF. No LPF default (5, 10, 21, 44, 94, 184, 260, None)
+		{0,40,1,0,0},					// Gyro notch 1 in 10Hz steps. Off by default
+		{0,40,1,0,0},					// Gyro notch 2
 		{1,10,1,0,7},					// AL correction
+#ifdef IMU_QUATERNION
+		{IMU_VECTOR,IMU_QUAT,1,1,IMU_VECTOR}, // IMU type
+#else
+		{IMU_VECTOR,IMU_VECTOR,1,1,IMU_VECTOR}, // IMU type (vector engine only)
+#endif
+		{0,100,1,0,0},					// CPPM slew limit in % per frame. Filter off by default
 		{QUADX,BLANK,1,4,QUADX},		// Mixer preset (note: style 4)
 	}
 };
@@ -97,9 +110,34 @@ const menu_range_t rc_menu_ranges[2][GENERALITEMS] PROGMEM =
 // Main menu-specific setup
 //************************************************************
 
+// Newer General items are kept at the end of Config, so the General menu 
+// edits a copy of its items laid out in menu order.
+void get_general_items(int8_t *items)
+{
+	memcpy(items, &Config.Orientation, GENERALBLOCK);
+	items[8] = Config.Gyro_notch1;
+	items[9] = Config.Gyro_notch2;
+	items[10] = Config.CF_factor;
+	items[11] = Config.IMU_type;
+	items[12] = Config.CPPM_slew;
+	items[13] = Config.Preset;
+}
+
+void set_general_items(int8_t *items)
+{
+	memcpy(&Config.Orientation, items, GENERALBLOCK);
+	Config.Gyro_notch1 = items[8];
+	Config.Gyro_notch2 = items[9];
+	Config.CF_factor = items[10];
+	Config.IMU_type = items[11];
+	Config.CPPM_slew = items[12];
+	Config.Preset = items[13];
+}
+
 void menu_rc_setup(uint8_t section)
 {
 	int8_t *value_ptr = &Config.RxMode;
+	int8_t general_items[GENERALITEMS];
 
 	menu_range_t range;
 	uint16_t	text_link;
@@ -125,7 +163,7 @@ void menu_rc_setup(uint8_t section)
 			case 2:				// General menu
 				offset = RCITEMSOFFSET;
 				items = GENERALITEMS;
-				value_ptr = &Config.Orientation;
+				value_ptr = general_items;
 				break;
 			default:
 				break;
@@ -133,6 +171,7 @@ void menu_rc_setup(uint8_t section)
 
 		// Always show preset text as "Options", regardless of actual setting
 		Config.Preset = OPTIONS;
+		get_general_items(general_items);
 
 		// Print menu - note that print_menu_items() updates button variable.
 		print_menu_items(sub_top + offset, RCSTART + offset, value_ptr, (const unsigned char*)rc_menu_ranges[section - 1], 0, RCOFFSET, (const uint16_t*)RCMenuText[section - 1], cursor);
@@ -145,12 +184,18 @@ void menu_rc_setup(uint8_t section)
 		if (menu_temp == PRESETITEM)
 		{
 			Config.Preset = QUADX;			
+			general_items[GENERALITEMS - 1] = QUADX;
 		}
 
 		if (button == ENTER)
 		{
 			text_link = pgm_read_word(&RCMenuText[section - 1][menu_temp - RCSTART - offset]);
 			do_menu_item(menu_temp, value_ptr + (menu_temp - RCSTART - offset), 1, range, 0, text_link, false, 0);
+
+			if (section == 2)
+			{
+				set_general_items(general_items);
+			}
 		}
 
 		// Handle abort neatly
@@ -167,7 +212,6 @@ void menu_rc_setup(uint8_t section)
 		{
 			init_int();				// In case RC type has changed, reinitialise interrupts
 			init_uart();			// and UART
-			UpdateLimits();			// Update I-term limits and triggers based on percentages
 			
 			// See if mixer preset has changed. Load new preset only if so
 			if ((Config.Preset != OPTIONS) && (menu_temp == PRESETITEM))
@@ -175,8 +219,14 @@ void menu_rc_setup(uint8_t section)
 				Load_eeprom_preset(Config.Preset);
 			}
 
+			UpdateLimits();			// Update I-term limits, triggers and mixer based on percentages
+			init_filters();			// Redesign the acc and gyro filters
+
 			// Update MPU6050 LPF and reverse sense of menu items
 			writeI2Cbyte(MPU60X0_DEFAULT_ADDRESS, MPU60X0_RA_CONFIG, (6 - Config.MPU6050_LPF));
+#ifdef MPU6050_FIFO
+			init_sensor_fifo();		// Sample rate divider depends on the LPF
+#endif
 
 			// Update channel sequence
 			for (i = 0; i < MAX_RC_CHANNELS; i++)
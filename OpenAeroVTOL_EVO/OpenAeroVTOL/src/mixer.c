@@ -30,6 +30,7 @@
 void ProcessMixer(void);
 void UpdateServos(void);
 void UpdateLimits(void);
+void CompileMixer(void);
 void get_preset_mix (const channel_t*);
 int16_t scale32(int16_t value16, int16_t multiplier16);
 int16_t scale_percent(int8_t value);
@@ -40,6 +41,20 @@ int16_t scale_percent_nooffset(int8_t value);
 //************************************************************
 
 #define MIX_OUTPUTS 8
+#define MIX_MAXTERMS 11			// 3 gyros, 3 accs, 3 dedicated RC and 2 other sources
+#define MIX_SOURCES 16			// RC inputs, sensors, then Z acc
+#define MIX_ZACC 15				// Source index for Z acc (same slot as NOMIX)
+
+// Convert a percentage to a Q12 gain (4096 = 100%) without dividing by 100
+#define PCT_TO_Q12(pct) ((int16_t)((((int32_t)(pct) * 10486) + 128) >> 8))
+#define Q12_100PCT 4096
+
+// The same in Q15 (32768 = 100%) for the P1/P2 crossfade, as it scales whole channel values
+#define PCT_TO_Q15(pct) ((uint16_t)((((int32_t)(pct) * 83886) + 128) >> 8))
+#define Q15_100PCT 32768
+
+#define MIXTERM_SOURCE 0x0f		// Source index mask
+#define MIXTERM_SUB 0x80		// Term is subtracted from the solution
 
 //************************************************************
 // Defines
@@ -77,431 +92,186 @@ const int8_t SQRTSIN[101] PROGMEM =
 #define EXT_SOURCE 8	// Offset for indexing sensor sources
 
 //************************************************************
-// Code
+// Data
 //************************************************************
 
-void ProcessMixer(void)
-{
-	uint8_t i = 0;
-	uint8_t j = 0;
-	int16_t P1_solution = 0;
-	int16_t P2_solution = 0;
+// Mixer terms compiled from Config.Channel[] by CompileMixer()
+mix_term_t	MixTerms[FLIGHT_MODES][MIX_OUTPUTS][MIX_MAXTERMS];
+uint8_t		MixTermCount[FLIGHT_MODES][MIX_OUTPUTS];
+offset_curve_t OffsetCurve[MIX_OUTPUTS];
+int16_t		ThrottleStep[MIX_OUTPUTS];		// Throttle curve step per transition % * 128
 
-	int16_t temp1 = 0;
-	int16_t temp2 = 0;
-	int16_t	temp3 = 0;
-	int16_t	Step1 = 0;
-	int16_t	Step2 = 0;
-	int8_t	itemp8 = 0;
+// Transition-dependent gains, refreshed by UpdateTransitionGains() when transition changes
+int16_t		MixTransition = -1;				// Transition value the gains were calculated for
+uint16_t	TransitionGain[FLIGHT_MODES];	// P1/P2 crossfade weights in Q15, summing to 100%
+int16_t		ThrottleGain[MIX_OUTPUTS];		// Throttle volume at this transition in Q12
 
-	// Copy the sensor data to an array for easy indexing - acc data is from accSmooth, increased to reasonable rates
-	temp1 = (int16_t)accSmooth[ROLL] << 3;
-	temp2 = (int16_t)accSmooth[PITCH] << 3;
-	int16_t	SensorDataP1[7] = {PID_Gyros[P1][ROLL], PID_Gyros[P1][PITCH], PID_Gyros[P1][YAW], temp1, temp2, PID_ACCs[P1][ROLL], PID_ACCs[P1][PITCH]};
-	int16_t	SensorDataP2[7] = {PID_Gyros[P2][ROLL], PID_Gyros[P2][PITCH], PID_Gyros[P2][YAW], temp1, temp2, PID_ACCs[P2][ROLL], PID_ACCs[P2][PITCH]}; 
+//************************************************************
+// Code
+//************************************************************
 
-	//************************************************************
-	// Main mix loop - sensors, RC inputs and other channels
-	//************************************************************
+// Sum the compiled terms of one channel for one flight profile.
+// The Q12 products are summed in 32 bits and rounded once at the end.
+static int16_t MixChannel(const mix_term_t *term, uint8_t count, const int16_t *source)
+{
+	int32_t solution32 = 0;
+	int32_t value32;
 
-	for (i = 0; i < MIX_OUTPUTS; i++)
+	while (count--)
 	{
-		//************************************************************
-		// Zero each channel value to start
-		//************************************************************
-
-		P1_solution = 0;
-		P2_solution = 0;
+		value32 = (int32_t)source[term->source & MIXTERM_SOURCE] * term->gain;
 
-		//************************************************************
-		// Mix in gyros
-		//************************************************************ 
-
-		// P1 gyros
-		if (transition < 100)
+		if (term->source & MIXTERM_SUB)
 		{
-			switch (Config.Channel[i].P1_Roll_gyro) 
-			{
-				case OFF:
-					break;
-				case ON:
-					if (Config.Channel[i].P1_aileron_volume < 0 )
-					{
-						P1_solution = P1_solution + PID_Gyros[P1][ROLL];		// Reverse if volume negative
-					}
-					else
-					{
-						P1_solution = P1_solution - PID_Gyros[P1][ROLL];
-					}
-					break;
-				case SCALE:
-					P1_solution = P1_solution - scale32(PID_Gyros[P1][ROLL], Config.Channel[i].P1_aileron_volume * 5); 
-					break;
-				default:
-					break;	
-			}
-
-			switch (Config.Channel[i].P1_Pitch_gyro)
-			{
-				case OFF:
-					break;
-				case ON:
-					if (Config.Channel[i].P1_elevator_volume < 0 )
-					{
-						P1_solution = P1_solution - PID_Gyros[P1][PITCH];		// Reverse if volume negative
-					}
-					else
-					{
-						P1_solution = P1_solution + PID_Gyros[P1][PITCH];
-					}
-					break;
-				case SCALE:
-					P1_solution = P1_solution + scale32(PID_Gyros[P1][PITCH], Config.Channel[i].P1_elevator_volume * 5);
-					break;
-				default:
-					break;
-			}
-
-			switch (Config.Channel[i].P1_Yaw_gyro)
-			{
-				case OFF:
-					break;
-				case ON:
-					if (Config.Channel[i].P1_rudder_volume < 0 )
-					{
-						P1_solution = P1_solution - PID_Gyros[P1][YAW];			// Reverse if volume negative
-					}
-					else
-					{
-						P1_solution = P1_solution + PID_Gyros[P1][YAW];
-					}
-					break;
-				case SCALE:
-					P1_solution = P1_solution + scale32(PID_Gyros[P1][YAW], Config.Channel[i].P1_rudder_volume * 5);
-					break;
-				default:
-					break;
-			}
+			solution32 -= value32;
 		}
-
-		// P2 gyros
-		if (transition > 0)
+		else
 		{
-			switch (Config.Channel[i].P2_Roll_gyro)
-			{
-				case OFF:
-					break;
-				case ON:
-					if (Config.Channel[i].P2_aileron_volume < 0 )
-					{
-						P2_solution = P2_solution + PID_Gyros[P2][ROLL];		// Reverse if volume negative
-					}
-					else
-					{
-						P2_solution = P2_solution - PID_Gyros[P2][ROLL];
-					}
-					break;
-				case SCALE:
-					P2_solution = P2_solution - scale32(PID_Gyros[P2][ROLL], Config.Channel[i].P2_aileron_volume * 5);
-					break;
-				default:
-					break;
-			}
-
-			switch (Config.Channel[i].P2_Pitch_gyro)
-			{
-				case OFF:
-					break;
-				case ON:
-					if (Config.Channel[i].P2_elevator_volume < 0 )
-					{
-						P2_solution = P2_solution - PID_Gyros[P2][PITCH];		// Reverse if volume negative
-					}
-					else
-					{
-						P2_solution = P2_solution + PID_Gyros[P2][PITCH];
-					}
-					break;
-				case SCALE:
-					P2_solution = P2_solution + scale32(PID_Gyros[P2][PITCH], Config.Channel[i].P2_elevator_volume * 5);
-					break;
-				default:
-					break;
-			}
-
-			switch (Config.Channel[i].P2_Yaw_gyro)
-			{
-				case OFF:
-					break;
-				case ON:
-					if (Config.Channel[i].P2_rudder_volume < 0 )
-					{
-						P2_solution = P2_solution - PID_Gyros[P2][YAW];			// Reverse if volume negative
-					}
-					else
-					{
-						P2_solution = P2_solution + PID_Gyros[P2][YAW];
-					}
-					break;
-				case SCALE:
-					P2_solution = P2_solution + scale32(PID_Gyros[P2][YAW], Config.Channel[i].P2_rudder_volume * 5);
-					break;
-				default:
-					break;
-			}
+			solution32 += value32;
 		}
 
-		//************************************************************
-		// Mix in accelerometers
-		//************************************************************ 
-		// P1
-		if (transition < 100)
-		{
-			switch (Config.Channel[i].P1_Roll_acc)
-			{
-				case OFF:
-					break;
-				case ON:
-					if (Config.Channel[i].P1_aileron_volume < 0 )
-					{
-						P1_solution = P1_solution + PID_ACCs[P1][ROLL];			// Reverse if volume negative
-					}
-					else
-					{
-						P1_solution = P1_solution - PID_ACCs[P1][ROLL];			// or simply add
-					}
-					break;
-				case SCALE:
-					P1_solution = P1_solution - scale32(PID_ACCs[P1][ROLL], Config.Channel[i].P1_aileron_volume * 5);
-					break;
-				default:
-					break;
-			}			
-
-			switch (Config.Channel[i].P1_Pitch_acc)
-			{
-				case OFF:
-					break;
-				case ON:
-					if (Config.Channel[i].P1_elevator_volume < 0 )
-					{
-						P1_solution = P1_solution - PID_ACCs[P1][PITCH];		// Reverse if volume negative
-					}
-					else
-					{
-						P1_solution = P1_solution + PID_ACCs[P1][PITCH];
-					}
-					break;
-				case SCALE:
-					P1_solution = P1_solution + scale32(PID_ACCs[P1][PITCH], Config.Channel[i].P1_elevator_volume * 5);
-					break;
-				default:
-					break;
-			}
-
-			switch (Config.Channel[i].P1_Z_delta_acc)
-			{
-				case OFF:
-					break;
-				case ON:
-					if (Config.Channel[i].P1_throttle_volume < 0 )
-					{
-						P1_solution = P1_solution + PID_ACCs[P1][YAW];			// Reverse if volume negative
-					}
-					else
-					{
-						P1_solution = P1_solution - PID_ACCs[P1][YAW];
-					}
-					break;
-				case SCALE:
-					P1_solution = P1_solution - scale32(PID_ACCs[P1][YAW], Config.Channel[i].P1_throttle_volume * 5);
-					break;
-				default:
-					break;
-			}
-		}
+		term++;
+	}
 
-		// P2
-		if (transition > 0)
-		{
-			switch (Config.Channel[i].P2_Roll_acc)
-			{
-				case OFF:
-					break;
-				case ON:
-					if (Config.Channel[i].P2_aileron_volume < 0 )
-					{
-						P2_solution = P2_solution + PID_ACCs[P2][ROLL];			// Reverse if volume negative
-					}
-					else
-					{
-						P2_solution = P2_solution - PID_ACCs[P2][ROLL];			// or simply add
-					}
-					break;
-				case SCALE:
-					P2_solution = P2_solution - scale32(PID_ACCs[P2][ROLL], Config.Channel[i].P2_aileron_volume * 5);
-					break;
-				default:
-					break;
-			}
+	return (int16_t)((solution32 + 2048) >> 12);
+}
 
-			switch (Config.Channel[i].P2_Pitch_acc)
-			{
-				case OFF:
-					break;
-				case ON:
-					if (Config.Channel[i].P2_elevator_volume < 0 )
-					{
-
-						P2_solution = P2_solution - PID_ACCs[P2][PITCH];		// Reverse if volume negative
-					}
-					else
-					{
-						P2_solution = P2_solution + PID_ACCs[P2][PITCH];
-					}
-					break;
-				case SCALE:
-					P2_solution = P2_solution + scale32(PID_ACCs[P2][PITCH], Config.Channel[i].P2_elevator_volume * 5);
-					break;
-				default:
-					break;
-			}
+// Recalculate the crossfade weights and throttle curve volumes for the current transition value
+static void UpdateTransitionGains(void)
+{
+	uint8_t i;
+	int16_t temp2, temp3;
 
-			switch (Config.Channel[i].P2_Z_delta_acc)
-			{
-				case OFF:
-					break;
-				case ON:
-					if (Config.Channel[i].P2_throttle_volume < 0 )
-					{
-						P2_solution = P2_solution + PID_ACCs[P2][YAW];			// Reverse if volume negative
-					}
-					else
-					{
-						P2_solution = P2_solution - PID_ACCs[P2][YAW];
-					}
-					break;
-				case SCALE:
-					P2_solution = P2_solution - scale32(PID_ACCs[P2][YAW], Config.Channel[i].P2_throttle_volume * 5);
-					break;
-				default:
-					break;
-			}
-		}
+	MixTransition = transition;
 
-		//************************************************************
-		// Process mixers
-		//************************************************************ 
+	TransitionGain[P2] = PCT_TO_Q15(transition);
+	TransitionGain[P1] = Q15_100PCT - TransitionGain[P2];
 
-		// Mix in other outputs here (P1)
-		if (transition < 100)
+	for (i = 0; i < MIX_OUTPUTS; i++)
+	{
+		// Only process if there is a curve
+		if (Config.Channel[i].P1_throttle_volume != Config.Channel[i].P2_throttle_volume)
 		{
-			// Mix in dedicated RC sources - aileron, elevator and rudder
-			if (Config.Channel[i].P1_aileron_volume != 0) 					// Mix in dedicated aileron
-			{
-				temp2 = scale32(RCinputs[AILERON], Config.Channel[i].P1_aileron_volume);
-				P1_solution = P1_solution + temp2;
-			}
-			if (Config.Channel[i].P1_elevator_volume != 0) 					// Mix in dedicated elevator
-			{
-				temp2 = scale32(RCinputs[ELEVATOR], Config.Channel[i].P1_elevator_volume);
-				P1_solution = P1_solution + temp2;
-			}
-			if (Config.Channel[i].P1_rudder_volume != 0) 					// Mix in dedicated rudder
+			// Set start (P1) point
+			temp2 = Config.Channel[i].P1_throttle_volume; // Promote to 16 bits
+			temp2 = temp2 << 7;
+
+			// Linear vs. Sinusoidal calculation
+			if (Config.Channel[i].Throttle_curve == LINEAR)
 			{
-				temp2 = scale32(RCinputs[RUDDER], Config.Channel[i].P1_rudder_volume);
-				P1_solution = P1_solution + temp2;
+				// Multiply [transition] steps (0 to 100)
+				temp3 = transition;
 			}
 
-			// Other sources
-			if ((Config.Channel[i].P1_source_a_volume != 0) && (Config.Channel[i].P1_source_a != NOMIX)) // Mix in first extra source
+			// SINE
+			else if (Config.Channel[i].Throttle_curve == SINE)
 			{
-				// Is the source a sensor?
-				if (Config.Channel[i].P1_source_a > (MAX_RC_CHANNELS - 1))
-				{
-					temp2 = SensorDataP1[Config.Channel[i].P1_source_a - EXT_SOURCE];
+				// Choose between SINE and COSINE
+				// If P2 less than P1, COSINE (reverse SINE) is the one we want
+				if (ThrottleStep[i] < 0)
+				{ 
+					// Multiply SIN[100 - transition] steps (0 to 100)
+					temp3 = 100 - (int8_t)pgm_read_byte(&SIN[100 - (int8_t)transition]);
 				}
-				// Is the source an RC input?
+				// If P2 greater than P1, SINE is the one we want
 				else
 				{
-					// Yes, calculate RC channel number from source number and return RC value
-					temp2 = RCinputs[Config.Channel[i].P1_source_a];
+					// Multiply SIN[transition] steps (0 to 100)
+					temp3 = (int8_t)pgm_read_byte(&SIN[(int8_t)transition]);
 				}
-
-				temp2 = scale32(temp2, Config.Channel[i].P1_source_a_volume);
-				P1_solution = P1_solution + temp2;
 			}
-			if ((Config.Channel[i].P1_source_b_volume != 0) && (Config.Channel[i].P1_source_b != NOMIX)) // Mix in second extra source
+			// SQRT SINE
+			else
 			{
-				// Is the source a sensor?
-				if (Config.Channel[i].P1_source_b > (MAX_RC_CHANNELS - 1))
-				{
-					temp2 = SensorDataP1[Config.Channel[i].P1_source_b - EXT_SOURCE];
+				// Choose between SQRT SINE and SQRT COSINE
+				// If P2 less than P1, COSINE (reverse SINE) is the one we want
+				if (ThrottleStep[i] < 0)
+				{ 
+					// Multiply SQRTSIN[100 - transition] steps (0 to 100)
+					temp3 = 100 - (int8_t)pgm_read_byte(&SQRTSIN[100 - (int8_t)transition]);
 				}
-				// Is the source an RC input?
+				// If P2 greater than P1, SINE is the one we want
 				else
 				{
-					temp2 = RCinputs[Config.Channel[i].P1_source_b];
+					// Multiply SQRTSIN[transition] steps (0 to 100)
+					temp3 = (int8_t)pgm_read_byte(&SQRTSIN[(int8_t)transition]);
 				}
-
-				temp2 = scale32(temp2, Config.Channel[i].P1_source_b_volume);
-				P1_solution = P1_solution + temp2;
 			}
+
+			// Get curve% (temp3) of difference in volumes (ThrottleStep)
+			// ThrottleStep is already in 100ths of the difference * 128
+			// temp2 is the start volume * 128
+			temp3 = temp2 + (ThrottleStep[i] * temp3);
+
+			// Round, then rescale to normal value
+			temp3 = temp3 + 64;
+			temp3 = temp3 >> 7;
+		}
+			
+		// No curve
+		else
+		{
+			// Just use the value of P1 volume as there is no curve
+			temp3 = Config.Channel[i].P1_throttle_volume; // Promote to 16 bits
 		}
 
-		// Mix in other outputs here (P2)
-		if (transition > 0)	
+		ThrottleGain[i] = PCT_TO_Q12(temp3);
+	}
+}
+
+void ProcessMixer(void)
+{
+	uint8_t i = 0;
+	uint8_t j = 0;
+	int16_t P1_solution = 0;
+	int16_t P2_solution = 0;
+
+	int16_t temp1 = 0;
+	int16_t temp2 = 0;
+	int16_t	temp3 = 0;
+	int32_t	temp32 = 0;
+	int8_t	itemp8 = 0;
+	int16_t	SourceData[FLIGHT_MODES][MIX_SOURCES];
+
+	// Copy the RC and sensor data to an array for easy indexing - acc data is from accSmooth, increased to reasonable rates
+	temp1 = (int16_t)accSmooth[ROLL] << 3;
+	temp2 = (int16_t)accSmooth[PITCH] << 3;
+
+	for (j = P1; j <= P2; j++)
+	{
+		for (i = 0; i < MAX_RC_CHANNELS; i++)
 		{
-			// Mix in dedicated RC sources - aileron, elevator and rudder
-			if (Config.Channel[i].P2_aileron_volume != 0) 					// Mix in dedicated aileron
-			{
-				temp2 = scale32(RCinputs[AILERON], Config.Channel[i].P2_aileron_volume);
-				P2_solution = P2_solution + temp2;
-			}
-			if (Config.Channel[i].P2_elevator_volume != 0) 					// Mix in dedicated elevator
-			{
-				temp2 = scale32(RCinputs[ELEVATOR], Config.Channel[i].P2_elevator_volume);
-				P2_solution = P2_solution + temp2;
-			}
-			if (Config.Channel[i].P2_rudder_volume != 0) 					// Mix in dedicated rudder
-			{
-				temp2 = scale32(RCinputs[RUDDER], Config.Channel[i].P2_rudder_volume);
-				P2_solution = P2_solution + temp2;
-			}
+			SourceData[j][i] = RCinputs[i];
+		}
 
-			// Other sources
-			if ((Config.Channel[i].P2_source_a_volume != 0) && (Config.Channel[i].P2_source_a != NOMIX)) // Mix in first extra source
-			{
-				// Is the source a sensor?
-				if (Config.Channel[i].P2_source_a > (MAX_RC_CHANNELS - 1))
-				{
-					temp2 = SensorDataP2[Config.Channel[i].P2_source_a - EXT_SOURCE];
-				}
-				// Is the source an RC input?
-				else 
-				{
-					temp2 = RCinputs[Config.Channel[i].P2_source_a];
-				}
+		SourceData[j][EXT_SOURCE] = PID_Gyros[j][ROLL];
+		SourceData[j][EXT_SOURCE + 1] = PID_Gyros[j][PITCH];
+		SourceData[j][EXT_SOURCE + 2] = PID_Gyros[j][YAW];
+		SourceData[j][EXT_SOURCE + 3] = temp1;
+		SourceData[j][EXT_SOURCE + 4] = temp2;
+		SourceData[j][EXT_SOURCE + 5] = PID_ACCs[j][ROLL];
+		SourceData[j][EXT_SOURCE + 6] = PID_ACCs[j][PITCH];
+		SourceData[j][MIX_ZACC] = PID_ACCs[j][YAW];
+	}
 
-				temp2 = scale32(temp2, Config.Channel[i].P2_source_a_volume);
-				P2_solution = P2_solution + temp2;
-			}
-			if ((Config.Channel[i].P2_source_b_volume != 0) && (Config.Channel[i].P2_source_b != NOMIX)) // Mix in second extra source
-			{
-				// Is the source a sensor?
-				if (Config.Channel[i].P2_source_b > (MAX_RC_CHANNELS - 1))
-				{
-					temp2 = SensorDataP2[Config.Channel[i].P2_source_b - EXT_SOURCE];
-				}
-				// Is the source an RC input?
-				else
-				{
-					temp2 = RCinputs[Config.Channel[i].P2_source_b];
-				}
+	//************************************************************
+	// Main mix loop - sensors, RC inputs and other channels
+	// Uses the term lists built by CompileMixer()
+	//************************************************************
 
-				temp2 = scale32(temp2, Config.Channel[i].P2_source_b_volume);
-				P2_solution = P2_solution + temp2;
-			}
+	for (i = 0; i < MIX_OUTPUTS; i++)
+	{
+		P1_solution = 0;
+		P2_solution = 0;
+
+		if (transition < 100)
+		{
+			P1_solution = MixChannel(MixTerms[P1][i], MixTermCount[P1][i], SourceData[P1]);
+		}
+
+		if (transition > 0)
+		{
+			P2_solution = MixChannel(MixTerms[P2][i], MixTermCount[P2][i], SourceData[P2]);
 		}
 			
 		// Save solution for this channel. Note that this contains cross-mixed data from the *last* cycle
@@ -521,134 +291,53 @@ void ProcessMixer(void)
 		transition = transition_counter;
 	}
 
-	// Recalculate P1 values based on transition stage
+	// Refresh the transition-dependent gains only when needed
+	if (transition != MixTransition)
+	{
+		UpdateTransitionGains();
+	}
+
+	// Recalculate P1 values based on transition stage, then add the throttle.
+	// Both are summed in Q15 in 32 bits and rounded once.
 	for (i = 0; i < MIX_OUTPUTS; i++)
 	{
 		// Speed up the easy ones :)
 		if (transition == 0)
 		{
-			temp1 = Config.Channel[i].P1_value;
+			temp32 = (int32_t)Config.Channel[i].P1_value * Q15_100PCT;
 		}
 		else if (transition >= 100)
 		{
-			temp1 = Config.Channel[i].P2_value;
+			temp32 = (int32_t)Config.Channel[i].P2_value * Q15_100PCT;
 		}
 		else
 		{
-			// Get source channel value
-			temp1 = Config.Channel[i].P1_value;
-			temp1 = scale32(temp1, (100 - transition));
-
-			// Get destination channel value
-			temp2 = Config.Channel[i].P2_value;
-			temp2 = scale32(temp2, transition);
-
-			// Sum the mixers
-			temp1 = temp1 + temp2;
+			// Sum the source and destination channel values at their crossfade weights
+			temp32 = ((int32_t)Config.Channel[i].P1_value * (int32_t)TransitionGain[P1]) +
+					 ((int32_t)Config.Channel[i].P2_value * (int32_t)TransitionGain[P2]);
 		}
-		// Save transitioned solution into P1
-		Config.Channel[i].P1_value = temp1;
-	}  
 
-	//************************************************************
-	// Groovy throttle curve handling. Must be after the transition.
-	// Uses the transition value, but is not part of the transition
-	// mixer. Linear or Sine curve. Reverse Sine done automatically
-	//************************************************************ 
+		//************************************************************
+		// Groovy throttle curve handling. Must be after the transition.
+		// Uses the transition value, but is not part of the transition
+		// mixer. Linear or Sine curve. Reverse Sine done automatically
+		//************************************************************ 
 
-	for (i = 0; i < MIX_OUTPUTS; i++)
-	{
 		// Ignore if both throttle volumes are 0% (no throttle)
 		if 	(!((Config.Channel[i].P1_throttle_volume == 0) && 
 			(Config.Channel[i].P2_throttle_volume == 0)))
 		{
-			// Only process if there is a curve
-			if (Config.Channel[i].P1_throttle_volume != Config.Channel[i].P2_throttle_volume)
-			{
-				// Calculate step difference in 1/100ths and round
-				temp1 = (Config.Channel[i].P2_throttle_volume - Config.Channel[i].P1_throttle_volume);
-				temp1 = temp1 << 7; 						// Multiply by 128 so divide gives reasonable step values
-				Step1 = temp1 / 100;	
-
-				// Set start (P1) point
-				temp2 = Config.Channel[i].P1_throttle_volume; // Promote to 16 bits
-				temp2 = temp2 << 7;
-
-				// Linear vs. Sinusoidal calculation
-				if (Config.Channel[i].Throttle_curve == LINEAR)
-				{
-					// Multiply [transition] steps (0 to 100)
-					temp3 = temp2 + (Step1 * transition);
-				}
-
-				// SINE
-				else if (Config.Channel[i].Throttle_curve == SINE)
-				{
-					// Choose between SINE and COSINE
-					// If P2 less than P1, COSINE (reverse SINE) is the one we want
-					if (Step1 < 0)
-					{ 
-						// Multiply SIN[100 - transition] steps (0 to 100)
-						temp3 = 100 - (int8_t)pgm_read_byte(&SIN[100 - (int8_t)transition]);
-					}
-					// If P2 greater than P1, SINE is the one we want
-					else
-					{
-						// Multiply SIN[transition] steps (0 to 100)
-						temp3 = (int8_t)pgm_read_byte(&SIN[(int8_t)transition]);
-					}
-
-					// Get SINE% (temp2) of difference in volumes (Step1)
-					// Step1 is already in 100ths of the difference * 128
-					// temp1 is the start volume * 128
-					temp3 = temp2 + (Step1 * temp3);
-				}
-				// SQRT SINE
-				else
-				{
-					// Choose between SQRT SINE and SQRT COSINE
-					// If P2 less than P1, COSINE (reverse SINE) is the one we want
-					if (Step1 < 0)
-					{ 
-						// Multiply SQRTSIN[100 - transition] steps (0 to 100)
-						temp3 = 100 - (int8_t)pgm_read_byte(&SQRTSIN[100 - (int8_t)transition]);
-					}
-					// If P2 greater than P1, SINE is the one we want
-					else
-					{
-						// Multiply SQRTSIN[transition] steps (0 to 100)
-						temp3 = (int8_t)pgm_read_byte(&SQRTSIN[(int8_t)transition]);
-					}
-
-					// Get SINE% (temp2) of difference in volumes (Step1)
-					// Step1 is already in 100ths of the difference * 128
-					// temp1 is the start volume * 128
-					temp3 = temp2 + (Step1 * temp3);
-				}
-
-				// Round, then rescale to normal value
-				temp3 = temp3 + 64;
-				temp3 = temp3 >> 7;
-			}
-			
-			// No curve
-			else
-			{
-				// Just use the value of P1 volume as there is no curve
-				temp3 = Config.Channel[i].P1_throttle_volume; // Promote to 16 bits
-			}
+			// Calculate actual throttle value to the curve, Q12 to Q15
+			temp32 += ((int32_t)MonopolarThrottle * ThrottleGain[i]) << 3;
 
-			// Calculate actual throttle value to the curve
-			temp3 = scale32(MonopolarThrottle, temp3);
+			// Save transitioned solution and throttle into P1
+			temp3 = (int16_t)((temp32 + 16384) >> 15);
 
 			// At this point, the throttle values are 0 to 2500 (+/-150%)
 			// Re-scale throttle values back to neutral-centered system values (+/-1250) 
 			// and set the minimum throttle point to 1.1ms.
 			// A THROTTLEMIN value of 1000 will result in 2750, or 1.1ms
-			temp3 = temp3 - THROTTLEMIN;
-
-			// Add offset to channel value
-			Config.Channel[i].P1_value += temp3;
+			Config.Channel[i].P1_value = temp3 - THROTTLEMIN;
 
 		} // No throttle
 		
@@ -657,6 +346,12 @@ void ProcessMixer(void)
 		{
 			Config.Channel[i].P1_value = -THROTTLEOFFSET; // 3750-1250 = 2500 = 1.0ms
 		}
+
+		// Save transitioned solution into P1
+		else
+		{
+			Config.Channel[i].P1_value = (int16_t)((temp32 + 16384) >> 15);
+		}
 	}
 
 	//************************************************************
@@ -666,55 +361,23 @@ void ProcessMixer(void)
 
 	for (i = 0; i < MIX_OUTPUTS; i++)
 	{
-		// Simplify if all are the same
-		if (!((Config.Channel[i].P1_offset == Config.Channel[i].P1n_offset) &&
-		 	 (Config.Channel[i].P2_offset == Config.Channel[i].P1n_offset)))
-		{
-			// Work out distance to cover over stage 1 (P1 to P1.n)
-			temp1 = Config.Channel[i].P1n_offset - Config.Channel[i].P1_offset;
-			temp1 = temp1 << 7; // Multiply by 128 so divide gives reasonable step values
-
-			// Divide distance into steps
-			temp2 = Config.Channel[i].P1n_position; 
-			Step1 = ((temp1 + (temp2 >> 1)) / temp2) ; // Divide and round result
-		
-			// Work out distance to cover over stage 2 (P1.n to P2)
-			temp2 = Config.Channel[i].P2_offset - Config.Channel[i].P1n_offset;
-			temp2 = temp2 << 7;
+		// Walk the compiled curve to the current transition point
+		temp3 = OffsetCurve[i].start;
 
-			// Divide distance into steps
-			temp1 = (100 - Config.Channel[i].P1n_position); 
-			Step2 = ((temp2 + (temp1 >> 1)) / temp1) ; // Divide and round result	
-
-			// Set start (P1) point
-			temp3 = Config.Channel[i].P1_offset; // Promote to 16bits
-			temp3 = temp3 << 7;
-
-			// Count up transition steps of the appropriate step size
-			for (j = 0; j < transition; j++)
-			{
-				// If in stage 1 use Step1 size
-				if (j < Config.Channel[i].P1n_position)
-				{
-					temp3 += Step1;
-				}
-				// If in stage 2 use Step2 size
-				else
-				{
-					temp3 += Step2;
-				}
-			}
-
-			// Reformat into a system-compatible value
-			itemp8 = (int8_t)((temp3 + 64) >> 7);							// Round then divide by 128
-			P1_solution = scale_percent_nooffset(itemp8);	
-
-		} // No curve, so just use one point for offset
+		if (transition <= OffsetCurve[i].knee)
+		{
+			temp3 += OffsetCurve[i].step1 * (int16_t)transition;
+		}
 		else
 		{
-			P1_solution = scale_percent_nooffset(Config.Channel[i].P1_offset);
+			temp3 += (OffsetCurve[i].step1 * (int16_t)OffsetCurve[i].knee) + 
+					 (OffsetCurve[i].step2 * (int16_t)(transition - OffsetCurve[i].knee));
 		}
 
+		// Reformat into a system-compatible value
+		itemp8 = (int8_t)((temp3 + 64) >> 7);							// Round then divide by 128
+		P1_solution = scale_percent_nooffset(itemp8);	
+
 		// Add offset to channel value
 		Config.Channel[i].P1_value += P1_solution;
 	}
@@ -845,6 +508,143 @@ void UpdateLimits(void)
 		Config.Rolltrim[i] = Config.FlightMode[i].AccRollZeroTrim * 10;
 		Config.Pitchtrim[i] = Config.FlightMode[i].AccPitchZeroTrim * 10;
 	}
+
+	// Rebuild the PID gains and mixer term lists
+	CompilePID();
+	CompileMixer();
+}
+
+// Add one gyro or acc term. Roll and Z terms are subtracted (reversed) by default.
+static void AddSensorTerm(mix_term_t *term, uint8_t *count, int8_t setting, int8_t volume, uint8_t source, bool subtract)
+{
+	term += *count;
+
+	switch (setting)
+	{
+		case ON:
+			// Full source, reversed if volume negative
+			term->source = source;
+			term->gain = ((volume < 0) != subtract) ? -Q12_100PCT : Q12_100PCT;
+			(*count)++;
+			break;
+		case SCALE:
+			// Source scaled by volume * 5
+			if (volume != 0)
+			{
+				term->source = source;
+				if (subtract)
+				{
+					term->source |= MIXTERM_SUB;
+				}
+				term->gain = PCT_TO_Q12((int16_t)volume * 5);
+				(*count)++;
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+// Add one RC or other source term
+static void AddSourceTerm(mix_term_t *term, uint8_t *count, int8_t volume, uint8_t source)
+{
+	if ((volume != 0) && (source != NOMIX))
+	{
+		term += *count;
+		term->source = source;
+		term->gain = PCT_TO_Q12(volume);
+		(*count)++;
+	}
+}
+
+// Convert the mixer settings in Config.Channel[] into a list of active terms
+// per channel and flight profile, so that ProcessMixer() only visits sources that are in use.
+// Also precalculates the 3-point offset and throttle curves.
+// Must be called whenever Config.Channel[] changes.
+void CompileMixer(void)
+{
+	uint8_t i, j;
+	uint8_t *count;
+	mix_term_t *term;
+	channel_t *ch;
+	int8_t	*set;
+	int16_t	temp1, temp2;
+
+	for (j = P1; j <= P2; j++)
+	{
+		for (i = 0; i < MIX_OUTPUTS; i++)
+		{
+			ch = &Config.Channel[i];
+			term = MixTerms[j][i];
+			count = &MixTermCount[j][i];
+			*count = 0;
+
+			// P2 settings follow their P1 equivalent, except for the other sources
+			// Gyros
+			AddSensorTerm(term, count, (&ch->P1_Roll_gyro)[j], (&ch->P1_aileron_volume)[j], EXT_SOURCE, true);
+			AddSensorTerm(term, count, (&ch->P1_Pitch_gyro)[j], (&ch->P1_elevator_volume)[j], EXT_SOURCE + 1, false);
+			AddSensorTerm(term, count, (&ch->P1_Yaw_gyro)[j], (&ch->P1_rudder_volume)[j], EXT_SOURCE + 2, false);
+
+			// Accelerometers
+			AddSensorTerm(term, count, (&ch->P1_Roll_acc)[j], (&ch->P1_aileron_volume)[j], EXT_SOURCE + 5, true);
+			AddSensorTerm(term, count, (&ch->P1_Pitch_acc)[j], (&ch->P1_elevator_volume)[j], EXT_SOURCE + 6, false);
+			AddSensorTerm(term, count, (&ch->P1_Z_delta_acc)[j], (&ch->P1_throttle_volume)[j], MIX_ZACC, true);
+
+			// Dedicated RC sources - aileron, elevator and rudder
+			AddSourceTerm(term, count, (&ch->P1_aileron_volume)[j], AILERON);
+			AddSourceTerm(term, count, (&ch->P1_elevator_volume)[j], ELEVATOR);
+			AddSourceTerm(term, count, (&ch->P1_rudder_volume)[j], RUDDER);
+
+			// Other sources. Pairs of source and volume, P1 then P2
+			set = &ch->P1_source_a + (j << 1);
+			AddSourceTerm(term, count, set[1], set[0]);
+			set = &ch->P1_source_b + (j << 1);
+			AddSourceTerm(term, count, set[1], set[0]);
+		}
+	}
+
+	for (i = 0; i < MIX_OUTPUTS; i++)
+	{
+		ch = &Config.Channel[i];
+
+		// Set start (P1) point
+		temp1 = ch->P1_offset; // Promote to 16bits
+		OffsetCurve[i].start = temp1 << 7;
+		OffsetCurve[i].knee = ch->P1n_position;
+
+		// Simplify if all are the same
+		if ((ch->P1_offset == ch->P1n_offset) && (ch->P2_offset == ch->P1n_offset))
+		{
+			OffsetCurve[i].step1 = 0;
+			OffsetCurve[i].step2 = 0;
+		}
+		else
+		{
+			// Work out distance to cover over stage 1 (P1 to P1.n)
+			temp1 = ch->P1n_offset - ch->P1_offset;
+			temp1 = temp1 << 7; // Multiply by 128 so divide gives reasonable step values
+
+			// Divide distance into steps
+			temp2 = ch->P1n_position; 
+			OffsetCurve[i].step1 = ((temp1 + (temp2 >> 1)) / temp2) ; // Divide and round result
+		
+			// Work out distance to cover over stage 2 (P1.n to P2)
+			temp2 = ch->P2_offset - ch->P1n_offset;
+			temp2 = temp2 << 7;
+
+			// Divide distance into steps
+			temp1 = (100 - ch->P1n_position); 
+			OffsetCurve[i].step2 = ((temp2 + (temp1 >> 1)) / temp1) ; // Divide and round result	
+		}
+
+		// Calculate throttle curve step difference in 1/100ths and round
+		temp1 = (ch->P2_throttle_volume - ch->P1_throttle_volume);
+		temp1 = temp1 << 7; 						// Multiply by 128 so divide gives reasonable step values
+		ThrottleStep[i] = temp1 / 100;
+	}
+
+	// Force the transition gains to be recalculated
+	MixTransition = -1;
 }
 
 // Update servos from the mixer Config.Channel[i].P1_value data, add offsets and enforce travel limits
@@ -12,6 +12,7 @@
 #include <stdbool.h>
 #include <util/delay.h>
 #include <stdlib.h>
+#include <string.h>
 #include "io_cfg.h"
 #include "gyros.h"
 #include "main.h"
@@ -21,13 +22,20 @@
 #include "rc.h"
 #include "mixer.h"
 #include "isr.h"
+#include "filters.h"
 
 //************************************************************
 // Defines
 //************************************************************
 
 #define PID_SCALE 6					// Empirical amount to reduce the PID values by to make them most useful
-#define STANDARDLOOP 3571.0			// T1 counts of 700Hz cycle time (2500000/700)
+#define STANDARDLOOP 3571			// T1 counts of 700Hz cycle time (2500000/700)
+#define LOOP_RECIP 18793			// 2^26 / STANDARDLOOP, so (period * LOOP_RECIP) >> 14 is period/STANDARDLOOP in Q12
+#define LOOP_PERIOD_MAX ((16 * STANDARDLOOP) - 1) // Longest period that keeps the Q12 factor within 16 bits
+#define LOOP_FACTOR_ONE 4096		// Q12 factor of a standard loop
+#define DECIMATE_RING 16			// Sensor history per axis. Must be a power of two
+#define DECIMATE_MASK (DECIMATE_RING - 1)
+#define DECIMATE_MAX 8				// Largest averaging window. Must leave one older sample in the ring
 
 //************************************************************
 // Notes
@@ -56,6 +64,7 @@
 
 void Sensor_PID(uint32_t period);
 void Calculate_PID(void);
+void CompilePID(void);
 
 //************************************************************
 // Code
@@ -67,27 +76,52 @@ int16_t PID_ACCs[FLIGHT_MODES][NUMBEROFAXIS];
 int32_t	IntegralGyro[FLIGHT_MODES][NUMBEROFAXIS];	// PID I-terms (gyro) for each axis
 int32_t	GyroDTerm[NUMBEROFAXIS];					// Gyro D-terms for each axis
 
-int32_t PID_AvgAccVert = 0;							// Averaged Acc Z
-float 	gyroSmooth[NUMBEROFAXIS];					// Filtered gyro data
-int32_t PID_AvgGyro[NUMBEROFAXIS];					// Averaged gyro data
-int32_t PID_OldAvgGyro[NUMBEROFAXIS];				// Old averaged gyro data - debug
-int32_t	PID_AvgGyroDTerm[NUMBEROFAXIS];				// Averaged gyro D-terms for each axis
+// Gains compiled from Config.FlightMode[] by CompilePID()
+flight_profile_t FlightProfile;
 
-int16_t OldgyroADC[NUMBEROFAXIS];					// Holds previous Gyro values
+// Decimation between the sensor loop and the PID output rate
+int16_t GyroRing[DECIMATE_RING][NUMBEROFAXIS];		// Recent gyro readings, newest at RingHead - 1
+int16_t AccVertRing[DECIMATE_RING];					// Recent accVert readings
+uint8_t RingHead = 0;								// Next slot to write
+uint8_t PID_Samples = 0;							// Samples since the last Calculate_PID(), up to DECIMATE_MAX
+#ifndef D_METHOD
+int16_t PID_OldAvgGyro[NUMBEROFAXIS];				// Old averaged gyro data
+#endif
+
+// Averaging window (as a shift) for each sample count. The largest power of two not above the count.
+const uint8_t Window_shift[DECIMATE_MAX + 1] PROGMEM = {0, 0, 1, 1, 2, 2, 2, 2, 3};
+
+// Divide by 2^shift, truncating toward zero as a divide would
+static inline int16_t window_average(int32_t sum, uint8_t shift)
+{
+	if (sum < 0)
+	{
+		sum += (1 << shift) - 1;
+	}
+	
+	return (int16_t)(sum >> shift);
+}
+
+// Work out which profiles ProcessMixer() will use at the current transition value.
+// Outside of a transition only one profile reaches the outputs, so the other is skipped.
+// FC_main.c zeros the I-terms of the unused profile, and as they are no longer
+// integrated here they stay at zero, ready for a bump-less transition.
+static inline void active_profiles(int8_t *first, int8_t *last)
+{
+	*first = (transition >= 100) ? P2 : P1;
+	*last = (transition <= 0) ? P1 : P2;
+}
 	
 // Run each loop to average gyro data and also accVert data
 void Sensor_PID(uint32_t period)
 {
-	float tempf1 = 0;
-	float tempf2 = 0;
-	float factor = 0;						// Interval in seconds since the last loop
-	float gyroADCf = 0;
+	uint16_t factor = 0;					// Loop period compared to the standard loop in Q12
 	int8_t i = 0;
 	int8_t	axis = 0;	
-	int16_t	stick_P1 = 0;
-	int16_t	stick_P2 = 0;
-	int32_t P1_temp = 0;
-	int32_t P2_temp = 0;
+	int8_t	first = P1;
+	int8_t	last = P2;
+	int16_t	stick = 0;
+	int16_t temp = 0;
 	
 	// Cross-reference table for actual RCinput elements
 	// Note that axes are reversed here with respect to their gyros
@@ -98,165 +132,137 @@ void Sensor_PID(uint32_t period)
 	// As described above, pitch and yaw are already opposed, but roll needs to be reversed.
 
 	int16_t	RCinputsAxis[NUMBEROFAXIS] = {-RCinputs[AILERON], RCinputs[ELEVATOR], RCinputs[RUDDER]};
-	
-	int8_t Stick_rates[FLIGHT_MODES][NUMBEROFAXIS] =
-	{
-		{Config.FlightMode[P1].Roll_Rate, Config.FlightMode[P1].Pitch_Rate, Config.FlightMode[P1].Yaw_Rate},
-		{Config.FlightMode[P2].Roll_Rate, Config.FlightMode[P2].Pitch_Rate, Config.FlightMode[P2].Yaw_Rate}
-	};
 
-	for (axis = 0; axis <= YAW; axis ++)
+	//************************************************************
+	// Work out the multiplication factor compared to the standard
+	// loop time. Loops longer than 16 standard loops (e.g. the 
+	// first back from the menus) count as 16.
+	//************************************************************
+
+	if (period > LOOP_PERIOD_MAX)
 	{
-		//************************************************************
-		// Increment and limit gyro I-terms, handle heading hold nicely
-		//************************************************************
-		
-		// Work out stick rate divider. 0 is slowest, 4 is fastest.
-		// /64 (15.25), /32 (30.5), /16 (61*), /8 (122), /4 (244)
-		stick_P1 = RCinputsAxis[axis] >> (4 - (Stick_rates[P1][axis] - 2));
-		stick_P2 = RCinputsAxis[axis] >> (4 - (Stick_rates[P2][axis] - 2));
+		period = LOOP_PERIOD_MAX;
+	}
 
-		//************************************************************
-		// Gyro LPF
-		//************************************************************	
+	factor = (uint16_t)((period * LOOP_RECIP) >> 14);
 
-		// Lookup LPF value
-		// Note: Two sets of values for normal and high-speed mode
-		if (Config.Servo_rate != FAST)
-		{
-			memcpy_P(&tempf1, &LPF_lookup[Config.Gyro_LPF], sizeof(float));
-		}
-		else
-		{
-			memcpy_P(&tempf1, &LPF_lookup_HS[Config.Gyro_LPF], sizeof(float));
-		}		
-			
-		gyroADCf = gyroADC[axis]; // Promote gyro signal to suit
+	//************************************************************
+	// Keep the filters matched to the loop rate, then run the
+	// gyro LPF and notches
+	//************************************************************
 
-		if (Config.Gyro_LPF != NOFILTER)
-		{
-			// Gyro LPF
-			gyroSmooth[axis] = ((gyroSmooth[axis] * (tempf1 - 1.0f)) + gyroADCf) / tempf1;
-		}
-		else
-		{
-			// Use raw gyroADC[axis] as source for gyro values when filter off
-			gyroSmooth[axis] = gyroADCf;
-		}		
-		
-		// Demote back to int16_t
-		gyroADC[axis] = (int16_t)gyroSmooth[axis];	
+	filter_period(period);
+	filter_gyros();
 
+	active_profiles(&first, &last);
+
+	for (axis = 0; axis <= YAW; axis ++)
+	{
 		//************************************************************
-		// Magically correlate the I-term value with the loop rate.
-		// This keeps the I-term and stick input constant over varying 
-		// loop rates 
+		// Increment and limit gyro I-terms, handle heading hold nicely
 		//************************************************************
-		P1_temp = gyroADC[axis] + stick_P1;
-		P2_temp = gyroADC[axis] + stick_P2;
 		
-		// Work out multiplication factor compared to standard loop time
-		tempf2 = period;							// Promote int32_t to float
-		factor = period/STANDARDLOOP;
-		
-		// Adjust gyro and stick values based on factor		
-		tempf2 = P1_temp;							// Promote int32_t to float
-		tempf2 = tempf2 * factor;
-		P1_temp = (int32_t)tempf2;					// Demote to int32_t
-		
-		tempf2 = P2_temp;
-		tempf2 = tempf2 * factor;
-		P2_temp = (int32_t)tempf2;
+		for (i = first; i <= last; i++)
+		{
+			// Apply stick rate divider. See CompilePID().
+			stick = RCinputsAxis[axis] >> FlightProfile.Stick_shift[i][axis];
+
+			//************************************************************
+			// Magically correlate the I-term value with the loop rate.
+			// This keeps the I-term and stick input constant over varying 
+			// loop rates 
+			//************************************************************
+			temp = gyroADC[axis] + stick;
 		
-		// Calculate I-term from gyro and stick data 
-		// These may look similar, but they are constrained quite differently.
-		IntegralGyro[P1][axis] += P1_temp;
-		IntegralGyro[P2][axis] += P2_temp;
+			// Calculate I-term from gyro and stick data, adjusted by factor.
+			// Both are 16-bit, so this is a 16x16 multiply per profile, and the
+			// divide truncates toward zero as the old float-to-integer cast did.
+			IntegralGyro[i][axis] += ((int32_t)temp * factor) / LOOP_FACTOR_ONE;
 
-		//************************************************************
-		// Limit the I-terms to the user-set limits
-		//************************************************************
-		for (i = P1; i <= P2; i++)
-		{
-			if (IntegralGyro[i][axis] > Config.Raw_I_Constrain[i][axis])
+			// Limit the I-terms to the user-set limits
+			if (IntegralGyro[i][axis] > FlightProfile.I_constrain[i][axis])
 			{
-				IntegralGyro[i][axis] = Config.Raw_I_Constrain[i][axis];
+				IntegralGyro[i][axis] = FlightProfile.I_constrain[i][axis];
 			}
 			
-			if (IntegralGyro[i][axis] < -Config.Raw_I_Constrain[i][axis])
+			if (IntegralGyro[i][axis] < -FlightProfile.I_constrain[i][axis])
 			{
-				IntegralGyro[i][axis] = -Config.Raw_I_Constrain[i][axis];
+				IntegralGyro[i][axis] = -FlightProfile.I_constrain[i][axis];
 			}
 		}
 
 		//************************************************************
-		// Sum gyro readings for P-terms for later averaging
+		// Store gyro readings for the P and D-terms for later averaging
 		//************************************************************
 
-		PID_AvgGyro[axis] += gyroADC[axis];
-				
-		//************************************************************
-		// Apply a D-term to each axis (use raw gyro as error)
-		//************************************************************		
-		
-		// Debug use 1/factor to normalise the D-term with the loop rate 
-		PID_AvgGyroDTerm[axis] += (gyroADC[axis] - OldgyroADC[axis]);
-		OldgyroADC[axis] = gyroADC[axis];
+		GyroRing[RingHead][axis] = gyroADC[axis];
 		
 	} // for (axis = 0; axis <= YAW; axis ++)
 	
-	// Average accVert prior to Calculate_PID()
-	PID_AvgAccVert += accVert;
+	// Store accVert for averaging in Calculate_PID()
+	AccVertRing[RingHead] = accVert;
+	RingHead = (RingHead + 1) & DECIMATE_MASK;
+	
+	if (PID_Samples < DECIMATE_MAX)
+	{
+		PID_Samples++;
+	}
 }
 
 // Run just before PWM output, using averaged data
 void Calculate_PID(void)
 {
-	int32_t PID_gyro_temp1 = 0;				// P1
-	int32_t PID_gyro_temp2 = 0;				// P2
-	int32_t PID_acc_temp1 = 0;				// P1
-	int32_t PID_Gyro_I_actual1 = 0;			// Actual unbound i-terms P1
-	int32_t PID_Gyro_I_actual2 = 0;			// P2
+	int32_t PID_gyro_temp = 0;
+	int32_t PID_acc_temp = 0;
+	int32_t PID_Gyro_I_actual = 0;			// Actual unbound i-terms
 	int32_t PID_gyro_D = 0;					// D-terms
 	int16_t AvAccVert = 0;
+	int32_t sum = 0;
+	uint8_t shift = 0;
+	uint8_t window = 0;
+	uint8_t k = 0;
 	int8_t	axis = 0;
 	int8_t i = 0;
+	int8_t	first = P1;
+	int8_t	last = P2;
 
-	// Initialise arrays with gain values.
-	int8_t 	P_gain[FLIGHT_MODES][NUMBEROFAXIS] = 
-		{
-			{Config.FlightMode[P1].Roll_P_mult, Config.FlightMode[P1].Pitch_P_mult, Config.FlightMode[P1].Yaw_P_mult},
-		 	{Config.FlightMode[P2].Roll_P_mult, Config.FlightMode[P2].Pitch_P_mult, Config.FlightMode[P2].Yaw_P_mult}
-		};
+	//************************************************************
+	// Only calculate the profiles that reach the outputs
+	//************************************************************
 
-	int8_t 	I_gain[FLIGHT_MODES][NUMBEROFAXIS] = 
-		{
-			{Config.FlightMode[P1].Roll_I_mult, Config.FlightMode[P1].Pitch_I_mult, Config.FlightMode[P1].Yaw_I_mult},
-			{Config.FlightMode[P2].Roll_I_mult, Config.FlightMode[P2].Pitch_I_mult, Config.FlightMode[P2].Yaw_I_mult}
-		};
+	active_profiles(&first, &last);
 
-	int8_t 	L_gain[FLIGHT_MODES][NUMBEROFAXIS] = 
-		{
-			{Config.FlightMode[P1].A_Roll_P_mult, Config.FlightMode[P1].A_Pitch_P_mult, Config.FlightMode[P1].A_Zed_P_mult},
-			{Config.FlightMode[P2].A_Roll_P_mult, Config.FlightMode[P2].A_Pitch_P_mult, Config.FlightMode[P2].A_Zed_P_mult}
-		};
+	// Clear the outputs of an unused profile so that nothing stale is left for the mixer
+	if (first != P1)
+	{
+		memset(&PID_Gyros[P1][ROLL], 0, sizeof(int16_t) * NUMBEROFAXIS);
+		memset(&PID_ACCs[P1][ROLL], 0, sizeof(int16_t) * NUMBEROFAXIS);
+	}
+	
+	if (last != P2)
+	{
+		memset(&PID_Gyros[P2][ROLL], 0, sizeof(int16_t) * NUMBEROFAXIS);
+		memset(&PID_ACCs[P2][ROLL], 0, sizeof(int16_t) * NUMBEROFAXIS);
+	}
 
-	// Only for roll and pitch acc trim
-	int16_t	L_trim[FLIGHT_MODES][2] =
-		{
-			{Config.Rolltrim[P1], Config.Pitchtrim[P1]},
-			{Config.Rolltrim[P2], Config.Pitchtrim[P2]}
-		};
+	//************************************************************
+	// Pick the averaging window for the samples since the last call.
+	// Windows are powers of two so the averages are shifts. Excess
+	// samples are the oldest ones and are dropped.
+	//************************************************************
 
-	// D-terms (same for all profiles for now)
-	int16_t	D_gain[NUMBEROFAXIS] =
-		{
-			Config.D_mult_roll, Config.D_mult_pitch, 0
-		};
+	shift = pgm_read_byte(&Window_shift[PID_Samples]);
+	window = (1 << shift);
+	PID_Samples = 0;
 
 	// Average accVert
-	AvAccVert = (int16_t)(PID_AvgAccVert / LoopCount);
-	PID_AvgAccVert = 0;							// Reset average
+	sum = 0;
+	for (k = 1; k <= window; k++)
+	{
+		sum += AccVertRing[(RingHead - k) & DECIMATE_MASK];
+	}
+	
+	AvAccVert = window_average(sum, shift);
 
 	//************************************************************
 	// PID loop
@@ -268,103 +274,86 @@ void Calculate_PID(void)
 		// Get average gyro readings for P-terms
 		//************************************************************
 
-		gyroADC[axis] = (int16_t)(PID_AvgGyro[axis] / LoopCount);
-		PID_AvgGyro[axis] = 0;					// Reset average
+		sum = 0;
+		for (k = 1; k <= window; k++)
+		{
+			sum += GyroRing[(RingHead - k) & DECIMATE_MASK][axis];
+		}
+		
+		gyroADC[axis] = window_average(sum, shift);
 
 		//************************************************************
 		// Get average gyro readings for D-terms
 		//************************************************************
 #ifdef D_METHOD
-		// Average the D-terms previously generated from raw gyro differences
-		GyroDTerm[axis] = (PID_AvgGyroDTerm[axis] / LoopCount);
-		PID_AvgGyroDTerm[axis] = 0;				// Reset average
+		// The sum of the raw gyro differences over the window is just
+		// the newest reading less the one before the window
+		sum = GyroRing[(RingHead - 1) & DECIMATE_MASK][axis] - GyroRing[(RingHead - 1 - window) & DECIMATE_MASK][axis];
+		GyroDTerm[axis] = window_average(sum, shift);
 #else
 		// Measure differences in already-averaged gyro data (in previous step above)
 		GyroDTerm[axis] = (gyroADC[axis] - PID_OldAvgGyro[axis]);
 		PID_OldAvgGyro[axis] = gyroADC[axis];
 #endif
-		//************************************************************
-		// Add in gyro Yaw trim
-		//************************************************************
+		// Gyro D-terms (gains are pre-multiplied by 2). Same for all profiles for now.
+		PID_gyro_D = GyroDTerm[axis] * FlightProfile.D_gain[axis];
 
-		if (axis == YAW)
+		// Do for each active profile
+		for (i = first; i <= last; i++)
 		{
-			PID_gyro_temp1 = (int32_t)(Config.FlightMode[P1].Yaw_trim << 6);
-			PID_gyro_temp2 = (int32_t)(Config.FlightMode[P2].Yaw_trim << 6);
-		}
-		// Reset PID_gyro variables to that data does not accumulate cross-axis
-		else
-		{
-			PID_gyro_temp1 = 0;
-			PID_gyro_temp2 = 0;
-		}
+			//************************************************************
+			// Add in gyro Yaw trim
+			//************************************************************
 
-		//************************************************************
-		// Calculate PID gains
-		//************************************************************
-
-		// Gyro P-term													// Profile P1
-		PID_gyro_temp1 += gyroADC[axis] * P_gain[P1][axis];				// Multiply P-term (Max gain of 127)
-		PID_gyro_temp1 = PID_gyro_temp1 * (int32_t)3;					// Multiply by 3
-
-		// Gyro I-term
-		PID_Gyro_I_actual1 = IntegralGyro[P1][axis] * I_gain[P1][axis];	// Multiply I-term (Max gain of 127)
-		PID_Gyro_I_actual1 = PID_Gyro_I_actual1 >> 5;					// Divide by 32
-
-		// Gyro P-term
-		PID_gyro_temp2 += gyroADC[axis] * P_gain[P2][axis];				// Profile P2
-		PID_gyro_temp2 = PID_gyro_temp2 * (int32_t)3;
+			if (axis == YAW)
+			{
+				PID_gyro_temp = FlightProfile.Yaw_trim[i];
+			}
+			// Reset PID_gyro variables to that data does not accumulate cross-axis
+			else
+			{
+				PID_gyro_temp = 0;
+			}
 
-		// Gyro I-term
-		PID_Gyro_I_actual2 = IntegralGyro[P2][axis] * I_gain[P2][axis];
-		PID_Gyro_I_actual2 = PID_Gyro_I_actual2 >> 5;
+			//************************************************************
+			// Calculate PID gains
+			//************************************************************
 
-		// Gyro D-terms
-		PID_gyro_D = GyroDTerm[axis] * D_gain[axis] * 2;				// Debug
+			// Gyro P-term (gains are pre-multiplied by 3)
+			PID_gyro_temp += (int32_t)gyroADC[axis] * FlightProfile.P_gain[i][axis];
 
-		//************************************************************
-		// I-term output limits
-		//************************************************************
+			// Gyro I-term
+			PID_Gyro_I_actual = IntegralGyro[i][axis] * FlightProfile.I_gain[i][axis];	// Multiply I-term (Max gain of 127)
+			PID_Gyro_I_actual = PID_Gyro_I_actual >> 5;					// Divide by 32
 
-		// P1 limits
-		if (PID_Gyro_I_actual1 > Config.Raw_I_Limits[P1][axis]) 
-		{
-			PID_Gyro_I_actual1 = Config.Raw_I_Limits[P1][axis];
-		}
-		else if (PID_Gyro_I_actual1 < -Config.Raw_I_Limits[P1][axis]) 
-		{
-			PID_Gyro_I_actual1 = -Config.Raw_I_Limits[P1][axis];	
-		}
+			//************************************************************
+			// I-term output limits
+			//************************************************************
 
-		// P2 limits
-		if (PID_Gyro_I_actual2 > Config.Raw_I_Limits[P2][axis]) 
-		{
-			PID_Gyro_I_actual2 = Config.Raw_I_Limits[P2][axis];
-		}
-		else if (PID_Gyro_I_actual2 < -Config.Raw_I_Limits[P2][axis]) 
-		{
-			PID_Gyro_I_actual2 = -Config.Raw_I_Limits[P2][axis];	
-		}
+			if (PID_Gyro_I_actual > FlightProfile.I_limit[i][axis]) 
+			{
+				PID_Gyro_I_actual = FlightProfile.I_limit[i][axis];
+			}
+			else if (PID_Gyro_I_actual < -FlightProfile.I_limit[i][axis]) 
+			{
+				PID_Gyro_I_actual = -FlightProfile.I_limit[i][axis];	
+			}
 
-		//************************************************************
-		// Sum Gyro P, I and D terms and rescale
-		//************************************************************
+			//************************************************************
+			// Sum Gyro P, I and D terms and rescale
+			//************************************************************
 
-		PID_Gyros[P1][axis] = (int16_t)((PID_gyro_temp1 + PID_Gyro_I_actual1 + PID_gyro_D) >> PID_SCALE); // Currently PID_SCALE = 6 so /64
-		PID_Gyros[P2][axis] = (int16_t)((PID_gyro_temp2 + PID_Gyro_I_actual2 + PID_gyro_D) >> PID_SCALE);
+			PID_Gyros[i][axis] = (int16_t)((PID_gyro_temp + PID_Gyro_I_actual + PID_gyro_D) >> PID_SCALE); // Currently PID_SCALE = 6 so /64
 
-		//************************************************************
-		// Calculate error from angle data and trim (roll and pitch only)
-		//************************************************************
+			//************************************************************
+			// Calculate error from angle data and trim (roll and pitch only)
+			//************************************************************
 
-		if (axis < YAW)
-		{
-			// Do for P1 and P2
-			for (i = P1; i <= P2; i++)
+			if (axis < YAW)
 			{
-				PID_acc_temp1 = angle[axis] - L_trim[i][axis];				// Offset angle with trim
-				PID_acc_temp1 *= L_gain[i][axis];							// P-term of accelerometer (Max gain of 127)
-				PID_ACCs[i][axis] = (int16_t)(PID_acc_temp1 >> 8);			// Reduce and convert to integer
+				PID_acc_temp = angle[axis] - FlightProfile.L_trim[i][axis];	// Offset angle with trim
+				PID_acc_temp *= FlightProfile.L_gain[i][axis];				// P-term of accelerometer (Max gain of 127)
+				PID_ACCs[i][axis] = (int16_t)(PID_acc_temp >> 8);			// Reduce and convert to integer
 			}
 		}
 
@@ -374,24 +363,68 @@ void Calculate_PID(void)
 	// Calculate an Acc-Z value 
 	//************************************************************
 
-	// Do for P1 and P2
-	for (i = P1; i <= P2; i++)
+	// Do for each active profile
+	for (i = first; i <= last; i++)
 	{
-		PID_acc_temp1 = -AvAccVert;				// Get and copy Z-acc value. Negate to oppose G
+		PID_acc_temp = -AvAccVert;				// Get and copy Z-acc value. Negate to oppose G
 
-		PID_acc_temp1 *= L_gain[i][YAW];		// Multiply P-term (Max gain of 127)
+		PID_acc_temp *= FlightProfile.L_gain[i][YAW];	// Multiply P-term (Max gain of 127)
 
-		PID_acc_temp1 = PID_acc_temp1 >> 4;		// Moderate Z-acc to reasonable values
+		PID_acc_temp = PID_acc_temp >> 4;		// Moderate Z-acc to reasonable values
 
-		if (PID_acc_temp1 > MAX_ZGAIN)			// Limit to +/-MAX_ZGAIN
+		if (PID_acc_temp > MAX_ZGAIN)			// Limit to +/-MAX_ZGAIN
 		{
-			PID_acc_temp1 = MAX_ZGAIN;
+			PID_acc_temp = MAX_ZGAIN;
 		}
-		if (PID_acc_temp1 < -MAX_ZGAIN)
+		if (PID_acc_temp < -MAX_ZGAIN)
 		{
-			PID_acc_temp1 = -MAX_ZGAIN;
+			PID_acc_temp = -MAX_ZGAIN;
 		}
 
-		PID_ACCs[i][YAW] = (int16_t)PID_acc_temp1; // Copy to global values
+		PID_ACCs[i][YAW] = (int16_t)PID_acc_temp; // Copy to global values
 	}
 }
+
+// Convert the gains in Config.FlightMode[] into the ready-to-use values in FlightProfile,
+// so that the PID loop reads one small table instead of rebuilding its gain arrays every call.
+// Called from UpdateLimits() once the I-term limits and acc trims have been updated.
+void CompilePID(void)
+{
+	uint8_t i;
+
+	for (i = P1; i <= P2; i++)
+	{
+		// Gyro P-terms are always multiplied by 3
+		FlightProfile.P_gain[i][ROLL] = Config.FlightMode[i].Roll_P_mult * 3;
+		FlightProfile.P_gain[i][PITCH] = Config.FlightMode[i].Pitch_P_mult * 3;
+		FlightProfile.P_gain[i][YAW] = Config.FlightMode[i].Yaw_P_mult * 3;
+
+		// The yaw trim is added before that multiplication
+		FlightProfile.Yaw_trim[i] = Config.FlightMode[i].Yaw_trim * (64 * 3);
+
+		FlightProfile.I_gain[i][ROLL] = Config.FlightMode[i].Roll_I_mult;
+		FlightProfile.I_gain[i][PITCH] = Config.FlightMode[i].Pitch_I_mult;
+		FlightProfile.I_gain[i][YAW] = Config.FlightMode[i].Yaw_I_mult;
+
+		FlightProfile.L_gain[i][ROLL] = Config.FlightMode[i].A_Roll_P_mult;
+		FlightProfile.L_gain[i][PITCH] = Config.FlightMode[i].A_Pitch_P_mult;
+		FlightProfile.L_gain[i][YAW] = Config.FlightMode[i].A_Zed_P_mult;
+
+		FlightProfile.L_trim[i][ROLL] = Config.Rolltrim[i];
+		FlightProfile.L_trim[i][PITCH] = Config.Pitchtrim[i];
+
+		// Stick rate divider. 0 is slowest, 4 is fastest.
+		// /64 (15.25), /32 (30.5), /16 (61*), /8 (122), /4 (244)
+		FlightProfile.Stick_shift[i][ROLL] = 6 - Config.FlightMode[i].Roll_Rate;
+		FlightProfile.Stick_shift[i][PITCH] = 6 - Config.FlightMode[i].Pitch_Rate;
+		FlightProfile.Stick_shift[i][YAW] = 6 - Config.FlightMode[i].Yaw_Rate;
+	}
+
+	memcpy(FlightProfile.I_limit, Config.Raw_I_Limits, sizeof(FlightProfile.I_limit));
+	memcpy(FlightProfile.I_constrain, Config.Raw_I_Constrain, sizeof(FlightProfile.I_constrain));
+
+	// D-terms (same for all profiles for now) are always multiplied by 2
+	FlightProfile.D_gain[ROLL] = Config.D_mult_roll * 2;
+	FlightProfile.D_gain[PITCH] = Config.D_mult_pitch * 2;
+	FlightProfile.D_gain[YAW] = 0;
+}
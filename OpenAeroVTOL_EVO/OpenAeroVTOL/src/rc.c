@@ -20,6 +20,8 @@
 #include "main.h"
 #include "eeprom.h"
 #include "mixer.h"
+#include "serial_rx.h"
+#include "ticks.h"
 
 //************************************************************
 // Prototypes
@@ -28,12 +30,16 @@
 void RxGetChannels(void);
 void RC_Deadband(void);
 void CenterSticks(void);
+void RC_Smooth(void);
 
 //************************************************************
 // Defines
 //************************************************************
 
 #define	NOISE_THRESH	5			// Max RX noise threshold
+#define CPPM_SLEW_STEP	25			// Config.CPPM_slew units, 1% of full travel (10us)
+#define RC_SMOOTHED		5			// THROTTLE to RUDDER, then MonopolarThrottle
+#define RC_SMOOTH_MAX	977			// Longest ramp in system ticks (50ms)
 
 //************************************************************
 // Code
@@ -42,25 +48,125 @@ void CenterSticks(void);
 volatile int16_t RCinputs[MAX_RC_CHANNELS + 1];	// Normalised RC inputs
 volatile int16_t MonopolarThrottle;				// Monopolar throttle
 
+#ifdef RC_SMOOTHING
+static bool RC_new_frame = false;				// Set by RxGetChannels() on a new frame
+static int16_t RC_from[RC_SMOOTHED];			// Ramp start
+static int16_t RC_to[RC_SMOOTHED];				// Ramp end, the latest frame
+static uint16_t RC_recip = 0;					// 65535 / RC_frame_period
+static uint32_t RC_frame_start = 0;				// Tick count at the latest frame
+static uint32_t RC_frame_period = RC_SMOOTH_MAX;	// Ticks between the last two frames
+#endif
+
+static uint16_t CPPM_history[MAX_RC_CHANNELS][2];	// Last two raw frames
+static uint16_t CPPM_filtered[MAX_RC_CHANNELS];	// Filter output
+static bool CPPM_primed = false;				// Cleared while the filter is off
+
+// Filter each CPPM channel once per frame.
+// A median of the last three frames rejects single-frame glitches,
+// then the change per frame is limited to Config.CPPM_slew percent.
+static const uint16_t* CPPM_Filter(void)
+{
+	static uint8_t last_frame;
+	uint16_t a, b, c, median;
+	int16_t step, slew;
+	uint8_t i;
+
+	if (CPPM_primed && (CPPM_frames == last_frame))
+	{
+		return CPPM_filtered;
+	}
+
+	last_frame = CPPM_frames;
+	slew = (int16_t)Config.CPPM_slew * CPPM_SLEW_STEP;
+
+	for (i = 0; i < MAX_RC_CHANNELS; i++)
+	{
+		a = RxChannel[i];
+
+		// Start from the first frame seen
+		if (!CPPM_primed)
+		{
+			CPPM_history[i][0] = a;
+			CPPM_history[i][1] = a;
+			CPPM_filtered[i] = a;
+		}
+
+		b = CPPM_history[i][0];
+		c = CPPM_history[i][1];
+		CPPM_history[i][1] = b;
+		CPPM_history[i][0] = a;
+
+		// Median of three
+		if (a > b)
+		{
+			median = (b > c) ? b : ((a > c) ? c : a);
+		}
+		else
+		{
+			median = (a > c) ? a : ((b > c) ? c : b);
+		}
+
+		step = median - CPPM_filtered[i];
+
+		if (step > slew)
+		{
+			step = slew;
+		}
+		else if (step < -slew)
+		{
+			step = -slew;
+		}
+
+		CPPM_filtered[i] += step;
+	}
+
+	CPPM_primed = true;
+
+	return CPPM_filtered;
+}
+
 // Get raw flight channel data (~2500 to 5000) and remove zero offset
 // Use channel mapping for reconfigurability
 void RxGetChannels(void)
 {
 	static	int16_t	OldRxSum;			// Sum of all major channels
+	const volatile uint16_t *Channel = RxChannel;
 	int16_t	RxSumDiff;
 	int16_t	RxSum, i;
 
+	// Unpack any new serial frame into RxChannel[]
+	RxDecodeSerial();
+
+#ifdef RC_SMOOTHING
+	// In FAST mode this runs on every loop of the burst via Interrupted_Clone,
+	// but only Interrupted marks a frame that has actually just arrived
+	if (Interrupted)
+	{
+		RC_new_frame = true;
+	}
+#endif
+
+	// Median and slew filter CPPM if selected
+	if ((Config.RxMode == CPPM_MODE) && (Config.CPPM_slew > 0))
+	{
+		Channel = CPPM_Filter();
+	}
+	else
+	{
+		CPPM_primed = false;
+	}
+
 	// Remove zero offsets
 	for (i=0; i < MAX_RC_CHANNELS; i++)
 	{
-		RCinputs[i]	= RxChannel[i] - Config.RxChannelZeroOffset[i];
+		RCinputs[i]	= Channel[i] - Config.RxChannelZeroOffset[i];
 	}
 
 	// Special handling for monopolar throttle
-	MonopolarThrottle = RxChannel[THROTTLE] - Config.RxChannelZeroOffset[THROTTLE];
+	MonopolarThrottle = Channel[THROTTLE] - Config.RxChannelZeroOffset[THROTTLE];
 
 	// Bipolar throttle must use the nominal mid-point
-	RCinputs[THROTTLE] = RxChannel[THROTTLE] - 3750; 
+	RCinputs[THROTTLE] = Channel[THROTTLE] - 3750; 
 
 	// Reverse primary channels as requested
 	if (Config.AileronPol == REVERSED)
@@ -98,6 +204,80 @@ void RxGetChannels(void)
 	OldRxSum = RxSum;
 }
 
+#ifdef RC_SMOOTHING
+// Called every loop after the RC frame has been handled.
+// In FAST mode the PID and mixer run several times per RC frame. Rather than
+// stepping at each frame, the sticks and throttle ramp from where they are to
+// the new frame over the time the last frame took to arrive. The ramp ends as
+// the next frame is due, so this adds at most one frame of latency.
+void RC_Smooth(void)
+{
+	static int16_t out[RC_SMOOTHED];
+	uint32_t now, elapsed;
+	uint16_t frac;
+	uint8_t i;
+
+	if (Config.Servo_rate != FAST)
+	{
+		return;
+	}
+
+	now = ticks_now();
+
+	// Start a new ramp when a frame arrives
+	if (RC_new_frame)
+	{
+		RC_new_frame = false;
+
+		RC_frame_period = TICKS_ELAPSED(RC_frame_start, now);
+		RC_frame_start = now;
+
+		if (RC_frame_period > RC_SMOOTH_MAX)
+		{
+			RC_frame_period = RC_SMOOTH_MAX;
+		}
+		else if (RC_frame_period < 1)
+		{
+			RC_frame_period = 1;
+		}
+
+		// One division per frame
+		RC_recip = 65535 / RC_frame_period;
+
+		for (i = 0; i < RC_SMOOTHED; i++)
+		{
+			RC_from[i] = out[i];
+			RC_to[i] = (i < (RC_SMOOTHED - 1)) ? RCinputs[i] : MonopolarThrottle;
+		}
+	}
+
+	elapsed = TICKS_ELAPSED(RC_frame_start, now);
+
+	// Fraction of the ramp done, 0 to 65535. Rounded to the nearest count
+	// so that the last few counts of a ramp are not lost to truncation.
+	frac = (elapsed < RC_frame_period) ? (uint16_t)(elapsed * RC_recip) : 0;
+
+	for (i = 0; i < RC_SMOOTHED; i++)
+	{
+		if (elapsed >= RC_frame_period)
+		{
+			out[i] = RC_to[i];
+		}
+		else
+		{
+			out[i] = RC_from[i] + (int16_t)((((int32_t)(RC_to[i] - RC_from[i]) * frac) + 32768) >> 16);
+		}
+	}
+
+	for (i = THROTTLE; i <= RUDDER; i++)
+	{
+		RCinputs[i] = out[i];
+	}
+
+	MonopolarThrottle = out[RC_SMOOTHED - 1];
+}
+#endif
+
 // Center sticks on request from Menu
 void CenterSticks(void)		
 {
@@ -108,6 +288,8 @@ void CenterSticks(void)
 	// RxChannel will auto-update every RC frame (normally 46Hz or so)
 	for (i=0; i<8; i++)
 	{
+		RxDecodeSerial();
+
 		for (j=0; j<MAX_RC_CHANNELS; j++)
 		{
 			RxChannelZeroOffset[j] += RxChannel[j];
@@ -0,0 +1,283 @@
+//***********************************************************
+//* sensors.c
+//*
+//* Read the MPU6050 accelerometers, temperature and gyros
+//* in one I2C transaction.
+//* ACCEL_XOUT_H to GYRO_ZOUT_L are 14 contiguous registers.
+//*
+//* StartSensors() queues the read on the TWI interrupt so the
+//* main loop can carry on while the bytes arrive.
+//* ReadSensors() collects and processes it, starting it first
+//* if nothing is pending.
+//*
+//* With MPU6050_FIFO defined the MPU6050 samples at a fixed
+//* 1kHz into its FIFO, in the same 14-byte layout.
+//* StartSensors() queues a read of 1, 2, 4 or 8 samples, as
+//* many as the last FIFO count showed, then a new FIFO count.
+//* ReadSensors() averages the samples with a shift and sets
+//* SensorInterval to the exact time they cover, or to zero if
+//* there were none or the read failed.
+//* If more than FIFO_BACKLOG samples are left over after a
+//* stall, the FIFO is reset rather than drained.
+//***********************************************************
+
+//***********************************************************
+//* Includes
+//***********************************************************
+
+#include "compiledefs.h"
+#include <avr/io.h>
+#include <stdbool.h>
+#include "io_cfg.h"
+#include "i2c.h"
+#include "twi_isr.h"
+#include "MPU6050.h"
+#include "gyros.h"
+#include "acc.h"
+
+//************************************************************
+// Prototypes
+//************************************************************
+
+void StartSensors(void);
+void ReadSensors(void);
+void init_sensor_fifo(void);
+void reset_sensor_fifo(void);
+
+//************************************************************
+// Defines
+//************************************************************
+
+#define SENSOR_BYTES	14			// Acc XYZ, temperature, gyro XYZ
+#define ACC_OFFSET		0			// Offset of ACCEL_XOUT_H in the burst
+#define TEMP_OFFSET		6			// Offset of TEMP_OUT_H in the burst
+#define GYRO_OFFSET		8			// Offset of GYRO_XOUT_H in the burst
+
+#define FIFO_SENSORS	0xF8		// Temperature, gyro XYZ and acc XYZ into the FIFO
+#define FIFO_SIZE		1024		// MPU6050 FIFO size in bytes
+#define FIFO_BATCH		8			// Most samples read per loop
+#define FIFO_BATCH_SHIFT 3			// log2(FIFO_BATCH)
+#define FIFO_BACKLOG	(FIFO_BATCH * 2)	// Most samples left over before the FIFO is resynced
+#define FIFO_PERIOD		2500		// 1kHz sample period in Timer1 ticks (400ns)
+#define FIFO_NONE		-1			// No samples to read
+
+//************************************************************
+// Code
+//************************************************************
+
+int16_t sensorTemp;					// Raw MPU6050 temperature
+
+static volatile uint8_t SensorStatus = TWI_IDLE;
+
+#ifdef MPU6050_FIFO
+uint32_t SensorInterval = 0;		// Time covered by the last samples read, in Timer1 ticks
+
+static uint8_t Sensors[SENSOR_BYTES * FIFO_BATCH];
+static uint8_t FifoCount[2];
+static volatile uint8_t FifoStatus = TWI_IDLE;	// Status of the sample read
+static int8_t FifoShift = FIFO_NONE;			// log2 of the samples to read next
+static int8_t FifoQueued = FIFO_NONE;			// log2 of the samples being read
+#else
+static uint8_t Sensors[SENSOR_BYTES];
+#endif
+
+// Decode one 14-byte frame into accADC[], gyroADC[] and sensorTemp
+static void decode_sensors(void)
+{
+	int16_t temp1, temp2;
+
+	decode_accs(&Sensors[ACC_OFFSET]);
+	decode_gyros(&Sensors[GYRO_OFFSET]);
+
+	temp1 = Sensors[TEMP_OFFSET] << 8;
+	temp2 = Sensors[TEMP_OFFSET + 1];
+	sensorTemp = temp1 + temp2;
+
+	ProcessGyros();
+	ProcessAcc();
+}
+
+#ifndef MPU6050_FIFO
+
+// Queue the next burst read unless one is already under way
+void StartSensors(void)
+{
+	if (SensorStatus != TWI_PENDING)
+	{
+		if (!twi_read(MPU60X0_DEFAULT_ADDRESS,MPU60X0_RA_ACCEL_XOUT_H,Sensors,SENSOR_BYTES,&SensorStatus))
+		{
+			SensorStatus = TWI_ERROR;
+		}
+	}
+}
+
+// Equivalent to ReadGyros() followed by ReadAcc(), but with one I2C transaction.
+// If the read failed, gyroADC[] and accADC[] keep their last values.
+void ReadSensors(void)
+{
+	StartSensors();
+
+	if (!twi_wait(&SensorStatus))
+	{
+		SensorStatus = TWI_IDLE;
+		return;
+	}
+
+	SensorStatus = TWI_IDLE;
+
+	decode_sensors();
+}
+
+#else
+
+// Set the sample rate and start the FIFO.
+// The gyro output rate is 8kHz with the DLPF off (260Hz or no filter)
+// and 1kHz otherwise, so the divider is set to give 1kHz either way.
+void init_sensor_fifo(void)
+{
+	if ((Config.MPU6050_LPF == HZ260) || (Config.MPU6050_LPF == NOFILTER))
+	{
+		writeI2Cbyte(MPU60X0_DEFAULT_ADDRESS, MPU60X0_RA_SMPLRT_DIV, 7);
+	}
+	else
+	{
+		writeI2Cbyte(MPU60X0_DEFAULT_ADDRESS, MPU60X0_RA_SMPLRT_DIV, 0);
+	}
+
+	writeI2Cbyte(MPU60X0_DEFAULT_ADDRESS, MPU60X0_RA_FIFO_EN, FIFO_SENSORS);
+	reset_sensor_fifo();
+}
+
+// Empty the FIFO and restart sampling into it
+void reset_sensor_fifo(void)
+{
+	writeI2Cbyte(MPU60X0_DEFAULT_ADDRESS, MPU60X0_RA_USER_CTRL, 0);
+	writeI2Cbyte(MPU60X0_DEFAULT_ADDRESS, MPU60X0_RA_USER_CTRL, (1 << MPU60X0_USERCTRL_FIFO_RESET_BIT));
+	writeI2Cbyte(MPU60X0_DEFAULT_ADDRESS, MPU60X0_RA_USER_CTRL, (1 << MPU60X0_USERCTRL_FIFO_EN_BIT));
+
+	// Anything counted before the reset has gone
+	FifoShift = FIFO_NONE;
+}
+
+// Queue the read of the samples the last FIFO count found, then a new
+// FIFO count, unless they are already under way.
+// The count is read after the samples, so it only shows what is left.
+void StartSensors(void)
+{
+	if (SensorStatus != TWI_PENDING)
+	{
+		FifoQueued = FifoShift;
+		FifoShift = FIFO_NONE;
+
+		if (FifoQueued != FIFO_NONE)
+		{
+			if (!twi_read(MPU60X0_DEFAULT_ADDRESS,MPU60X0_RA_FIFO_R_W,Sensors,(SENSOR_BYTES << FifoQueued),&FifoStatus))
+			{
+				FifoStatus = TWI_ERROR;
+			}
+		}
+
+		if (!twi_read(MPU60X0_DEFAULT_ADDRESS,MPU60X0_RA_FIFO_COUNTH,FifoCount,2,&SensorStatus))
+		{
+			SensorStatus = TWI_ERROR;
+		}
+	}
+}
+
+// Collect the samples queued by StartSensors() and average them.
+// Any samples left over are read on the following loops.
+// If there were none or the read failed, gyroADC[] and accADC[] keep
+// their last values and SensorInterval is zero, so the update is skipped.
+void ReadSensors(void)
+{
+	int32_t sum;
+	uint16_t count = 0;
+	uint8_t samples, i, j;
+	int8_t shift;
+	int16_t	word;
+
+	SensorInterval = 0;
+
+	StartSensors();
+
+	// Samples first, then the count that was queued after them
+	if (FifoQueued != FIFO_NONE)
+	{
+		twi_wait(&FifoStatus);
+	}
+
+	if (twi_wait(&SensorStatus))
+	{
+		count = (FifoCount[0] << 8) + FifoCount[1];
+	}
+
+	SensorStatus = TWI_IDLE;
+
+	// Overflowed, no longer aligned to whole samples, or the sample read
+	// failed part way through. Start again
+	if ((count > (FIFO_SIZE - SENSOR_BYTES)) || (count % SENSOR_BYTES) ||
+		((FifoQueued != FIFO_NONE) && (FifoStatus != TWI_DONE)))
+	{
+		reset_sensor_fifo();
+		count = 0;
+	}
+
+	// Fallen behind after a stall. Draining the backlog would take many loops
+	// of stale data, and the samples just read are the oldest of it.
+	// Drop them all and resync
+	if (count > (SENSOR_BYTES * FIFO_BACKLOG))
+	{
+		reset_sensor_fifo();
+		count = 0;
+		FifoQueued = FIFO_NONE;
+	}
+
+	// Read the largest power of two samples available next time
+	samples = count / SENSOR_BYTES;
+
+	for (shift = FIFO_BATCH_SHIFT; shift >= 0; shift--)
+	{
+		if (samples >= (1 << shift))
+		{
+			FifoShift = shift;
+			break;
+		}
+	}
+
+	// Use this loop's samples only if they were all read
+	shift = FifoQueued;
+	FifoQueued = FIFO_NONE;
+
+	if ((shift == FIFO_NONE) || (FifoStatus != TWI_DONE))
+	{
+		FifoStatus = TWI_IDLE;
+		return;
+	}
+
+	FifoStatus = TWI_IDLE;
+	samples = (1 << shift);
+
+	// Average the batch into the first frame
+	if (shift > 0)
+	{
+		for (j = 0; j < SENSOR_BYTES; j += 2)
+		{
+			sum = 0;
+
+			for (i = 0; i < (SENSOR_BYTES << shift); i += SENSOR_BYTES)
+			{
+				sum += (int16_t)((Sensors[i + j] << 8) + Sensors[i + j + 1]);
+			}
+
+			word = (int16_t)(sum >> shift);
+			Sensors[j] = (uint8_t)((uint16_t)word >> 8);
+			Sensors[j + 1] = (uint8_t)word;
+		}
+	}
+
+	SensorInterval = (uint32_t)samples * FIFO_PERIOD;
+
+	decode_sensors();
+}
+
+#endif // MPU6050_FIFO
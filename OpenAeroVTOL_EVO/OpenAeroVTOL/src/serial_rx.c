@@ -0,0 +1,909 @@
+//***********************************************************
+//* serial_rx.c
+//*
+//* Serial RC input: Xtreme, S.Bus, Spektrum and CRSF.
+//* USART0_RX_vect only timestamps each byte and pushes it into
+//* RxRing[], marking the first byte after a gap as a packet
+//* start and keeping its TCNT1 time in RxStampTime[].
+//* The START and LOST flags are kept two bits per entry in
+//* RxRingFlags[], so the ring costs 160 bytes, not 256.
+//* RxDecodeSerial() drains the ring in the main loop and
+//* feeds each byte to the parser for the selected RxMode.
+//*
+//* The ring has a single producer (the interrupt, which owns
+//* RxRingHead) and a single consumer (the main loop, which owns
+//* RxRingTail), so neither side needs to block the other.
+//* A parser writes a whole frame to RxChannel[] before setting
+//* Interrupted, and as both happen in the main loop, the flight
+//* code never sees a part-written frame.
+//*
+//* Each decoded frame also updates a running estimate of the
+//* RC frame period, which FAST mode uses to plan how many PWM
+//* bursts to output while RC interrupts are blocked.
+//***********************************************************
+
+//***********************************************************
+//* Includes
+//***********************************************************
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <stdbool.h>
+#include "typedefs.h"
+#include "io_cfg.h"
+#include "main.h"
+#include "isr.h"
+#include "eeprom.h"
+#include "serial_rx.h"
+#include "ticks.h"
+
+//************************************************************
+// Prototypes
+//************************************************************
+
+void RxDecodeSerial(void);
+void RxParseByte(uint16_t entry);
+uint8_t RxBurstPulses(uint32_t pwm_interval);
+
+//************************************************************
+// Defines
+//************************************************************
+
+#define SBUS_FLAGS		23			// Flag byte within the S.Bus frame
+
+#define CRSF_ADDRESS	0xC8		// Flight controller address. Starts every frame to us
+#define CRSF_RC_CHANNELS 0x16		// Frame types
+#define CRSF_LINK_STATS	0x14
+#define CRSF_RC_LENGTH	24			// Type, 22 bytes of channel data and CRC
+#define CRSF_STATS_LENGTH 12		// Type, 10 bytes of link statistics and CRC
+#define CRSF_LENGTH_MIN	2			// Type and CRC
+#define CRSF_LENGTH_MAX	62			// Frames are at most 64 bytes
+#define CRSF_PAYLOAD	3			// First payload byte within the frame
+
+#define PERIOD_MIN		39			// Shortest believable frame period in system ticks (2ms)
+#define PERIOD_MAX		507			// Longest frame period, so that RxFramePeriod fits 16 bits (26ms)
+#define PERIOD_GAP_MAX	8			// Most frame periods spanned by one interval while RC is blocked
+#define PERIOD_LONG_MAX	4			// Long intervals in a row with RC on before the estimate restarts
+#define STAMP_AGE_MAX	500			// Oldest TCNT1 stamp that can be aged without ambiguity in system ticks (25.6ms)
+
+#define PACKET_MARGIN	2500		// RC must be back on this long before the next packet starts (1ms)
+#define BURST_SPAN_MAX	100000		// Longest PWM burst cycle (40ms)
+#define BURST_PULSES_MAX 16			// Most PWM pulses in one burst
+
+//************************************************************
+// Data
+//************************************************************
+
+volatile uint8_t RxRing[RX_RING_SIZE];			// Received bytes
+volatile uint8_t RxRingFlags[RX_RING_SIZE / 4];	// RX_RING_START/RX_RING_LOST of each byte. Written by USART0_RX_vect only
+volatile uint8_t RxRingHead = 0;				// Next free entry. Written by USART0_RX_vect only
+volatile uint8_t RxRingTail = 0;				// Next unread entry. Written by RxDecodeSerial() only
+volatile uint8_t RxOverruns = 0;				// Bytes dropped with the ring full, saturates at 255
+volatile uint16_t RxStampTime[RX_STAMPS];		// TCNT1 at recent RX_RING_START bytes
+volatile uint8_t RxStampEntry[RX_STAMPS];		// RxRing[] index of each of those bytes
+volatile uint8_t RxStampHead = 0;				// Next stamp to write. Written by USART0_RX_vect only
+
+uint16_t SerialChannel[SERIAL_CHANNELS];		// All S.Bus/CRSF channels in transmitter order (~2500 to 5000)
+volatile uint8_t RxFlags = 0;					// S.Bus frame flags (enum SerialFlags). RX_FAILSAFE also set by CRSF
+uint8_t RxLinkQuality = 0;						// CRSF uplink quality (0 to 100%)
+
+static char sBuffer[SBUFFER_SIZE];				// Current packet
+static uint8_t rcindex;							// Serial data buffer pointer
+static uint8_t bytecount;						// Bytes since the packet start
+static uint16_t checksum;
+static uint16_t chanmask16;
+static uint8_t xtreme_channels;					// Channels in the Xtreme mask
+static bool skip_packet;						// Bytes were lost. Ignore the rest of this packet
+
+volatile bool RxBlocked = false;				// Set while RC interrupts are blocked, so frames may be missed
+uint16_t RxFramePeriod = 0;						// RC frame period estimate in T1 ticks (400ns). 0 = not known yet
+static uint16_t frame_period;					// RC frame period estimate in system ticks * 16
+static uint32_t frame_start;					// Packet start of the last decoded frame in system ticks * 16
+static bool frame_known = false;				// frame_start is valid
+static uint32_t packet_start;					// Start of the packet being parsed in system ticks * 16
+static bool packet_known = false;				// packet_start is valid and not yet used by a frame
+static uint32_t decode_ticks;					// Tick count at the last RxDecodeSerial()
+static uint8_t frame_long;						// Long intervals in a row with RC on
+
+// Time to transmit one packet in T1 ticks (400ns), in enum RX_Modes order
+static const uint16_t packet_time[] PROGMEM = 
+{
+	0, 0,
+	7500,		// S.Bus, 25 bytes at 12 bits and 100kbps (3ms)
+	3472,		// Spektrum, 16 bytes at 115.2kbps (1389us)
+	3700,		// Xtreme, 37 bytes at 250kbps (1480us)
+	1548		// CRSF, 26 bytes at 420kbps (619us)
+};
+
+// CRC8 with the DVB-S2 polynomial 0xD5, as used by CRSF
+static const uint8_t crsf_crc_table[256] PROGMEM = 
+{
+	0x00, 0xD5, 0x7F, 0xAA, 0xFE, 0x2B, 0x81, 0x54, 0x29, 0xFC, 0x56, 0x83, 0xD7, 0x02, 0xA8, 0x7D,
+	0x52, 0x87, 0x2D, 0xF8, 0xAC, 0x79, 0xD3, 0x06, 0x7B, 0xAE, 0x04, 0xD1, 0x85, 0x50, 0xFA, 0x2F,
+	0xA4, 0x71, 0xDB, 0x0E, 0x5A, 0x8F, 0x25, 0xF0, 0x8D, 0x58, 0xF2, 0x27, 0x73, 0xA6, 0x0C, 0xD9,
+	0xF6, 0x23, 0x89, 0x5C, 0x08, 0xDD, 0x77, 0xA2, 0xDF, 0x0A, 0xA0, 0x75, 0x21, 0xF4, 0x5E, 0x8B,
+	0x9D, 0x48, 0xE2, 0x37, 0x63, 0xB6, 0x1C, 0xC9, 0xB4, 0x61, 0xCB, 0x1E, 0x4A, 0x9F, 0x35, 0xE0,
+	0xCF, 0x1A, 0xB0, 0x65, 0x31, 0xE4, 0x4E, 0x9B, 0xE6, 0x33, 0x99, 0x4C, 0x18, 0xCD, 0x67, 0xB2,
+	0x39, 0xEC, 0x46, 0x93, 0xC7, 0x12, 0xB8, 0x6D, 0x10, 0xC5, 0x6F, 0xBA, 0xEE, 0x3B, 0x91, 0x44,
+	0x6B, 0xBE, 0x14, 0xC1, 0x95, 0x40, 0xEA, 0x3F, 0x42, 0x97, 0x3D, 0xE8, 0xBC, 0x69, 0xC3, 0x16,
+	0xEF, 0x3A, 0x90, 0x45, 0x11, 0xC4, 0x6E, 0xBB, 0xC6, 0x13, 0xB9, 0x6C, 0x38, 0xED, 0x47, 0x92,
+	0xBD, 0x68, 0xC2, 0x17, 0x43, 0x96, 0x3C, 0xE9, 0x94, 0x41, 0xEB, 0x3E, 0x6A, 0xBF, 0x15, 0xC0,
+	0x4B, 0x9E, 0x34, 0xE1, 0xB5, 0x60, 0xCA, 0x1F, 0x62, 0xB7, 0x1D, 0xC8, 0x9C, 0x49, 0xE3, 0x36,
+	0x19, 0xCC, 0x66, 0xB3, 0xE7, 0x32, 0x98, 0x4D, 0x30, 0xE5, 0x4F, 0x9A, 0xCE, 0x1B, 0xB1, 0x64,
+	0x72, 0xA7, 0x0D, 0xD8, 0x8C, 0x59, 0xF3, 0x26, 0x5B, 0x8E, 0x24, 0xF1, 0xA5, 0x70, 0xDA, 0x0F,
+	0x20, 0xF5, 0x5F, 0x8A, 0xDE, 0x0B, 0xA1, 0x74, 0x09, 0xDC, 0x76, 0xA3, 0xF7, 0x22, 0x88, 0x5D,
+	0xD6, 0x03, 0xA9, 0x7C, 0x28, 0xFD, 0x57, 0x82, 0xFF, 0x2A, 0x80, 0x55, 0x01, 0xD4, 0x7E, 0xAB,
+	0x84, 0x51, 0xFB, 0x2E, 0x7A, 0xAF, 0x05, 0xD0, 0xAD, 0x78, 0xD2, 0x07, 0x53, 0x86, 0x2C, 0xF9
+};
+
+//************************************************************
+// Code
+//************************************************************
+
+//************************************************************
+//* Frame period estimate
+//*
+//* Intervals between decoded frames are measured from the TCNT1
+//* time of the first byte of each packet, as the interrupt saw it,
+//* and averaged into frame_period. While RC interrupts are
+//* blocked, whole frames are missed and an interval spans several
+//* frame periods, so it is divided by the nearest whole number
+//* of periods first. With RC on throughout, an interval of more
+//* than one period is just a lost frame, unless it keeps on 
+//* happening, in which case the estimate was a fraction of the 
+//* true period and is restarted.
+//************************************************************
+
+// Find the time of the packet start at RxRing[index], newest stamp first.
+// The TCNT1 stamp is aged against TCNT1 now and taken off the tick count
+static void packet_stamp(uint8_t index)
+{
+	uint8_t slot = RxStampHead;
+	uint8_t i;
+	uint16_t age;
+
+	packet_known = false;
+
+	for (i = 0; i < RX_STAMPS; i++)
+	{
+		slot = (slot - 1) & (RX_STAMPS - 1);
+
+		if (RxStampEntry[slot] == index)
+		{
+			// T1 ticks (400ns) / 8 = system ticks * 16
+			age = TIM16_ReadTCNT1() - RxStampTime[slot];
+			packet_start = (decode_ticks << 4) - (age >> 3);
+			packet_known = true;
+			break;
+		}
+	}
+}
+
+static void frame_done(void)
+{
+	uint32_t elapsed = packet_start - frame_start;
+	bool blocked = RxBlocked;
+	bool known = frame_known;
+	uint16_t sample;
+	uint8_t periods;
+
+	RxBlocked = false;
+
+	// Flag that a new frame is ready
+	Interrupted = true;
+
+	// No start time for this frame, so neither interval around it can be measured
+	if (!packet_known)
+	{
+		frame_known = false;
+		return;
+	}
+
+	frame_start = packet_start;
+	frame_known = true;
+	packet_known = false;
+
+	// Signal lost or first frame
+	if (!known || (elapsed > (((uint32_t)PERIOD_MAX * PERIOD_GAP_MAX) << 4)))
+	{
+		return;
+	}
+
+	// Start a new estimate from an interval known to be one frame long
+	if (frame_period == 0)
+	{
+		if (blocked || (elapsed < (PERIOD_MIN << 4)) || (elapsed > (PERIOD_MAX << 4)))
+		{
+			return;
+		}
+
+		frame_period = elapsed;
+	}
+	else
+	{
+		periods = (elapsed + (frame_period >> 1)) / frame_period;
+
+		if (periods == 0)
+		{
+			periods = 1;
+		}
+
+		if (!blocked && (periods > 1))
+		{
+			if (++frame_long >= PERIOD_LONG_MAX)
+			{
+				frame_long = 0;
+				frame_period = 0;
+				RxFramePeriod = 0;
+			}
+
+			return;
+		}
+
+		frame_long = 0;
+
+		if (periods > PERIOD_GAP_MAX)
+		{
+			return;
+		}
+
+		sample = elapsed / periods;
+
+		if (sample < (PERIOD_MIN << 4))
+		{
+			sample = (PERIOD_MIN << 4);
+		}
+		else if (sample > (PERIOD_MAX << 4))
+		{
+			sample = (PERIOD_MAX << 4);
+		}
+
+		// Filter with a time constant of four frames
+		frame_period += ((int16_t)(sample - frame_period)) >> 2;
+	}
+
+	// 51.2us per tick, 400ns per T1 tick
+	RxFramePeriod = frame_period << 3;
+}
+
+//************************************************************
+//* XPS Xtreme format (8-N-1/250Kbps) (1480us for a 37 bytes packet)
+//*
+//* Byte 0: Bit 3 should always be 0 unless there really is a lost packet.
+//* Byte 1: RSS
+//* Byte 2: Mask 
+//* 		The mask value determines the number of channels in the stream. 
+//*			A 6 channel stream is going to have a mask of 0x003F (00000000 00111111) 
+//*			if outputting all 6 channels.  It is possible to ouput only channels 2 
+//*			and 4 in the stream (00000000 00001010).  In which case the first word 
+//*			of data will be channel 2 and the 2nd word will be channel.
+//*  
+//*  0x00   0x23   0x000A   0x5DC   0x5DD   0xF0
+//*  ^^^^   ^^^^   ^^^^^^   ^^^^^   ^^^^^   ^^^^
+//*  Flags  dBm     Mask    CH 2    CH 4    ChkSum
+//*
+//************************************************************
+
+static void xtreme_byte(uint8_t temp)
+{
+	uint16_t temp16;
+	uint8_t sindex;
+	uint8_t j;
+
+	// Look at flag byte to see if the data is meant for us
+	if (bytecount == 0)
+	{
+		// Check top 3 bits for channel bank
+		// Trash checksum if not clear
+		if (temp & 0xE0)
+		{
+			checksum +=	0x55;
+		}
+	}
+
+	// Get MSB of mask byte
+	if (bytecount == 2)
+	{
+		chanmask16 = 0;
+		chanmask16 = temp << 8;		// High byte of Mask
+	}
+
+	// Combine with LSB of mask byte
+	// Work out how many channels there are supposed to be
+	if (bytecount == 3)
+	{
+		chanmask16 += (uint16_t)temp;	// Low byte of Mask
+		temp16 = chanmask16;			// Need to keep a copy od chanmask16
+
+		// Count bits set (number of active channels)				 
+		for (xtreme_channels = 0; temp16; xtreme_channels++)
+		{
+			temp16 &= temp16 - 1;
+		}
+	}
+
+	// Add up checksum up until final packet
+	if (bytecount < ((xtreme_channels << 1) + 4))
+	{
+		checksum +=	temp;
+	}
+	
+	// Process data when all packets received
+	else
+	{
+		// Check checksum 
+		checksum &= 0xff;
+
+		// Ignore packet if checksum wrong
+		if (checksum != temp) // temp holds the transmitted checksum byte
+		{
+			Interrupted = false;
+			xtreme_channels = 0;
+			checksum = 0;
+		}
+		else
+		{
+			// Set start of channel data per format
+			sindex = 4; // Channel data from byte 5
+
+			// Work out which channel the data is intended for from the mask bit position
+			// Channels can be anywhere in the lower 16 channels of the Xtreme format
+			for (j = 0; j < 16; j++)
+			{
+				// If there is a bit set, allocate channel data for it
+				if (chanmask16 & (1 << j))
+				{
+					// Reconstruct word
+					temp16 = (sBuffer[sindex] << 8) + sBuffer[sindex + 1];
+
+					// Expand to OpenAero2 units if a valid channel
+					if (j < MAX_RC_CHANNELS)
+					{
+						RxChannel[Config.ChannelOrder[j]] = ((temp16 * 10) >> 2);
+					} 		
+
+					// Within the bounds of the buffer
+					if (sindex < SBUFFER_SIZE)
+					{
+						sindex += 2;
+					}
+				}
+			} // For each mask bit	
+
+			// RC sync established
+			frame_done();
+		} // Checksum
+	} // Check end of data
+}
+
+//************************************************************
+//* Futaba S-Bus format (8-E-2/100Kbps) (2500us for a 25 byte packet)
+//*	S-Bus decoding algorithm borrowed in part from Arduino
+//*
+//* The protocol is 25 Bytes long and is sent every 14ms (analog mode) or 7ms (high speed mode).
+//* One Byte = 1 start bit + 8 data bit + 1 parity bit + 2 stop bit (8E2), baud rate = 100,000 bit/s
+//*
+//* The highest bit is sent first. The logic is inverted :( Stupid Futaba.
+//*
+//* [start byte] [data1] [data2] .... [data22] [flags][end byte]
+//* 
+//* 0 start byte = 11110000b (0xF0)
+//* 1-22 data = [ch1, 11bit][ch2, 11bit] .... [ch16, 11bit] (Values = 0 to 2047)
+//* 	channel 1 uses 8 bits from data1 and 3 bits from data2
+//* 	channel 2 uses last 5 bits from data2 and 6 bits from data3
+//* 	etc.
+//* 
+//* 23 flags = 
+//*		bit7 = ch17 = digital channel (0x80)
+//* 	bit6 = ch18 = digital channel (0x40)
+//* 	bit5 = Frame lost, equivalent red LED on receiver (0x20)
+//* 	bit4 = failsafe activated (0x10)
+//* 	bit3 = n/a
+//* 	bit2 = n/a
+//* 	bit1 = n/a
+//* 	bit0 = n/a
+//* 24 endbyte = 00000000b (SBUS) or (data % 0xCF) (SBUS2)
+//*
+//************************************************************
+
+// Unpack sixteen 11-bit channels into SerialChannel[]. S.Bus and CRSF pack them the same way.
+// Channel n starts at bit 11n of the data and spans two or three bytes.
+static void unpack_channels(const uint8_t *frame)
+{
+	uint16_t bit = 0;
+	uint16_t value;
+	uint8_t index, shift, ch;
+
+	for (ch = 0; ch < SERIAL_CHANNELS; ch++)
+	{
+		index = bit >> 3;
+		shift = bit & 7;
+
+		value = (frame[index] | ((uint16_t)frame[index + 1] << 8)) >> shift;
+
+		if (shift > 5)
+		{
+			value |= (uint16_t)frame[index + 2] << (16 - shift);
+		}
+
+		SerialChannel[ch] = value & 0x7FF;
+
+		bit += 11;
+	}
+}
+
+// Place the RC data into the correct channel order for the transmitted system
+static void publish_channels(void)
+{
+	uint8_t ch;
+
+	for (ch = 0; ch < MAX_RC_CHANNELS; ch++)
+	{
+		RxChannel[Config.ChannelOrder[ch]] = SerialChannel[ch];
+	}
+}
+
+// Unpack sixteen 11-bit channels and the flag byte.
+static void sbus_decode(void)
+{
+	int16_t itemp16;
+	uint8_t ch;
+
+	unpack_channels((const uint8_t *)&sBuffer[1]);
+
+	for (ch = 0; ch < SERIAL_CHANNELS; ch++)
+	{
+		// Subtract weird-ass Futaba offset
+		itemp16 = SerialChannel[ch] - 1024;
+
+		// Expand into OpenAero2 units. Quick multiply by 1.469 :)
+		itemp16 = itemp16 + (itemp16 >> 2) + (itemp16 >> 3) + (itemp16 >> 4) + (itemp16 >> 5);
+
+		// Add back in OpenAero2 offset
+		SerialChannel[ch] = itemp16 + 3750;
+	}
+
+	RxFlags = sBuffer[SBUS_FLAGS];
+
+	publish_channels();
+}
+
+static void sbus_byte(uint8_t temp)
+{
+	// Flag that packet has completed
+	if ((bytecount == 24) && ((temp == 0x00) || ((temp % 0xCF) == 0x04)))
+	{
+		// If frame lost, ignore packet
+		if ((sBuffer[SBUS_FLAGS] & (1 << RX_FRAMELOST)) == 0)
+		{
+			sbus_decode();
+
+			// RC sync established
+			frame_done();
+		}
+	}
+}
+
+//************************************************************
+//* Spektrum Satellite format (8-N-1/115Kbps) MSB sent first (1391us for a 16 byte packet)
+//* DX7/DX6i: One data-frame at 115200 baud every 22ms.
+//* DX7se:    One data-frame at 115200 baud every 11ms.
+//*
+//*    byte1: is a frame loss counter
+//*    byte2: [0 0 0 R 0 0 N1 N0]
+//*    byte3:  and byte4:  channel data (FLT-Mode)	= FLAP 6
+//*    byte5:  and byte6:  channel data (Roll)		= AILE A
+//*    byte7:  and byte8:  channel data (Pitch)		= ELEV E
+//*    byte9:  and byte10: channel data (Yaw)		= RUDD R
+//*    byte11: and byte12: channel data (Gear Switch) GEAR 5
+//*    byte13: and byte14: channel data (Throttle)	= THRO T
+//*    byte15: and byte16: channel data (AUX2)		= AUX2 8
+//* 
+//* DS9 (9 Channel): One data-frame at 115200 baud every 11ms,
+//* alternating frame 1/2 for CH1-7 / CH8-9
+//*
+//*   1st Frame:
+//*    byte1: is a frame loss counter
+//*    byte2: [0 0 0 R 0 0 N1 N0]
+//*    byte3:  and byte4:  channel data
+//*    byte5:  and byte6:  channel data
+//*    byte7:  and byte8:  channel data
+//*    byte9:  and byte10: channel data
+//*    byte11: and byte12: channel data
+//*    byte13: and byte14: channel data
+//*    byte15: and byte16: channel data
+//*   2nd Frame:
+//*    byte1: is a frame loss counter
+//*    byte2: [0 0 0 R 0 0 N1 N0]
+//*    byte3:  and byte4:  channel data
+//*    byte5:  and byte6:  channel data
+//*    byte7:  and byte8:  0xffff
+//*    byte9:  and byte10: 0xffff
+//*    byte11: and byte12: 0xffff
+//*    byte13: and byte14: 0xffff
+//*    byte15: and byte16: 0xffff
+//* 
+//* Each channel data (16 bit= 2byte, first msb, second lsb) is arranged as:
+//* 
+//* Bits: F 00 C3 C2 C1 C0  D9 D8 D7 D6 D5 D4 D3 D2 D1 D0 for 10-bit data (0 to 1023) or
+//* Bits: F C3 C2 C1 C0 D10 D9 D8 D7 D6 D5 D4 D3 D2 D1 D0 for 11-bit data (0 to 2047) 
+//* 
+//* R: 0 for 10 bit resolution 1 for 11 bit resolution channel data
+//* N1 to N0 is the number of frames required to receive all channel data. 
+//* F: 1 = indicates beginning of 2nd frame for CH8-9 (DS9 only)
+//* C3 to C0 is the channel number. 0 to 9 (4 bit, as assigned in the transmitter)
+//* D9 to D0 is the channel data 
+//*		(10 bit) 0xaa..0x200..0x356 for 100% transmitter-travel
+//*		(11 bit) 0x154..0x400..0x6ac for 100% transmitter-travel
+//*
+//* The data values can range from 0 to 1023/2047 to define a servo pulse width 
+//* from approximately 0.75ms to 2.25ms (1.50ms difference). 1.465us per digit.
+//* A value of 171/342 is 1.0 ms
+//* A value of 512/1024 is 1.5 ms
+//* A value of 853/1706 is 2.0 ms
+//* 0 = 750us, 1023/2047 = 2250us
+//*
+//************************************************************
+
+static void spektrum_byte(uint8_t temp)
+{
+	uint16_t temp16;
+	int16_t itemp16;
+	uint8_t sindex;
+	uint8_t chan_mask, chan_shift, data_mask;
+	uint8_t ch_num;
+	uint8_t j;
+
+	// Process data when all packets received
+	if (bytecount >= 15)
+	{
+		// Ahem... ah... just stick the last byte into the buffer manually...(hides)
+		sBuffer[15] = temp;
+
+		// Set start of channel data per format
+		sindex = 2; // Channel data from byte 3
+
+		// Work out if this is 10 or 11 bit data
+		if (sBuffer[1] & 0x10) 	// 0 for 10 bit resolution 1 for 11 bit resolution
+		{
+			chan_mask = 0x78;	// 11 bit (2048)
+			data_mask = 0x07;
+			chan_shift = 0x03;
+		}
+		else
+		{
+			chan_mask = 0x3C;	// 10 bit (1024)
+			data_mask = 0x03;
+			chan_shift = 0x02;
+		}
+
+		// Work out which channel the data is intended for from the channel number data
+		// Channels can also be in the second packet. Spektrum has 7 channels per packet.
+		for (j = 0; j < 7; j++)
+		{
+			// Extract channel number
+			ch_num = (sBuffer[sindex] & chan_mask) >> chan_shift;
+
+			// Reconstruct channel data
+			temp16 = ((sBuffer[sindex] & data_mask) << 8) + sBuffer[sindex + 1];
+
+			// Expand to OpenAero2 units if a valid channel
+			// Blank channels have the channel number of 16
+			if (ch_num < MAX_RC_CHANNELS)
+			{
+				// Subtract Spektrum center offset
+				if (chan_shift == 0x03) // 11-bit
+				{
+					itemp16 = temp16 - 1024;
+				}
+				else
+				{
+					itemp16 = temp16 - 512;	
+				}					
+
+				// Quick multiply by 2.93
+				itemp16 = (itemp16 << 1) + (itemp16 >> 1) + (itemp16 >> 2) + (itemp16 >> 3) + (itemp16 >> 4); 
+
+				if (chan_shift == 0x03) // 11-bit
+				{
+					// Divide in case of 11-bit value
+					itemp16 = itemp16 >> 1;								
+				}
+
+				// Add back in OpenAero2 offset
+				itemp16 += 3750;										
+
+				RxChannel[Config.ChannelOrder[ch_num]] = itemp16;
+			}
+
+			sindex += 2;
+
+		} // For each pair of bytes
+			
+		// RC sync established
+		frame_done();
+
+	} // Check end of data
+}
+
+//************************************************************
+//* TBS Crossfire/ExpressLRS CRSF format (8-N-1/420Kbps) (619us for a 26 byte packet)
+//* RC channels are sent at 50Hz to 500Hz (2ms to 20ms), 
+//* interleaved with link statistics and other telemetry frames.
+//* Frames can follow each other without a gap.
+//*
+//* [address] [length] [type] [payload] [crc]
+//*
+//* 0 address = 0xC8 for frames sent to the flight controller
+//* 1 length = bytes that follow, i.e. type + payload + crc (2 to 62)
+//* 2 type:
+//*		0x16 = RC channels. 22 bytes = [ch1, 11bit][ch2, 11bit] .... [ch16, 11bit]
+//*		       packed LSB first, exactly as S.Bus. 172 = 988us, 992 = 1500us, 1811 = 2012us
+//*		0x14 = Link statistics. 10 bytes = uplink RSSI 1, uplink RSSI 2, uplink LQ,
+//*		       uplink SNR, antenna, RF mode, TX power, downlink RSSI, LQ and SNR
+//* n crc = CRC8 (poly 0xD5) of the type and payload
+//*
+//************************************************************
+
+static void crsf_frame(void)
+{
+	int16_t itemp16;
+	uint8_t ch;
+	switch(sBuffer[2])
+	{
+		case CRSF_RC_CHANNELS:
+			if (sBuffer[1] != CRSF_RC_LENGTH) break;
+
+			unpack_channels((const uint8_t *)&sBuffer[CRSF_PAYLOAD]);
+
+			for (ch = 0; ch < SERIAL_CHANNELS; ch++)
+			{
+				// Subtract CRSF center offset
+				itemp16 = SerialChannel[ch] - 992;
+
+				// Expand into OpenAero2 units. Quick multiply by 1.5625
+				itemp16 = itemp16 + (itemp16 >> 1) + (itemp16 >> 4);
+
+				// Add back in OpenAero2 offset
+				SerialChannel[ch] = itemp16 + 3750;
+			}
+
+			publish_channels();
+
+			// RC sync established
+			frame_done();
+			break;
+
+		case CRSF_LINK_STATS:
+			if (sBuffer[1] != CRSF_STATS_LENGTH) break;
+
+			RxLinkQuality = sBuffer[CRSF_PAYLOAD + 2];
+
+			// No uplink packets are getting through
+			if (RxLinkQuality == 0)
+			{
+				RxFlags |= (1 << RX_FAILSAFE);
+			}
+			else
+			{
+				RxFlags &= ~(1 << RX_FAILSAFE);
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
+static void crsf_byte(uint8_t temp)
+{
+	// Frames we don't decode may be longer than sBuffer[]. Their CRC is still checked
+	if (bytecount < SBUFFER_SIZE)
+	{
+		sBuffer[bytecount] = temp;
+	}
+
+	bytecount++;
+
+	// Hunt for the start of a frame
+	if (bytecount == 1)
+	{
+		if (temp != CRSF_ADDRESS)
+		{
+			bytecount = 0;
+		}
+	}
+
+	// Frame length
+	else if (bytecount == 2)
+	{
+		if ((temp < CRSF_LENGTH_MIN) || (temp > CRSF_LENGTH_MAX))
+		{
+			bytecount = 0;
+		}
+
+		checksum = 0;
+	}
+
+	// Add type and payload to CRC
+	else if (bytecount < (uint8_t)(sBuffer[1] + 2))
+	{
+		checksum = pgm_read_byte(&crsf_crc_table[(uint8_t)checksum ^ temp]);
+	}
+
+	// Last byte is the CRC. Ignore frame if CRC wrong
+	else
+	{
+		if ((uint8_t)checksum == temp)
+		{
+			crsf_frame();
+		}
+
+		bytecount = 0;
+	}
+}
+
+// Feed one ring entry to the parser for the current RxMode
+void RxParseByte(uint16_t entry)
+{
+	uint8_t temp = (uint8_t)entry;
+
+	// CRSF frames can follow each other without a gap, so the parser finds
+	// its own frame boundaries. Lost bytes or a gap just restart the hunt.
+	if (Config.RxMode == CRSF)
+	{
+		if (entry & (RX_RING_LOST | RX_RING_START))
+		{
+			bytecount = 0;
+		}
+
+		crsf_byte(temp);
+		return;
+	}
+
+	// Bytes before this one were dropped, so the packet is incomplete
+	if (entry & RX_RING_LOST)
+	{
+		skip_packet = true;
+	}
+
+	// Handle start of new packet
+	if (entry & RX_RING_START)
+	{
+		// Reset variables
+		rcindex = 0;
+		bytecount = 0;
+		xtreme_channels = 0;
+		checksum = 0;
+		chanmask16 = 0;
+		skip_packet = false;
+	}
+
+	if (skip_packet)
+	{
+		return;
+	}
+
+	// Put received byte in buffer if space available
+	if (rcindex < SBUFFER_SIZE)
+	{
+		sBuffer[rcindex++] = temp;			
+	}
+
+	switch(Config.RxMode)
+	{
+		case XTREME:
+			xtreme_byte(temp);
+			break;
+
+		case SBUS:
+			sbus_byte(temp);
+			break;
+
+		case SPEKTRUM:
+			spektrum_byte(temp);
+			break;
+
+		default:
+			break;
+	}
+
+	// Increment byte count
+	bytecount++;
+}
+
+// Parse all the bytes received since the last call.
+// Sets Interrupted if a frame completed.
+void RxDecodeSerial(void)
+{
+	uint8_t tail = RxRingTail;
+	uint16_t entry;
+	uint32_t now = ticks_now();
+	bool stale = TICKS_EXPIRED(decode_ticks, now, STAMP_AGE_MAX);
+
+	decode_ticks = now;
+
+	while (tail != RxRingHead)
+	{
+		entry = RxRing[tail] | ((uint16_t)((RxRingFlags[tail >> 2] >> RX_FLAG_SHIFT(tail)) & RX_RING_FLAGS) << 8);
+
+		// TCNT1 stamps wrap at 26.2ms, so they are only used if the ring was drained recently
+		if (entry & RX_RING_START)
+		{
+			if (stale)
+			{
+				packet_known = false;
+			}
+			else
+			{
+				packet_stamp(tail);
+			}
+		}
+
+		RxParseByte(entry);
+		tail = (tail + 1) & (RX_RING_SIZE - 1);
+		RxRingTail = tail;
+	}
+}
+
+// Number of PWM pulses to output in FAST mode from the frame just decoded,
+// with RC interrupts blocked until the last one, when each takes pwm_interval.
+// After p pulses RC is back on p * pwm_interval after the end of this packet, 
+// so the next packet caught is the first one to start at least PACKET_MARGIN 
+// later. The burst cycle then spans a whole number of frame periods, and the
+// output rate is p / span. Choose the shortest span within 1/8 of the best rate,
+// as a longer span leaves the sticks unread for longer.
+uint8_t RxBurstPulses(uint32_t pwm_interval)
+{
+	uint32_t needed, span, best_span = 0;
+	uint32_t period = RxFramePeriod;
+	uint8_t pulses, best_pulses = 1;
+	uint8_t pass;
+
+	if (period == 0)
+	{
+		return 1;
+	}
+
+	for (pass = 0; pass < 2; pass++)
+	{
+		needed = pgm_read_word(&packet_time[Config.RxMode]) + PACKET_MARGIN;
+		span = 0;
+
+		for (pulses = 1; pulses <= BURST_PULSES_MAX; pulses++)
+		{
+			needed += pwm_interval;
+
+			while (span < needed)
+			{
+				span += period;
+			}
+
+			// One pulse is always possible
+			if ((pulses > 1) && (span > BURST_SPAN_MAX))
+			{
+				break;
+			}
+
+			if (pass == 0)
+			{
+				// Better rate than the best so far
+				if ((best_span == 0) || ((pulses * best_span) > (best_pulses * span)))
+				{
+					best_pulses = pulses;
+					best_span = span;
+				}
+			}
+			else
+			{
+				// Within 1/8 of the best rate
+				if ((8 * pulses * best_span) >= (7 * best_pulses * span))
+				{
+					return pulses;
+				}
+			}
+		}
+	}
+
+	return best_pulses;
+}
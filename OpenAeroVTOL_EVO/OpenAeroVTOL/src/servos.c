@@ -15,6 +15,7 @@
 #include "main.h"
 #include "isr.h"
 #include "rc.h"
+#include "twi_isr.h"
 
 //************************************************************
 // Prototypes
@@ -22,6 +23,7 @@
 
 void output_servo_ppm(uint8_t ServoFlag);
 void output_servo_ppm_asm(volatile uint16_t *ServoOut, uint8_t ServoFlag);
+void output_servo_isr(volatile uint16_t *ServoOut, uint8_t ServoFlag);
 
 //************************************************************
 // Code
@@ -80,6 +82,18 @@ void output_servo_ppm(uint8_t ServoFlag)
 	// Suppress outputs during throttle high error
 	if((General_error & (1 << THROTTLE_HIGH)) == 0)
 	{
+#ifdef SERVO_ISR
+		// Late edges in this frame will set JitterFlag
+		JitterFlag = false;
+
+		// Start the pulses. The Timer1 compare interrupt ends them
+		LOOP_STAGE(STAGE_OUTPUT_ASM);
+		output_servo_isr(&ServoOut[0], ServoFlag);
+		LOOP_STAGE(STAGE_OUTPUT);
+#else
+		// Let any sensor read finish so the TWI interrupt cannot stretch the pulses
+		twi_flush();
+
 		// Reset JitterFlag immediately before PWM generation
 		JitterFlag = false;
 	
@@ -87,9 +101,12 @@ void output_servo_ppm(uint8_t ServoFlag)
 		JitterGate = true;
 
 		// Pass address of ServoOut array
+		LOOP_STAGE(STAGE_OUTPUT_ASM);
 		output_servo_ppm_asm(&ServoOut[0], ServoFlag);
+		LOOP_STAGE(STAGE_OUTPUT);
 		
 		// We no longer care about interrupts
 		JitterGate = false;
+#endif
 	}
 }
@@ -0,0 +1,248 @@
+//***********************************************************
+//* servos_isr.c
+//*
+//* Interrupt-timed servo/ESC pulse generation.
+//* All the outputs for a frame rise together, then their
+//* falling edges are sorted and cleared in turn by the Timer1
+//* compare A interrupt. The CPU is free between edges, and
+//* an RC interrupt can only delay an edge, not corrupt it.
+//*
+//* Each edge is scheduled SERVO_LEAD ticks early and the
+//* interrupt spins out the rest, so edges are exact to one
+//* Timer1 tick (400ns) unless another interrupt is running.
+//* One interrupt clears at most SERVO_BURST ticks of edges, so
+//* the serial RX interrupt is never held off for a whole byte.
+//***********************************************************
+
+#include "compiledefs.h"
+
+#ifdef SERVO_ISR
+
+//***********************************************************
+//* Includes
+//***********************************************************
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <stdbool.h>
+#include "typedefs.h"
+#include "io_cfg.h"
+#include "isr.h"
+#include "ticks.h"
+
+//************************************************************
+// Prototypes
+//************************************************************
+
+void output_servo_isr(volatile uint16_t *ServoOut, uint8_t ServoFlag);
+void servo_isr_stop(void);
+
+//************************************************************
+// Defines
+//************************************************************
+
+#define SERVO_FRAME		8333		// Shortest time between frame starts in T1 ticks (3.33ms - 300Hz)
+#define SERVO_LEAD		8			// Compare interrupt runs this early and spins to the edge (3.2us)
+#define SERVO_SPIN		25			// Edges closer than this (10us) are done in the same interrupt
+#define SERVO_BURST		25			// ...as long as they are this close (10us) to the first one
+#define SERVO_REARM		8			// Least time before the compare interrupt runs again (3.2us)
+#define SERVO_LATE		5			// Edges later than this (2us) were held up by another interrupt
+#define SERVO_TIMEOUT	100			// Wait limit for the previous frame in system ticks (5.1ms)
+#define SERVO_PORTA		0x30		// M5, M6
+#define SERVO_PORTC		0xFC		// M1 to M4, M7, M8
+
+//************************************************************
+// Data
+//************************************************************
+
+// Output pin masks, M1 to M8
+const uint8_t ServoPortA[MAX_OUTPUTS] PROGMEM = {0x00, 0x00, 0x00, 0x00, 0x10, 0x20, 0x00, 0x00};
+const uint8_t ServoPortC[MAX_OUTPUTS] PROGMEM = {0x40, 0x10, 0x04, 0x08, 0x00, 0x00, 0x20, 0x80};
+
+static servo_edge_t Servo_edges[MAX_OUTPUTS];
+static volatile uint8_t Servo_index = 0;	// Next edge
+static volatile uint8_t Servo_count = 0;	// Edges in this frame
+static volatile bool Servo_busy = false;	// Frame in progress
+static uint16_t Servo_start;				// TCNT1 at the rising edges
+
+//************************************************************
+// Interrupt vectors
+//************************************************************
+
+ISR(TIMER1_COMPA_vect)
+{
+	servo_edge_t *edge;
+	uint16_t first, next;
+
+	// Frame period is over. Ready for the next frame
+	if (Servo_index >= Servo_count)
+	{
+		TIMSK1 &= ~(1 << OCIE1A);
+		Servo_busy = false;
+		return;
+	}
+
+	// Clear this edge and any that follow closely, up to SERVO_BURST
+	first = Servo_edges[Servo_index].time;
+
+	do
+	{
+		edge = &Servo_edges[Servo_index];
+
+		while ((int16_t)(TCNT1 - edge->time) < 0)
+		{
+			CPPM_CAPTURE();
+		}
+
+		PORTA &= (uint8_t)~edge->port_a;
+		PORTC &= (uint8_t)~edge->port_c;
+
+		if ((uint16_t)(TCNT1 - edge->time) > SERVO_LATE)
+		{
+			JitterFlag = true;
+		}
+
+		Servo_index++;
+	}
+	while ((Servo_index < Servo_count) &&
+		   ((int16_t)(Servo_edges[Servo_index].time - TCNT1) < SERVO_SPIN) &&
+		   ((uint16_t)(Servo_edges[Servo_index].time - first) < SERVO_BURST));
+
+	if (Servo_index < Servo_count)
+	{
+		next = Servo_edges[Servo_index].time - SERVO_LEAD;
+
+		// Leave a gap for a waiting RX interrupt, and don't set a time that has passed
+		if ((int16_t)(next - TCNT1) < SERVO_REARM)
+		{
+			next = TCNT1 + SERVO_REARM;
+		}
+
+		OCR1A = next;
+	}
+	else
+	{
+		// Hold off the next frame until SERVO_FRAME after this one started
+		OCR1A = Servo_start + SERVO_FRAME;
+	}
+
+	CPPM_CAPTURE();
+}
+
+//************************************************************
+// Code
+//************************************************************
+
+// Start a frame of pulses. ServoOut[] is in microseconds and
+// only the outputs whose ServoFlag bit is set are driven.
+// Waits for the previous frame period to finish first.
+void output_servo_isr(volatile uint16_t *ServoOut, uint8_t ServoFlag)
+{
+	servo_edge_t edges[MAX_OUTPUTS];
+	uint32_t wait_start;
+	uint16_t time;
+	uint8_t	port_a = 0;
+	uint8_t port_c = 0;
+	uint8_t mask_a, mask_c;
+	uint8_t count = 0;
+	uint8_t sreg;
+	uint8_t i, j, k;
+
+	// Sort the falling edges, merging outputs with equal widths
+	for (i = 0; i < MAX_OUTPUTS; i++)
+	{
+		if ((ServoFlag & (1 << i)) == 0)
+		{
+			continue;
+		}
+
+		time = (uint16_t)(ServoOut[i] * 5) >> 1;	// us to 400ns ticks
+		mask_a = pgm_read_byte(&ServoPortA[i]);
+		mask_c = pgm_read_byte(&ServoPortC[i]);
+
+		port_a |= mask_a;
+		port_c |= mask_c;
+
+		for (j = 0; (j < count) && (edges[j].time < time); j++);
+
+		if ((j < count) && (edges[j].time == time))
+		{
+			edges[j].port_a |= mask_a;
+			edges[j].port_c |= mask_c;
+			continue;
+		}
+
+		for (k = count; k > j; k--)
+		{
+			edges[k] = edges[k - 1];
+		}
+
+		edges[j].time = time;
+		edges[j].port_a = mask_a;
+		edges[j].port_c = mask_c;
+		count++;
+	}
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	// Wait for the previous frame period to end
+	wait_start = ticks_now();
+
+	while (Servo_busy)
+	{
+		if (TICKS_EXPIRED(wait_start, ticks_now(), SERVO_TIMEOUT))
+		{
+			servo_isr_stop();
+		}
+	}
+
+	sreg = SREG;
+	cli();
+
+	// Raise all the outputs together, then make the edge times absolute
+	Servo_start = TCNT1;
+	PORTA |= port_a;
+	PORTC |= port_c;
+
+	for (i = 0; i < count; i++)
+	{
+		Servo_edges[i].time = Servo_start + edges[i].time;
+		Servo_edges[i].port_a = edges[i].port_a;
+		Servo_edges[i].port_c = edges[i].port_c;
+	}
+
+	Servo_index = 0;
+	Servo_count = count;
+	Servo_busy = true;
+
+	OCR1A = Servo_edges[0].time - SERVO_LEAD;
+	TIFR1 = (1 << OCF1A);
+	TIMSK1 |= (1 << OCIE1A);
+
+	CPPM_CAPTURE();
+	SREG = sreg;
+}
+
+// Abandon any frame in progress and drive all outputs low
+void servo_isr_stop(void)
+{
+	uint8_t sreg = SREG;
+
+	cli();
+
+	TIMSK1 &= ~(1 << OCIE1A);
+	PORTA &= (uint8_t)~SERVO_PORTA;
+	PORTC &= (uint8_t)~SERVO_PORTC;
+
+	Servo_index = 0;
+	Servo_count = 0;
+	Servo_busy = false;
+
+	SREG = sreg;
+}
+
+#endif // SERVO_ISR
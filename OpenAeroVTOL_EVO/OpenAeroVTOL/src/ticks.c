@@ -0,0 +1,72 @@
+//***********************************************************
+//* ticks.c
+//*
+//* Monotonic 32-bit system tick.
+//* Timer2 runs at 19.531kHz (51.2us) and its overflow
+//* interrupt counts the high 24 bits, so the tick count
+//* wraps after about 61 hours. Elapsed times are always
+//* taken as (now - start), which stays correct across the wrap.
+//***********************************************************
+
+//***********************************************************
+//* Includes
+//***********************************************************
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stdbool.h>
+#include "isr.h"
+
+//************************************************************
+// Prototypes
+//************************************************************
+
+uint32_t ticks_now(void);
+
+//************************************************************
+// Data
+//************************************************************
+
+volatile uint32_t T2_overflows;		// Number of times Timer2 has overflowed
+
+//************************************************************
+// Interrupt vectors
+//************************************************************
+
+ISR(TIMER2_OVF_vect)
+{
+	// Log interrupts that occur during PWM generation
+	if (JitterGate)	JitterFlag = true;
+
+	T2_overflows++;
+
+	// Stamp any CPPM edge that arrived while in here
+	CPPM_CAPTURE();
+}
+
+//************************************************************
+// Code
+//************************************************************
+
+// Current tick count. Safe to call with interrupts enabled or disabled.
+uint32_t ticks_now(void)
+{
+	uint32_t overflows;
+	uint8_t count;
+	uint8_t	sreg = SREG;
+
+	cli();
+	overflows = T2_overflows;
+	count = TCNT2;
+
+	// An overflow that has happened but not yet been serviced
+	// belongs to this count unless TCNT2 was read before it
+	if ((TIFR2 & (1 << TOV2)) && (count < 255))
+	{
+		overflows++;
+	}
+
+	SREG = sreg;
+
+	return (overflows << 8) | count;
+}
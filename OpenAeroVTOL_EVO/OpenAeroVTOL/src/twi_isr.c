@@ -0,0 +1,327 @@
+//***********************************************************
+//* twi_isr.c
+//*
+//* Interrupt-driven TWI master.
+//* Register reads and writes are queued and then run by the
+//* TWI interrupt, one bus event at a time. The caller gets a
+//* status byte that turns from TWI_PENDING to TWI_DONE or
+//* TWI_ERROR, so it can do other work while the bytes move.
+//*
+//* Every wait is limited by TWI_TIMEOUT. A stuck transfer
+//* or bus is reset by twi_recover() instead of hanging.
+//***********************************************************
+
+//***********************************************************
+//* Includes
+//***********************************************************
+
+#include "compiledefs.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/delay.h>
+#include <compat/twi.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "io_cfg.h"
+#include "i2cmaster.h"
+#include "isr.h"
+#include "ticks.h"
+
+//************************************************************
+// Prototypes
+//************************************************************
+
+bool twi_read(uint8_t address, uint8_t location, uint8_t *data, uint8_t size, volatile uint8_t *status);
+bool twi_write(uint8_t address, uint8_t location, uint8_t *data, uint8_t size, volatile uint8_t *status);
+bool twi_wait(volatile uint8_t *status);
+void twi_flush(void);
+void twi_recover(void);
+
+//************************************************************
+// Defines
+//************************************************************
+
+#define TWI_QUEUE		4			// Request queue length. Must be a power of 2
+#define TWI_TIMEOUT		60			// Wait limit in system ticks (3.1ms). A 14-byte read takes 0.45ms
+#define TWI_RETRIES		16			// Start attempts while the device NACKs its address
+#define TWI_READ_FLAG	0x80		// Request direction, held in twi_request_t.flags
+#define TWI_SCL			0			// PC0
+#define TWI_RECOVERY	9			// SCL pulses to free a slave holding SDA low
+
+// TWCR settings
+#define TWCR_START		((1 << TWINT) | (1 << TWSTA) | (1 << TWEN) | (1 << TWIE))
+#define TWCR_NEXT		((1 << TWINT) | (1 << TWEN) | (1 << TWIE))
+#define TWCR_ACK		((1 << TWINT) | (1 << TWEN) | (1 << TWIE) | (1 << TWEA))
+#define TWCR_STOP		((1 << TWINT) | (1 << TWEN) | (1 << TWSTO))
+#define TWCR_RESTART	((1 << TWINT) | (1 << TWSTA) | (1 << TWSTO) | (1 << TWEN) | (1 << TWIE))
+
+//************************************************************
+// Data
+//************************************************************
+
+static twi_request_t TWI_queue[TWI_QUEUE];
+static volatile uint8_t TWI_head = 0;		// Request on the bus
+static volatile uint8_t TWI_tail = 0;		// Next free slot
+static volatile bool TWI_busy = false;		// Bus transaction in progress
+static uint8_t TWI_index;					// Current data byte
+static uint8_t TWI_tries;					// Start attempts for the current request
+
+volatile uint8_t TWI_errors = 0;			// Failed transfers, saturates at 255
+
+//************************************************************
+// Code
+//************************************************************
+
+// Finish the request at the head of the queue and start the next one, if any.
+// A STOP followed by a START is issued as a single TWCR write.
+static void twi_complete(uint8_t result)
+{
+	twi_request_t *req = &TWI_queue[TWI_head];
+
+	*req->status = result;
+
+	if ((result == TWI_ERROR) && (TWI_errors < 255))
+	{
+		TWI_errors++;
+	}
+
+	TWI_head = (TWI_head + 1) & (TWI_QUEUE - 1);
+	TWI_tries = 0;
+
+	if (TWI_head != TWI_tail)
+	{
+		TWCR = TWCR_RESTART;
+	}
+	else
+	{
+		TWCR = TWCR_STOP;
+		TWI_busy = false;
+	}
+}
+
+// Advance the transaction at the head of the queue by one bus event.
+// Writes send the register address and then the data.
+// Reads send the register address, then a repeated start in read mode.
+static void twi_service(void)
+{
+	twi_request_t *req = &TWI_queue[TWI_head];
+
+	switch(TW_STATUS)
+	{
+		case TW_START:
+			TWDR = req->address + I2C_WRITE;
+			TWCR = TWCR_NEXT;
+			break;
+
+		case TW_REP_START:
+			TWDR = req->address + I2C_READ;
+			TWCR = TWCR_NEXT;
+			break;
+
+		case TW_MT_SLA_ACK:
+			TWI_index = 0;
+			TWDR = req->location;
+			TWCR = TWCR_NEXT;
+			break;
+
+		case TW_MT_DATA_ACK:
+			if (req->flags & TWI_READ_FLAG)
+			{
+				TWCR = TWCR_START;				// Repeated start to read
+			}
+			else if (TWI_index < req->size)
+			{
+				TWDR = req->data[TWI_index++];
+				TWCR = TWCR_NEXT;
+			}
+			else
+			{
+				twi_complete(TWI_DONE);
+			}
+			break;
+
+		case TW_MR_SLA_ACK:
+			// NACK the last byte
+			TWCR = (req->size > 1) ? TWCR_ACK : TWCR_NEXT;
+			break;
+
+		case TW_MR_DATA_ACK:
+			req->data[TWI_index++] = TWDR;
+			TWCR = (TWI_index < (req->size - 1)) ? TWCR_ACK : TWCR_NEXT;
+			break;
+
+		case TW_MR_DATA_NACK:
+			req->data[TWI_index] = TWDR;
+			twi_complete(TWI_DONE);
+			break;
+
+		// Device busy. Ack polling as in i2c_start_wait(), but limited
+		case TW_MT_SLA_NACK:
+		case TW_MR_SLA_NACK:
+			if (++TWI_tries < TWI_RETRIES)
+			{
+				TWCR = TWCR_RESTART;
+			}
+			else
+			{
+				twi_complete(TWI_ERROR);
+			}
+			break;
+
+		// Lost the bus. Start again when it is free
+		case TW_MT_ARB_LOST:
+			if (++TWI_tries < TWI_RETRIES)
+			{
+				TWCR = TWCR_START;
+			}
+			else
+			{
+				twi_complete(TWI_ERROR);
+			}
+			break;
+
+		// Data NACK, bus error or anything unexpected
+		default:
+			twi_complete(TWI_ERROR);
+			break;
+	}
+}
+
+ISR(TWI_vect)
+{
+	// Log interrupts that occur during PWM generation
+	if (JitterGate)	JitterFlag = true;
+
+	twi_service();
+
+	// Stamp any CPPM edge that arrived while in here
+	CPPM_CAPTURE();
+}
+
+// Add a request to the queue and start the bus if it is idle.
+// Returns false if the queue is full.
+static bool twi_queue(uint8_t address, uint8_t location, uint8_t *data, uint8_t size, uint8_t flags, volatile uint8_t *status)
+{
+	twi_request_t *req;
+	uint8_t sreg;
+	uint8_t next;
+	uint8_t i;
+
+	sreg = SREG;
+	cli();
+
+	next = (TWI_tail + 1) & (TWI_QUEUE - 1);
+
+	if (next == TWI_head)
+	{
+		SREG = sreg;
+		return false;
+	}
+
+	req = &TWI_queue[TWI_tail];
+	req->address = address;
+	req->location = location;
+	req->data = data;
+	req->size = size;
+	req->flags = flags;
+	req->status = status;
+	*status = TWI_PENDING;
+
+	TWI_tail = next;
+
+	if (!TWI_busy)
+	{
+		// Let the last STOP finish
+		for (i = 0; (TWCR & (1 << TWSTO)) && (i < 255); i++);
+
+		TWI_busy = true;
+		TWI_tries = 0;
+		TWCR = TWCR_START;
+	}
+
+	SREG = sreg;
+	return true;
+}
+
+// Read size bytes from consecutive registers starting at location
+bool twi_read(uint8_t address, uint8_t location, uint8_t *data, uint8_t size, volatile uint8_t *status)
+{
+	return twi_queue(address, location, data, size, TWI_READ_FLAG, status);
+}
+
+// Write size bytes to consecutive registers starting at location
+bool twi_write(uint8_t address, uint8_t location, uint8_t *data, uint8_t size, volatile uint8_t *status)
+{
+	return twi_queue(address, location, data, size, 0, status);
+}
+
+// Wait until a request has finished, or for all requests if status is NULL.
+// Returns true if it completed without error.
+// With interrupts disabled (during init) the TWINT flag is polled instead.
+bool twi_wait(volatile uint8_t *status)
+{
+	uint32_t start = ticks_now();
+
+	while ((status != NULL) ? (*status == TWI_PENDING) : TWI_busy)
+	{
+		if (!(SREG & (1 << SREG_I)) && (TWCR & (1 << TWINT)))
+		{
+			twi_service();
+		}
+
+		if (TICKS_EXPIRED(start, ticks_now(), TWI_TIMEOUT))
+		{
+			twi_recover();
+			break;
+		}
+	}
+
+	return (status == NULL) || (*status == TWI_DONE);
+}
+
+// Let any queued transfers finish
+void twi_flush(void)
+{
+	twi_wait(NULL);
+}
+
+// Reset the TWI and the bus after a timeout.
+// The TWI is switched off and SCL is clocked by hand so that a slave 
+// left half-way through a byte releases SDA. All queued requests fail.
+void twi_recover(void)
+{
+	uint8_t i;
+	uint8_t sreg;
+
+	sreg = SREG;
+	cli();
+
+	TWCR = 0;								// Release SCL and SDA
+	PORTC &= ~(1 << TWI_SCL);
+
+	for (i = 0; i < TWI_RECOVERY; i++)
+	{
+		DDRC |= (1 << TWI_SCL);				// SCL low
+		_delay_us(5);
+		DDRC &= ~(1 << TWI_SCL);			// SCL released (pulled up)
+		_delay_us(5);
+	}
+
+	// Fail everything that was queued
+	while (TWI_head != TWI_tail)
+	{
+		*TWI_queue[TWI_head].status = TWI_ERROR;
+		TWI_head = (TWI_head + 1) & (TWI_QUEUE - 1);
+	}
+
+	if (TWI_errors < 255)
+	{
+		TWI_errors++;
+	}
+
+	TWI_busy = false;
+	TWI_tries = 0;
+	TWCR = (1 << TWEN);						// Bus free, TWI idle
+
+	SREG = sreg;
+}
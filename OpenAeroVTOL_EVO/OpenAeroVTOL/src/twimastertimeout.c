@@ -30,6 +30,9 @@
 /* I2C timer max delay */
 #define I2C_TIMER_DELAY 0xFF
 
+/* Start attempts in i2c_start_wait() before giving up */
+#define I2C_START_RETRIES 16
+
 /*************************************************************************
  Initialization of the I2C bus interface. Need to be called only once
 *************************************************************************/
@@ -87,6 +90,7 @@ unsigned char i2c_start(unsigned char address)
 /*************************************************************************
  Issues a start condition and sends address and transfer direction.
  If device is busy, use ack polling to wait until device is ready
+ Gives up after I2C_START_RETRIES attempts rather than hang on a dead bus
  
  Input:   address and transfer direction of I2C device
 *************************************************************************/
@@ -94,8 +98,9 @@ void i2c_start_wait(unsigned char address)
 {
 	uint32_t  i2c_timer = 0;
 	uint8_t   twst;
+	uint8_t   retries = I2C_START_RETRIES;
 
-    while ( 1 )
+    while ( retries-- )
     {
 	    // send START condition
 	    TWCR = (1<<TWINT) | (1<<TWSTA) | (1<<TWEN);
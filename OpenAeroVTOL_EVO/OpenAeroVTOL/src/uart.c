@@ -12,6 +12,7 @@
 #include <stdlib.h>
 #include <util/delay.h>
 #include "io_cfg.h"
+#include "serial_rx.h"
 
 //************************************************************
 // Prototypes
@@ -35,6 +36,9 @@ void init_uart(void);
 #define USART_BAUDRATE_SPEKTRUM 115200
 #define BAUD_PRESCALE_SPEKTRUM ((F_CPU + USART_BAUDRATE_SPEKTRUM * 8L) / (USART_BAUDRATE_SPEKTRUM * 16L) - 1) // Default RX rate for Spektrum
 
+#define USART_BAUDRATE_CRSF 420000
+#define BAUD_PRESCALE_CRSF ((F_CPU + USART_BAUDRATE_CRSF * 4L) / (USART_BAUDRATE_CRSF * 8L) - 1) // Default RX rate for CRSF
+
 // Initialise UART with adjusted bitrate
 void init_uart(void)
 {
@@ -52,6 +56,9 @@ void init_uart(void)
 	UCSR0B = 0; // Clear flags, disable tx/rx, 8 bits
 	UCSR0C = 6; // 8N1
 
+	// A new receiver has not reported failsafe yet
+	RxFlags = 0;
+
 	switch (Config.RxMode)
 	{
 		// Xtreme 8N1 (8 data bits / No parity / 1 stop bit / 250Kbps)
@@ -90,6 +97,18 @@ void init_uart(void)
 			UCSR0B |=  (1 << RXCIE0);					// Enable serial interrupt
 			break;
 
+		// CRSF 8N1 (8 data bits / No parity / 1 stop bit / 420Kbps)
+		case CRSF:
+			UCSR0A |=  (1 << U2X0);						// Need to set the 2x flag
+			UBRR0H  = (BAUD_PRESCALE_CRSF >> 8);  		// Actual = 416667, Error = -0.79%
+			UBRR0L  =  BAUD_PRESCALE_CRSF & 0xff;		// 0x05
+			UCSR0B |=  (1 << RXEN0);					// Enable receiver
+			UCSR0C &= ~(1 << USBS0); 					// 1 stop bit
+			UCSR0C &=  ~(1 << UPM00) | 					// No parity
+						(1 << UPM01);
+			UCSR0B |=  (1 << RXCIE0);					// Enable serial interrupt
+			break;
+
 		case CPPM_MODE:
 		case PWM:
 			UCSR0B &= 	~(1 << RXEN0);					// Disable receiver in PWM and CPPM modes